@@ -19,10 +19,9 @@
 //
 Bigraph::Bigraph() : m_hasContainment(false), m_hasTransitive(false), m_isExactMode(false), m_minOverlap(0), m_errorRate(0.0f)
 {
-  //JEREMIAH
     // Set up the memory pools for the graph
-    //m_pEdgeAllocator = new SimpleAllocator<Edge>();
-    //m_pVertexAllocator = new SimpleAllocator<Vertex>();
+    m_pEdgeAllocator = new SimpleAllocator<Edge>();
+    m_pVertexAllocator = new SimpleAllocator<Vertex>();
 
     //m_vertices.set_deleted_key(""); // JEREMIAH
     //WARN_ONCE("HARDCODED HASH TABLE MAX SIZE");
@@ -34,17 +33,19 @@ Bigraph::Bigraph() : m_hasContainment(false), m_hasTransitive(false), m_isExactM
 //
 Bigraph::~Bigraph()
 {
+    // The vertices own heap memory for their sequence and edge list,
+    // so run their destructors. The edges are plain data and are
+    // released with their pool
     VertexPtrMap::iterator iter = m_vertices.begin(); 
     for(; iter != m_vertices.end(); ++iter)
     {
-        delete iter->second;
+        iter->second->~Vertex();
         iter->second = NULL;
     }
 
-    //JEREMIAH
     // Clean up the memory pools
-    //delete m_pEdgeAllocator;
-    //delete m_pVertexAllocator;
+    delete m_pEdgeAllocator;
+    delete m_pVertexAllocator;
 }
 
 //
@@ -293,39 +294,37 @@ void Bigraph::simplify(EdgeDir dir)
         VertexPtrMapIter iter = m_vertices.begin(); 
         while(iter != m_vertices.end())
         {
-
-
-
-            // Get the edges for this direction
-            EdgePtrVec edges = iter->second->getEdges(dir);
-
-	    //std::cout << "--VERTEX: dir " << dir << " " << iter->first << " seq len " << iter->second->getSeqLen() << " eges size " << edges.size() << std::endl;
-
-	    // for (auto& i : edges)
-	    // std::cerr << "    EDGE: " << i->getStartID() << " " << i->getEndID()<< std::endl;
-
-            // If there is a single edge in this direction, merge the vertices
-            // Don't merge singular self edges though
-            if(edges.size() == 1 && !edges.front()->isSelf())
-            {
-                // Check that the edge back is singular as well
-                Edge* pSingle = edges.front();
-                Edge* pTwin = pSingle->getTwin();
-                Vertex* pV2 = pSingle->getEnd();
-		//std::cerr << "...edge back edge counts " << pV2->countEdges(pTwin->getDir()) << std::endl;
-                if(pV2->countEdges(pTwin->getDir()) == 1)
-                {
-		  //std::cerr << "merging " << std::endl;
-                    merge(iter->second, pSingle);
-                    graph_changed = true;
-                }
-            }
-
+            if(mergeUnbranched(iter->second, dir))
+                graph_changed = true;
             ++iter;
         }
     } 
 }
 
+//
+bool Bigraph::mergeUnbranched(Vertex* pVertex, EdgeDir dir, const Vertex** ppMerged)
+{
+    // Get the edges for this direction
+    EdgePtrVec edges = pVertex->getEdges(dir);
+
+    // If there is a single edge in this direction, merge the vertices
+    // Don't merge singular self edges though
+    if(edges.size() != 1 || edges.front()->isSelf())
+        return false;
+
+    // Check that the edge back is singular as well
+    Edge* pSingle = edges.front();
+    Edge* pTwin = pSingle->getTwin();
+    Vertex* pV2 = pSingle->getEnd();
+    if(pV2->countEdges(pTwin->getDir()) != 1)
+        return false;
+
+    if(ppMerged != NULL)
+        *ppMerged = pV2;
+    merge(pVertex, pSingle);
+    return true;
+}
+
 //
 // Rename the vertices to have a sequential idx
 // starting with prefix. This requires extra memory
@@ -86,6 +86,12 @@ class Bigraph
         // Simplify the graph by removing transitive edges
         void simplify();
 
+        // Merge pVertex with its neighbour in direction dir if the edge between
+        // them is the only one in that direction for both. Returns true if the
+        // vertices were merged, setting ppMerged to the neighbour, which has been
+        // deleted and can only be used as a key
+        bool mergeUnbranched(Vertex* pVertex, EdgeDir dir, const Vertex** ppMerged = NULL);
+
         // Validate that the graph is sane
         void validate();
 
@@ -136,17 +136,20 @@ class Edge
         void flip() { flipComp(); flipDir(); }
 
         // Memory management
-        //void* operator new(size_t /*size*/, SimpleAllocator<Edge>* pAllocator)
-        //{
-        //    return pAllocator->alloc();
-        //}
+        void* operator new(size_t /*size*/, SimpleAllocator<Edge>* pAllocator)
+        {
+            return pAllocator->alloc();
+        }
+
+        // Only called if the constructor throws
+        void operator delete(void* /*target*/, SimpleAllocator<Edge>* /*pAllocator*/) {}
 
-        //void operator delete(void* /*target*/, size_t /*size*/)
-        //{
+        void operator delete(void* /*target*/, size_t /*size*/)
+        {
             // Deletions are handled at the graph/pool level. The lifetime of an edge
             // is as long as the graph it belongs to, even if it is deleted before
             // the graph.
-        //}
+        }
 
         // Validate that the edge is sane
         void validate() const;
@@ -158,7 +161,7 @@ class Edge
         
         // Global new is not allowed, allocation must go through the memory pool
         // belonging to the graph.
-        //void* operator new(size_t size) { return malloc(size); } 
+        void* operator new(size_t size) { return malloc(size); } 
         
         Edge() {}; // Default constructor is not allowed
 
@@ -138,17 +138,20 @@ class Vertex
         uint16_t getCoverage() const { return m_coverage; }
 
         // Memory management
-        //void* operator new(size_t /*size*/, SimpleAllocator<Vertex>* pAllocator)
-        //{
-        //    return pAllocator->alloc();
-        //}
+        void* operator new(size_t /*size*/, SimpleAllocator<Vertex>* pAllocator)
+        {
+            return pAllocator->alloc();
+        }
+
+        // Only called if the constructor throws
+        void operator delete(void* /*target*/, SimpleAllocator<Vertex>* /*pAllocator*/) {}
 
-        //void operator delete(void* /*target*/, size_t /*size*/)
-        //{
+        void operator delete(void* /*target*/, size_t /*size*/)
+        {
             // delete does nothing since all allocations go through the memory pool
             // belonging to the graph. The memory allocated for the vertex will be
             // cleaned up when the graph is destroyed.
-        //}
+        }
 
         // Output edges in graphviz format
         void writeEdges(std::ostream& out, int dotFlags) const;
@@ -156,10 +159,10 @@ class Vertex
     private:
 
         // Global new is disallowed, all allocations must go through the pool
-        /*void* operator new(size_t size)
+        void* operator new(size_t size)
         {
             return malloc(size);
-	    }*/
+        }
 
         // Ensure all the edges in DIR are unique
         bool markDuplicateEdges(EdgeDir dir, GraphColor dupColor);
@@ -8,13 +8,16 @@
 // a breadth-first search of a bidirectional graph. It is designed
 // to return all possible walks between the given start
 // and end vertices, up to a given distance. Used to search a
-// string graph or scaffold graph.
+// string graph or scaffold graph. If an SGAdjacency snapshot of
+// the graph is given, children are created from its edge ranges
+// instead of copying each vertex's edge list.
 //
 #ifndef GRAPHSEARCHTREE_H
 #define GRAPHSEARCHTREE_H
 
 #include "Bigraph.h"
 #include "SGWalk.h"
+#include "SGAdjacency.h"
 #include <deque>
 #include <queue>
 
@@ -27,7 +30,8 @@ class GraphSearchNode
         typedef std::vector<EDGE*> _EDGEPtrVector;
 
     public:
-        GraphSearchNode(VERTEX* pVertex, EdgeDir expandDir, GraphSearchNode* pParent, EDGE* pEdgeFromParent, int distance);
+        GraphSearchNode(VERTEX* pVertex, EdgeDir expandDir, GraphSearchNode* pParent, EDGE* pEdgeFromParent, int distance,
+                        uint32_t adjIdx = SGAdjacency::NO_INDEX);
         ~GraphSearchNode();
 
         // Reduce the child count by 1
@@ -35,7 +39,7 @@ class GraphSearchNode
 
         // Create the children of this node and place pointers to their nodes
         // on the queue. Returns the number of children created;
-        int createChildren(GraphSearchNodePtrDeque& outQueue, const DISTANCE& distanceFunc);
+        int createChildren(GraphSearchNodePtrDeque& outQueue, const DISTANCE& distanceFunc, const SGAdjacency* pAdjacency);
 
         GraphSearchNode* getParent() const { return m_pParent; }
         VERTEX* getVertex() const { return m_pVertex; }
@@ -53,6 +57,9 @@ class GraphSearchNode
 
         int m_numChildren;
         int64_t m_distance;
+
+        // index of the vertex in the adjacency snapshot, if any
+        uint32_t m_adjIdx;
 };
 
 template<typename VERTEX, typename EDGE, typename DISTANCE>
@@ -74,7 +81,8 @@ class GraphSearchTree
                      VERTEX* pEndVertex,
                      EdgeDir searchDir,
                      int64_t distanceLimit,
-                     size_t nodeLimit);
+                     size_t nodeLimit,
+                     const SGAdjacency* pAdjacency = NULL);
 
         ~GraphSearchTree();
 
@@ -153,6 +161,9 @@ class GraphSearchTree
 
         // Distance functor
         DISTANCE m_distanceFunc;
+
+        // Optional edge snapshot of the graph
+        const SGAdjacency* m_pAdjacency;
 };
 
 //
@@ -161,11 +172,13 @@ GraphSearchNode<VERTEX,EDGE,DISTANCE>::GraphSearchNode(VERTEX* pVertex,
                            EdgeDir expandDir,
                            GraphSearchNode<VERTEX,EDGE,DISTANCE>* pParent,
                            EDGE* pEdgeFromParent,
-                           int distance) : m_pVertex(pVertex),
+                           int distance,
+                           uint32_t adjIdx) : m_pVertex(pVertex),
                                                     m_expandDir(expandDir),
                                                     m_pParent(pParent), 
                                                     m_pEdgeFromParent(pEdgeFromParent),
-                                                    m_numChildren(0)
+                                                    m_numChildren(0),
+                                                    m_adjIdx(adjIdx)
 {
     // Set the extension distance
     if(m_pParent == NULL)
@@ -203,10 +216,24 @@ void GraphSearchNode<VERTEX,EDGE,DISTANCE>::decrementChildren()
 // and place pointers to them in the queue.
 // Returns the number of nodes created
 template<typename VERTEX, typename EDGE, typename DISTANCE>
-int GraphSearchNode<VERTEX,EDGE,DISTANCE>::createChildren(GraphSearchNodePtrDeque& outDeque, const DISTANCE& distanceFunc)
+int GraphSearchNode<VERTEX,EDGE,DISTANCE>::createChildren(GraphSearchNodePtrDeque& outDeque, const DISTANCE& distanceFunc,
+                                                          const SGAdjacency* pAdjacency)
 {
     assert(m_numChildren == 0);
 
+    if(pAdjacency != NULL && m_adjIdx != SGAdjacency::NO_INDEX)
+    {
+        const SGAdjEntry* pLast = pAdjacency->end(m_adjIdx, m_expandDir);
+        for(const SGAdjEntry* pEntry = pAdjacency->begin(m_adjIdx, m_expandDir); pEntry != pLast; ++pEntry)
+        {
+            GraphSearchNode* pNode = new GraphSearchNode(pEntry->pEnd, pEntry->expandDir, this, pEntry->pEdge,
+                                                         distanceFunc(pEntry->pEdge), pEntry->endIdx);
+            outDeque.push_back(pNode);
+            m_numChildren += 1;
+        }
+        return m_numChildren;
+    }
+
     _EDGEPtrVector edges = m_pVertex->getEdges(m_expandDir);
 
     for(size_t i = 0; i < edges.size(); ++i)
@@ -227,13 +254,16 @@ GraphSearchTree<VERTEX,EDGE,DISTANCE>::GraphSearchTree(VERTEX* pStartVertex,
                                                        VERTEX* pEndVertex, 
                                                        EdgeDir searchDir,
                                                        int64_t distanceLimit,
-                                                       size_t nodeLimit) : m_pGoalVertex(pEndVertex),
+                                                       size_t nodeLimit,
+                                                       const SGAdjacency* pAdjacency) : m_pGoalVertex(pEndVertex),
                                                                            m_distanceLimit(distanceLimit),
                                                                            m_nodeLimit(nodeLimit),
-                                                                           m_searchAborted(false)
+                                                                           m_searchAborted(false),
+                                                                           m_pAdjacency(pAdjacency)
 {
     // Create the root node of the search tree
-    m_pRootNode = new GraphSearchNode<VERTEX, EDGE, DISTANCE>(pStartVertex, searchDir, NULL, NULL, 0);
+    uint32_t rootIdx = m_pAdjacency != NULL ? m_pAdjacency->getIndex(pStartVertex) : SGAdjacency::NO_INDEX;
+    m_pRootNode = new GraphSearchNode<VERTEX, EDGE, DISTANCE>(pStartVertex, searchDir, NULL, NULL, 0, rootIdx);
 
     // add the root to the expand queue
     m_expandQueue.push_back(m_pRootNode);
@@ -319,7 +349,7 @@ bool GraphSearchTree<VERTEX,EDGE,DISTANCE>::stepOnce()
         else
         {
             // Add the children of this node to the queue
-            int numCreated = pNode->createChildren(incomingQueue, m_distanceFunc);
+            int numCreated = pNode->createChildren(incomingQueue, m_distanceFunc, m_pAdjacency);
             m_totalNodes += numCreated;
 
             if(numCreated == 0)
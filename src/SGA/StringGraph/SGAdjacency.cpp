@@ -0,0 +1,57 @@
+//-----------------------------------------------
+// Released under the GPL
+//-----------------------------------------------
+//
+// SGAdjacency - Read-only CSR snapshot of a string graph
+//
+#include "SGAdjacency.h"
+
+void SGAdjacency::build(const Bigraph* pGraph)
+{
+    build(pGraph->getAllVertices());
+}
+
+void SGAdjacency::build(const VertexPtrVec& vertices)
+{
+    clear();
+    m_vertices = vertices;
+
+    size_t n = m_vertices.size();
+    m_index.reserve(n);
+    for(size_t i = 0; i < n; ++i)
+        m_index[m_vertices[i]] = i;
+
+    m_offsets.resize(2 * n + 1);
+    for(size_t i = 0; i < n; ++i)
+    {
+        // one pass per direction keeps the order of getEdges(dir)
+        EdgePtrVec edges = m_vertices[i]->getEdges();
+        for(size_t d = 0; d < ED_COUNT; ++d)
+        {
+            m_offsets[2 * i + d] = m_entries.size();
+            for(size_t j = 0; j < edges.size(); ++j)
+            {
+                Edge* pEdge = edges[j];
+                if(pEdge->getDir() != EDGE_DIRECTIONS[d])
+                    continue;
+
+                SGAdjEntry entry;
+                entry.pEnd = pEdge->getEnd();
+                entry.pEdge = pEdge;
+                entry.endIdx = getIndex(entry.pEnd);
+                assert(entry.endIdx != NO_INDEX);
+                entry.expandDir = !pEdge->getTwin()->getDir();
+                m_entries.push_back(entry);
+            }
+        }
+    }
+    m_offsets[2 * n] = m_entries.size();
+}
+
+void SGAdjacency::clear()
+{
+    m_vertices.clear();
+    m_index.clear();
+    m_offsets.clear();
+    m_entries.clear();
+}
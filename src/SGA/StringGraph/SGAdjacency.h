@@ -0,0 +1,78 @@
+//-----------------------------------------------
+// Released under the GPL
+//-----------------------------------------------
+//
+// SGAdjacency - Read-only snapshot of the edges of a string
+// graph in compressed sparse row form. The edges of each vertex
+// are stored contiguously, sense then antisense, in the order of
+// Vertex::getEdges(dir), along with the index of the vertex they
+// point to, so a search can follow edges without copying edge
+// lists or chasing twin pointers.
+//
+// The snapshot is only valid while the graph's edges and vertices
+// are unchanged, eg during a visitor pass that only marks vertices
+// and removes them in postvisit.
+//
+#ifndef SGADJACENCY_H
+#define SGADJACENCY_H
+
+#include <vector>
+#include <unordered_map>
+#include "Bigraph.h"
+
+struct SGAdjEntry
+{
+    Vertex* pEnd;
+    Edge* pEdge;
+    uint32_t endIdx; // index of pEnd in the snapshot
+    EdgeDir expandDir; // direction to continue from pEnd, !twin->getDir()
+};
+
+class SGAdjacency
+{
+    public:
+
+        static const uint32_t NO_INDEX = 0xFFFFFFFF;
+
+        SGAdjacency() {}
+
+        // Snapshot the edges of every vertex in the graph
+        void build(const Bigraph* pGraph);
+
+        // Snapshot the edges of the given vertices, which must include the
+        // end of every edge, eg a set of connected components
+        void build(const VertexPtrVec& vertices);
+        void clear();
+
+        bool empty() const { return m_vertices.empty(); }
+        size_t getNumVertices() const { return m_vertices.size(); }
+        size_t getNumEdges() const { return m_entries.size(); }
+
+        // Return the index of pVertex, or NO_INDEX if it is not in the snapshot
+        uint32_t getIndex(const Vertex* pVertex) const
+        {
+            std::unordered_map<const Vertex*, uint32_t>::const_iterator iter = m_index.find(pVertex);
+            return iter == m_index.end() ? NO_INDEX : iter->second;
+        }
+
+        // The edges of the vertex with index idx in direction dir
+        const SGAdjEntry* begin(uint32_t idx, EdgeDir dir) const { return m_entries.data() + m_offsets[2 * idx + dir]; }
+        const SGAdjEntry* end(uint32_t idx, EdgeDir dir) const { return m_entries.data() + m_offsets[2 * idx + dir + 1]; }
+
+        // The edges of the vertex with index idx in both directions
+        const SGAdjEntry* begin(uint32_t idx) const { return m_entries.data() + m_offsets[2 * idx]; }
+        const SGAdjEntry* end(uint32_t idx) const { return m_entries.data() + m_offsets[2 * idx + 2]; }
+
+        size_t countEdges(uint32_t idx, EdgeDir dir) const { return m_offsets[2 * idx + dir + 1] - m_offsets[2 * idx + dir]; }
+
+    private:
+
+        std::vector<Vertex*> m_vertices;
+        std::unordered_map<const Vertex*, uint32_t> m_index;
+
+        // m_entries[m_offsets[2i + dir], m_offsets[2i + dir + 1]) are the edges of vertex i in dir
+        std::vector<uint32_t> m_offsets;
+        std::vector<SGAdjEntry> m_entries;
+};
+
+#endif
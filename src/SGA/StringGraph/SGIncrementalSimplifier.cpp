@@ -0,0 +1,271 @@
+//-----------------------------------------------
+// Released under the GPL
+//-----------------------------------------------
+//
+// SGIncrementalSimplifier - Worklist driven graph simplification
+//
+#include "SGIncrementalSimplifier.h"
+
+SGIncrementalSimplifier::SGIncrementalSimplifier(StringGraph* pGraph) : m_pGraph(pGraph),
+                                                                         m_pPass(NULL),
+                                                                         m_passList(-1),
+                                                                         m_cursor(0)
+{
+    m_vertices = pGraph->getAllVertices();
+    m_rank.reserve(m_vertices.size());
+    for(size_t i = 0; i < m_vertices.size(); ++i)
+        m_rank[m_vertices[i]] = i;
+
+    // the visitors expect every vertex to be white, and leave them that way
+    pGraph->setColors(GC_WHITE);
+    touchAll();
+}
+
+//
+void SGIncrementalSimplifier::touchAll()
+{
+    for(size_t i = 0; i < m_vertices.size(); ++i)
+    {
+        if(m_vertices[i] != NULL)
+            touch(m_vertices[i]);
+    }
+}
+
+//
+void SGIncrementalSimplifier::removeContainments(SGContainRemoveVisitor& visitor)
+{
+    SGSimplifyCounters& counters = m_counters[SGS_CONTAIN];
+    while(m_pGraph->hasContainment())
+    {
+        // as SGContainRemoveVisitor::previsit, containments found
+        // during the round set the flag again
+        m_pGraph->setContainmentFlag(false);
+        ++counters.rounds;
+        size_t numVertices = m_pGraph->getNumVertices();
+
+        RankSet removed;
+        for(uint32_t rank = 0; rank < m_vertices.size(); ++rank)
+        {
+            Vertex* pVertex = m_vertices[rank];
+            if(pVertex == NULL || !pVertex->isContained())
+                continue;
+
+            // the visit deletes the edges of the vertex
+            VertexPtrVec neighbors;
+            EdgePtrVec edges = pVertex->getEdges();
+            for(size_t i = 0; i < edges.size(); ++i)
+            {
+                if(edges[i]->getEnd() != pVertex)
+                    neighbors.push_back(edges[i]->getEnd());
+            }
+
+            visitor.visit(m_pGraph, pVertex);
+            for(size_t i = 0; i < neighbors.size(); ++i)
+                touchEdgesChanged(neighbors[i]);
+            removed.insert(rank);
+        }
+        counters.visited += removed.size();
+        counters.skipped += numVertices - removed.size();
+        counters.changed += sweep(removed, GC_BLACK);
+    }
+}
+
+//
+void SGIncrementalSimplifier::simplify()
+{
+    assert(!m_pGraph->hasContainment());
+    simplify(ED_SENSE);
+    simplify(ED_ANTISENSE);
+}
+
+// Each pass visits the vertices touched since they were last visited, in
+// rank order, until no merge is made. A vertex that was not touched cannot
+// be merged, as its edges and the edge counts of its neighbours are unchanged
+void SGIncrementalSimplifier::simplify(EdgeDir dir)
+{
+    SGSimplifyCounters& counters = m_counters[SGS_SIMPLIFY];
+    int list = (dir == ED_SENSE) ? PENDING_SENSE : PENDING_ANTISENSE;
+
+    RankSet pass;
+    m_pPass = &pass;
+    m_passList = list;
+    while(!m_pending[list].empty())
+    {
+        pass.swap(m_pending[list]);
+        ++counters.rounds;
+        counters.skipped += m_pGraph->getNumVertices() - pass.size();
+
+        while(!pass.empty())
+        {
+            m_cursor = *pass.begin();
+            pass.erase(pass.begin());
+            ++counters.visited;
+
+            Vertex* pVertex = m_vertices[m_cursor];
+            const Vertex* pMerged = NULL;
+            if(m_pGraph->mergeUnbranched(pVertex, dir, &pMerged))
+            {
+                forget(pMerged);
+                touchEdgesChanged(pVertex);
+                ++counters.changed;
+            }
+        }
+    }
+    m_pPass = NULL;
+    m_passList = -1;
+}
+
+// Trimming only depends on the length and edge counts of a vertex,
+// so only vertices whose edges changed are visited again
+void SGIncrementalSimplifier::trim(SGTrimVisitor& visitor)
+{
+    SGSimplifyCounters& counters = m_counters[SGS_TRIM];
+    RankSet pass;
+    pass.swap(m_pending[PENDING_TRIM]);
+    ++counters.rounds;
+    counters.skipped += m_pGraph->getNumVertices() - pass.size();
+
+    visitor.num_island = 0;
+    visitor.num_terminal = 0;
+    for(RankSet::const_iterator iter = pass.begin(); iter != pass.end(); ++iter)
+        visitor.visit(m_pGraph, m_vertices[*iter]);
+    counters.visited += pass.size();
+    counters.changed += sweep(pass, GC_BLACK);
+}
+
+// A bubble search stays within the connected component of the vertex it
+// starts from, so only the components holding touched vertices are visited
+void SGIncrementalSimplifier::smooth(SGSmoothingVisitor& visitor)
+{
+    SGSimplifyCounters& counters = m_counters[SGS_SMOOTH];
+    RankSet pass;
+    collectComponents(m_pending[PENDING_SMOOTH], pass);
+    m_pending[PENDING_SMOOTH].clear();
+    ++counters.rounds;
+    counters.skipped += m_pGraph->getNumVertices() - pass.size();
+
+    VertexPtrVec vertices;
+    vertices.reserve(pass.size());
+    for(RankSet::const_iterator iter = pass.begin(); iter != pass.end(); ++iter)
+        vertices.push_back(m_vertices[*iter]);
+
+    // as SGSmoothingVisitor::previsit, over the components only
+    visitor.m_simpleBubblesRemoved = 0;
+    visitor.m_complexBubblesRemoved = 0;
+    visitor.m_adjacency.build(vertices);
+    for(size_t i = 0; i < vertices.size(); ++i)
+        visitor.visit(m_pGraph, vertices[i]);
+    visitor.m_adjacency.clear();
+
+    counters.visited += pass.size();
+    counters.changed += sweep(pass, GC_RED);
+}
+
+//
+void SGIncrementalSimplifier::printCounters(std::ostream& out) const
+{
+    static const char* names[SGS_COUNT] = { "contain", "simplify", "trim", "smooth" };
+    for(size_t i = 0; i < SGS_COUNT; ++i)
+    {
+        const SGSimplifyCounters& counters = m_counters[i];
+        out << names[i] << ": " << counters.rounds << " rounds, "
+            << counters.visited << " visited, " << counters.skipped << " skipped, "
+            << counters.changed << " changed\n";
+    }
+}
+
+//
+void SGIncrementalSimplifier::touch(const Vertex* pVertex)
+{
+    uint32_t rank = getRank(pVertex);
+    for(int i = 0; i < PENDING_COUNT; ++i)
+    {
+        // a vertex ahead of the cursor is visited later in the current pass
+        if(i == m_passList && rank > m_cursor)
+            m_pPass->insert(rank);
+        else
+            m_pending[i].insert(rank);
+    }
+}
+
+//
+void SGIncrementalSimplifier::touchEdgesChanged(const Vertex* pVertex)
+{
+    touch(pVertex);
+    EdgePtrVec edges = pVertex->getEdges();
+    for(size_t i = 0; i < edges.size(); ++i)
+        touch(edges[i]->getEnd());
+}
+
+//
+void SGIncrementalSimplifier::forget(const Vertex* pVertex)
+{
+    uint32_t rank = getRank(pVertex);
+    m_rank.erase(pVertex);
+    m_vertices[rank] = NULL;
+    for(int i = 0; i < PENDING_COUNT; ++i)
+        m_pending[i].erase(rank);
+    if(m_pPass != NULL)
+        m_pPass->erase(rank);
+}
+
+// As Bigraph::sweepVertices, in rank order
+size_t SGIncrementalSimplifier::sweep(const RankSet& ranks, GraphColor c)
+{
+    size_t numRemoved = 0;
+    for(RankSet::const_iterator iter = ranks.begin(); iter != ranks.end(); ++iter)
+    {
+        Vertex* pVertex = m_vertices[*iter];
+        if(pVertex == NULL || pVertex->getColor() != c)
+            continue;
+
+        VertexPtrVec neighbors;
+        EdgePtrVec edges = pVertex->getEdges();
+        for(size_t i = 0; i < edges.size(); ++i)
+        {
+            if(edges[i]->getEnd() != pVertex)
+                neighbors.push_back(edges[i]->getEnd());
+        }
+
+        forget(pVertex);
+        m_pGraph->removeConnectedVertex(pVertex);
+        ++numRemoved;
+
+        // neighbours that are swept as well are forgotten when they are removed
+        for(size_t i = 0; i < neighbors.size(); ++i)
+            touchEdgesChanged(neighbors[i]);
+    }
+    return numRemoved;
+}
+
+//
+void SGIncrementalSimplifier::collectComponents(const RankSet& seeds, RankSet& outRanks) const
+{
+    std::vector<uint32_t> stack;
+    for(RankSet::const_iterator iter = seeds.begin(); iter != seeds.end(); ++iter)
+    {
+        if(!outRanks.insert(*iter).second)
+            continue;
+        stack.push_back(*iter);
+        while(!stack.empty())
+        {
+            Vertex* pVertex = m_vertices[stack.back()];
+            stack.pop_back();
+            EdgePtrVec edges = pVertex->getEdges();
+            for(size_t i = 0; i < edges.size(); ++i)
+            {
+                uint32_t rank = getRank(edges[i]->getEnd());
+                if(outRanks.insert(rank).second)
+                    stack.push_back(rank);
+            }
+        }
+    }
+}
+
+//
+uint32_t SGIncrementalSimplifier::getRank(const Vertex* pVertex) const
+{
+    std::unordered_map<const Vertex*, uint32_t>::const_iterator iter = m_rank.find(pVertex);
+    assert(iter != m_rank.end());
+    return iter->second;
+}
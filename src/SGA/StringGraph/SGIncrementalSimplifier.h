@@ -0,0 +1,125 @@
+//-----------------------------------------------
+// Released under the GPL
+//-----------------------------------------------
+//
+// SGIncrementalSimplifier - Containment removal, chain
+// compaction, trimming and bubble smoothing driven by
+// worklists of the vertices that changed since each step
+// last looked at them, rather than by passes over every
+// vertex of the graph.
+//
+// Vertices are ranked by the order of the graph's vertex map
+// when the simplifier is created, which is the order a visitor
+// pass uses, and each worklist is processed in rank order. The
+// graph is therefore changed exactly as by the visitors and
+// Bigraph::simplify. Vertices must not be added to the graph
+// while the simplifier is in use.
+//
+#ifndef SGINCREMENTALSIMPLIFIER_H
+#define SGINCREMENTALSIMPLIFIER_H
+
+#include <set>
+#include <vector>
+#include <ostream>
+#include <unordered_map>
+#include "SGUtil.h"
+#include "SGVisitors.h"
+
+enum SGSimplifyStep
+{
+    SGS_CONTAIN = 0,
+    SGS_SIMPLIFY,
+    SGS_TRIM,
+    SGS_SMOOTH,
+    SGS_COUNT
+};
+
+// Work done by one step of the simplifier
+struct SGSimplifyCounters
+{
+    SGSimplifyCounters() : rounds(0), visited(0), skipped(0), changed(0) {}
+
+    size_t rounds;
+    size_t visited; // vertices visited
+    size_t skipped; // vertices a full pass would have visited as well
+    size_t changed; // vertices removed, or merged away by simplify
+};
+
+class SGIncrementalSimplifier
+{
+    public:
+
+        SGIncrementalSimplifier(StringGraph* pGraph);
+
+        // Remove contained vertices while the graph has containments,
+        // as repeated passes of SGContainRemoveVisitor
+        void removeContainments(SGContainRemoveVisitor& visitor);
+
+        // Compact unbranched chains, as Bigraph::simplify
+        void simplify();
+
+        // One round of dead-end removal, as a pass of SGTrimVisitor
+        void trim(SGTrimVisitor& visitor);
+
+        // One round of bubble removal, as a pass of SGSmoothingVisitor
+        void smooth(SGSmoothingVisitor& visitor);
+
+        // The graph was changed by something other than the simplifier,
+        // every vertex has to be looked at again
+        void touchAll();
+
+        const SGSimplifyCounters& getCounters(SGSimplifyStep step) const { return m_counters[step]; }
+        void printCounters(std::ostream& out) const;
+
+    private:
+
+        typedef std::set<uint32_t> RankSet;
+
+        // The worklists. Containment flags can be set on any vertex as
+        // edges are added, so contained vertices are found by a scan
+        enum
+        {
+            PENDING_SENSE = 0,
+            PENDING_ANTISENSE,
+            PENDING_TRIM,
+            PENDING_SMOOTH,
+            PENDING_COUNT
+        };
+
+        void simplify(EdgeDir dir);
+
+        // Add pVertex to every worklist
+        void touch(const Vertex* pVertex);
+
+        // pVertex's edges changed, so it and its neighbours have to be looked at again
+        void touchEdgesChanged(const Vertex* pVertex);
+
+        // Remove a deleted vertex from the worklists
+        void forget(const Vertex* pVertex);
+
+        // Remove the vertices of ranks with color c from the graph. Returns the number removed
+        size_t sweep(const RankSet& ranks, GraphColor c);
+
+        // Add the connected components of the vertices of seeds to outRanks
+        void collectComponents(const RankSet& seeds, RankSet& outRanks) const;
+
+        uint32_t getRank(const Vertex* pVertex) const;
+
+        StringGraph* m_pGraph;
+
+        // vertices by rank, NULL once removed
+        std::vector<Vertex*> m_vertices;
+        std::unordered_map<const Vertex*, uint32_t> m_rank;
+
+        RankSet m_pending[PENDING_COUNT];
+
+        // The pass of simplify in progress. Vertices touched beyond the
+        // cursor are added to the pass rather than to the next one
+        RankSet* m_pPass;
+        int m_passList;
+        uint32_t m_cursor;
+
+        SGSimplifyCounters m_counters[SGS_COUNT];
+};
+
+#endif
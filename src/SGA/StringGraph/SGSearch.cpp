@@ -83,9 +83,10 @@ void SGSearch::findVariantWalks(Vertex* pX,
                                 EdgeDir initialDir, 
                                 int maxDistance,
                                 size_t maxWalks, 
-                                SGWalkVector& outWalks)
+                                SGWalkVector& outWalks,
+                                const SGAdjacency* pAdjacency)
 {
-    findCollapsedWalks(pX, initialDir, maxDistance, 500, outWalks);
+    findCollapsedWalks(pX, initialDir, maxDistance, 500, outWalks, pAdjacency);
 
     if(outWalks.size() <= 1 || outWalks.size() > maxWalks)
     {
@@ -134,13 +135,11 @@ void SGSearch::findVariantWalks(Vertex* pX,
 
     // Ensure that all the vertices linked to the start vertex
     // in the specified dir are present in the set.
-    EdgePtrVec epv = pX->getEdges(initialDir);
-    cleanlyRemovable = checkEndpointsInSet(epv, completeVertexSet);
+    cleanlyRemovable = checkEndpointsInSet(pX, initialDir, pAdjacency, completeVertexSet);
 
     // Ensure that all the vertex linked to the last vertex
     // in the incoming direction are preset
-    epv = pLastVertex->getEdges(lastDir);
-    cleanlyRemovable = cleanlyRemovable && checkEndpointsInSet(epv, completeVertexSet);
+    cleanlyRemovable = cleanlyRemovable && checkEndpointsInSet(pLastVertex, lastDir, pAdjacency, completeVertexSet);
 
     // Check that each vertex connected to an interval vertex is also present
     for(std::set<Vertex*>::iterator iter = completeVertexSet.begin(); iter != completeVertexSet.end(); ++iter)
@@ -148,8 +147,7 @@ void SGSearch::findVariantWalks(Vertex* pX,
         Vertex* pY = *iter;
         if(pY == pX || pY == pLastVertex)
             continue;
-        epv = pY->getEdges();
-        cleanlyRemovable = cleanlyRemovable && checkEndpointsInSet(epv, completeVertexSet);
+        cleanlyRemovable = cleanlyRemovable && checkEndpointsInSet(pY, ED_COUNT, pAdjacency, completeVertexSet);
     }
 
     if(!cleanlyRemovable)
@@ -171,13 +169,34 @@ bool SGSearch::checkEndpointsInSet(EdgePtrVec& epv, std::set<Vertex*>& vertexSet
     return true;
 }
 
+//
+bool SGSearch::checkEndpointsInSet(const Vertex* pVertex, EdgeDir dir, const SGAdjacency* pAdjacency, std::set<Vertex*>& vertexSet)
+{
+    uint32_t idx = pAdjacency != NULL ? pAdjacency->getIndex(pVertex) : SGAdjacency::NO_INDEX;
+    if(idx == SGAdjacency::NO_INDEX)
+    {
+        EdgePtrVec epv = dir == ED_COUNT ? pVertex->getEdges() : pVertex->getEdges(dir);
+        return checkEndpointsInSet(epv, vertexSet);
+    }
+
+    const SGAdjEntry* pFirst = dir == ED_COUNT ? pAdjacency->begin(idx) : pAdjacency->begin(idx, dir);
+    const SGAdjEntry* pLast = dir == ED_COUNT ? pAdjacency->end(idx) : pAdjacency->end(idx, dir);
+    for(const SGAdjEntry* pEntry = pFirst; pEntry != pLast; ++pEntry)
+    {
+        if(vertexSet.find(pEntry->pEnd) == vertexSet.end())
+            return false;
+    }
+    return true;
+}
+
 // Return a set of walks that all start from pX and join together at some later vertex
 // If no such walk exists, an empty set is returned
 void SGSearch::findCollapsedWalks(Vertex* pX, EdgeDir initialDir, 
                                   int maxDistance, size_t maxNodes, 
-                                  SGWalkVector& outWalks)
+                                  SGWalkVector& outWalks,
+                                  const SGAdjacency* pAdjacency)
 {
-    SGSearchTree searchTree(pX, NULL, initialDir, maxDistance, maxNodes);
+    SGSearchTree searchTree(pX, NULL, initialDir, maxDistance, maxNodes, pAdjacency);
 
     // Iteravively perform the BFS using the search tree. After each step
     // we check if the search has collapsed to a single vertex.
@@ -61,15 +61,19 @@ namespace SGSearch
                    bool exhaustive,
                    SGWalkVector& outWalks);
 
+    // If pAdjacency is given, the graph is searched through the snapshot,
+    // which must be current
     void findVariantWalks(Vertex* pX, 
                           EdgeDir initialDir, 
                           int maxDistance,
                           size_t maxWalks, 
-                          SGWalkVector& outWalks);
+                          SGWalkVector& outWalks,
+                          const SGAdjacency* pAdjacency = NULL);
 
     void findCollapsedWalks(Vertex* pX, EdgeDir initialDir, 
                             int maxDistance, size_t maxNodes,
-                            SGWalkVector& outWalks);
+                            SGWalkVector& outWalks,
+                            const SGAdjacency* pAdjacency = NULL);
 
     // Count the number of vertices that span the sequence junction
     // described by edge XY. Returns -1 if the search was not completed
@@ -77,6 +81,10 @@ namespace SGSearch
 
     // Returns true if all the endpoints of the edges in epv are in vertexSet
     bool checkEndpointsInSet(EdgePtrVec& epv, std::set<Vertex*>& vertexSet);
+
+    // Returns true if all the endpoints of the edges of pVertex, in direction dir or
+    // in both directions if dir is ED_COUNT, are in vertexSet
+    bool checkEndpointsInSet(const Vertex* pVertex, EdgeDir dir, const SGAdjacency* pAdjacency, std::set<Vertex*>& vertexSet);
 };
 
 #endif
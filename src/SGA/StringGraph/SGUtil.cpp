@@ -81,8 +81,7 @@ StringGraph* SGUtil::loadASQG(const std::string& filename, const unsigned int mi
                 ASQG::VertexRecord vertexRecord(recordLine);
                 const SQG::IntTag& ssTag = vertexRecord.getSubstringTag();
 
-		//                Vertex* pVertex = new(pGraph->getVertexAllocator()) Vertex(vertexRecord.getID(), vertexRecord.getSeq());
-		Vertex* pVertex = new Vertex(vertexRecord.getID(), vertexRecord.getSeq());
+                Vertex* pVertex = new(pGraph->getVertexAllocator()) Vertex(vertexRecord.getID(), vertexRecord.getSeq());
                 if(ssTag.isInitialized() && ssTag.get() == 1)
                 {
                     // Vertex is a substring of some other vertex, mark it as contained
@@ -213,8 +212,7 @@ StringGraph* SGUtil::loadASQG(std::stringstream& pReader, const unsigned int min
                 ASQG::VertexRecord vertexRecord(recordLine);
                 const SQG::IntTag& ssTag = vertexRecord.getSubstringTag();
 
-		//                Vertex* pVertex = new(pGraph->getVertexAllocator()) Vertex(vertexRecord.getID(), vertexRecord.getSeq());
-                Vertex* pVertex = new Vertex(vertexRecord.getID(), vertexRecord.getSeq());
+                Vertex* pVertex = new(pGraph->getVertexAllocator()) Vertex(vertexRecord.getID(), vertexRecord.getSeq());
                 if(ssTag.isInitialized() && ssTag.get() == 1)
                 {
                     // Vertex is a substring of some other vertex, mark it as contained
@@ -284,8 +282,7 @@ StringGraph* SGUtil::loadFASTA(const std::string& filename)
 
     while(reader.get(record))
     {
-      //Vertex* pVertex = new(pGraph->getVertexAllocator()) Vertex(record.id, record.seq.toString());
-        Vertex* pVertex = new Vertex(record.id, record.seq.toString());
+        Vertex* pVertex = new(pGraph->getVertexAllocator()) Vertex(record.id, record.seq.toString());
         pGraph->addVertex(pVertex);
     }
     return pGraph;
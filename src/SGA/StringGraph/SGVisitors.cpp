@@ -540,6 +540,9 @@ void SGSmoothingVisitor::previsit(StringGraph* pGraph)
     pGraph->setColors(GC_WHITE);
     m_simpleBubblesRemoved = 0;
     m_complexBubblesRemoved = 0;
+
+    // vertices are only marked until postvisit, so the edges stay as they are for the pass
+    m_adjacency.build(pGraph);
 }
 
 //
@@ -549,17 +552,20 @@ bool SGSmoothingVisitor::visit(StringGraph* pGraph, Vertex* pVertex)
     if(pVertex->getColor() == GC_RED)
         return false;
 
+    uint32_t adjIdx = m_adjacency.getIndex(pVertex);
+    assert(adjIdx != SGAdjacency::NO_INDEX);
+
     bool found = false;
     for(size_t idx = 0; idx < ED_COUNT; idx++)
     {
         EdgeDir dir = EDGE_DIRECTIONS[idx];
-        EdgePtrVec edges = pVertex->getEdges(dir);
-        if(edges.size() <= 1)
+        if(m_adjacency.countEdges(adjIdx, dir) <= 1)
             continue;
 
-        for(size_t i = 0; i < edges.size(); ++i)
+        const SGAdjEntry* pLast = m_adjacency.end(adjIdx, dir);
+        for(const SGAdjEntry* pEntry = m_adjacency.begin(adjIdx, dir); pEntry != pLast; ++pEntry)
         {
-            if(edges[i]->getEnd()->getColor() == GC_RED)
+            if(pEntry->pEnd->getColor() == GC_RED)
                 return false;
         }
 
@@ -573,7 +579,7 @@ bool SGSmoothingVisitor::visit(StringGraph* pGraph, Vertex* pVertex)
         bool bFailIndelSizeCheck = false;
 
         SGWalkVector variantWalks;
-        SGSearch::findVariantWalks(pVertex, dir, MAX_DISTANCE, MAX_WALKS, variantWalks);
+        SGSearch::findVariantWalks(pVertex, dir, MAX_DISTANCE, MAX_WALKS, variantWalks, &m_adjacency);
 
         if(variantWalks.size() > 0)
         {
@@ -790,6 +796,7 @@ bool SGSmoothingVisitor::visit(StringGraph* pGraph, Vertex* pVertex)
 // Remove all the marked edges
 void SGSmoothingVisitor::postvisit(StringGraph* pGraph)
 {
+    m_adjacency.clear();
     pGraph->sweepVertices(GC_RED);
     assert(pGraph->checkColors(GC_WHITE));
 
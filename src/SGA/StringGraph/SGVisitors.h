@@ -10,6 +10,7 @@
 //
 #include "SGAlgorithms.h"
 #include "SGUtil.h"
+#include "SGAdjacency.h"
 #include "Util.h"
 //#include "contigs.h"
 #include "SeqLib/UnalignedSequence.h"
@@ -176,6 +177,9 @@ struct SGSmoothingVisitor
     double m_maxTotalDivergence;
     int m_maxIndelLength;
     std::ofstream m_outFile;
+
+    // Edges of the graph for the pass, which only marks vertices
+    SGAdjacency m_adjacency;
 };
 
 // Compile summary statistics for the graph
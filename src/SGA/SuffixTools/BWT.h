@@ -17,7 +17,14 @@
 
 #include "RLBWT.h"
 #include "SBWT.h"
+#include "PackedBWT.h"
 
+// svaba only indexes the reads of one window, so use the packed
+// BWT unless built with -DSGA_RLBWT
+#ifdef SGA_RLBWT
 typedef RLBWT BWT;
+#else
+typedef PackedBWT BWT;
+#endif
 
 #endif
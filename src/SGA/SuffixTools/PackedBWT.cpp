@@ -0,0 +1,137 @@
+//-----------------------------------------------
+// Released under the GPL
+//-----------------------------------------------
+//
+// PackedBWT - Uncompressed BWT for small texts
+//
+#include "PackedBWT.h"
+#include <stdlib.h>
+
+// Construct the BWT from a suffix array
+PackedBWT::PackedBWT(const SuffixArray* pSA, const ReadTable* pRT, size_t maxPackedSymbols) : m_pBlocks(NULL),
+                                                                                               m_numBlocks(0),
+                                                                                               m_pRL(NULL)
+{
+    build(pSA, *pRT, maxPackedSymbols);
+}
+
+//
+PackedBWT::PackedBWT(const SuffixArray* pSA, const PackedReadView& reads, size_t maxPackedSymbols) : m_pBlocks(NULL),
+                                                                                                     m_numBlocks(0),
+                                                                                                     m_pRL(NULL)
+{
+    build(pSA, reads, maxPackedSymbols);
+}
+
+//
+static RLBWT* newRLBWT(const SuffixArray* pSA, const ReadTable& rt)
+{
+    return new RLBWT(pSA, &rt);
+}
+
+static RLBWT* newRLBWT(const SuffixArray* pSA, const PackedReadView& reads)
+{
+    return new RLBWT(pSA, reads);
+}
+
+//
+template<typename Text>
+void PackedBWT::build(const SuffixArray* pSA, const Text& text, size_t maxPackedSymbols)
+{
+    size_t n = pSA->getSize();
+    m_numStrings = pSA->getNumStrings();
+    m_numSymbols = n;
+
+    if(n > maxPackedSymbols)
+    {
+        m_pRL = newRLBWT(pSA, text);
+        for(size_t i = 0; i < ALPHABET_SIZE; ++i)
+            m_predCount.setByIdx(i, m_pRL->getPC(RANK_ALPHABET[i]));
+        return;
+    }
+
+    // one more block than needed, so the counts of the whole text can be read at index n
+    m_numBlocks = (n >> 7) + 1;
+    if(posix_memalign((void**)&m_pBlocks, 64, m_numBlocks * sizeof(PackedBWTBlock)) != 0)
+    {
+        std::cerr << "Error: could not allocate a packed BWT of " << n << " symbols\n";
+        exit(EXIT_FAILURE);
+    }
+    memset(m_pBlocks, 0, m_numBlocks * sizeof(PackedBWTBlock));
+
+    AlphaCount64 running_ac;
+    for(size_t i = 0; i < n; ++i)
+    {
+        PackedBWTBlock& blk = m_pBlocks[i >> 7];
+        size_t j = i & 127;
+        if(j == 0)
+        {
+            blk.counts[0] = running_ac.get('$');
+            blk.counts[1] = running_ac.get('C');
+            blk.counts[2] = running_ac.get('G');
+            blk.counts[3] = running_ac.get('T');
+        }
+
+        SAElem saElem = pSA->get(i);
+        size_t len = text.getReadLength(saElem.getID());
+
+        // Get the position of the start of the suffix
+        uint64_t f_pos = saElem.getPos();
+        uint64_t l_pos = (f_pos == 0) ? len : f_pos - 1;
+        char b = (l_pos == len) ? '$' : text.getChar(saElem.getID(), l_pos);
+        running_ac.increment(b);
+
+        if(b == '$')
+            blk.dollar[j >> 6] |= 1ULL << (j & 63);
+        else
+            blk.sym[j >> 5] |= (uint64_t)DNA_ALPHABET::getBaseRank(b) << (2 * (j & 31));
+    }
+
+    // counts for the block just past the end, when n is a multiple of the block size
+    if((n & 127) == 0)
+    {
+        PackedBWTBlock& blk = m_pBlocks[n >> 7];
+        blk.counts[0] = running_ac.get('$');
+        blk.counts[1] = running_ac.get('C');
+        blk.counts[2] = running_ac.get('G');
+        blk.counts[3] = running_ac.get('T');
+    }
+
+    // Initialize C(a)
+    m_predCount.set('$', 0);
+    m_predCount.set('A', running_ac.get('$'));
+    m_predCount.set('C', m_predCount.get('A') + running_ac.get('A'));
+    m_predCount.set('G', m_predCount.get('C') + running_ac.get('C'));
+    m_predCount.set('T', m_predCount.get('G') + running_ac.get('G'));
+}
+
+PackedBWT::~PackedBWT()
+{
+    free(m_pBlocks);
+    delete m_pRL;
+}
+
+// Print the size of the BWT
+void PackedBWT::printInfo() const
+{
+    if(m_pRL)
+    {
+        m_pRL->printInfo();
+        return;
+    }
+    size_t bytes = m_numBlocks * sizeof(PackedBWTBlock);
+    printf("PackedBWT info\n");
+    printf("Number of symbols: %zu\n", m_numSymbols);
+    printf("Number of strings: %zu\n", m_numStrings);
+    printf("Number of blocks: %zu\n", m_numBlocks);
+    printf("Total size: %zu bytes (%lf bits per symbol)\n", bytes, m_numSymbols ? (double)bytes * 8 / m_numSymbols : 0);
+}
+
+// Print the BWT
+void PackedBWT::print() const
+{
+    std::string bwt;
+    for(size_t i = 0; i < m_numSymbols; ++i)
+        bwt.push_back(getChar(i));
+    std::cout << bwt << "\n";
+}
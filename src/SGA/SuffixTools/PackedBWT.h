@@ -0,0 +1,209 @@
+//-----------------------------------------------
+// Released under the GPL
+//-----------------------------------------------
+//
+// PackedBWT - Uncompressed BWT for small texts, such as the
+// reads of one local assembly. Symbols are packed 2 bits each
+// into 64-byte blocks of 128 symbols, with the '$' positions in
+// a bitmask and the counts before the block in a header, so
+// getOcc/getFullOcc read one cache line and count with popcount.
+// Texts too long for the 32-bit block counts are stored in an
+// RLBWT instead, and every call forwards to it.
+//
+#ifndef PACKEDBWT_H
+#define PACKEDBWT_H
+
+#include "STCommon.h"
+#include "SuffixArray.h"
+#include "ReadTable.h"
+#include "PackedReadTable.h"
+#include "RLBWT.h"
+
+// Use the popcount instruction when the target has it (-mpopcnt or
+// -march=native on x86), otherwise count bits with shifts and adds, which
+// is faster than the libgcc call __builtin_popcountll becomes
+static inline int packedPopcount(uint64_t x)
+{
+#if defined(__POPCNT__) || !(defined(__x86_64__) || defined(__i386__))
+    return __builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (x * 0x0101010101010101ULL) >> 56;
+#endif
+}
+
+// One cache line: the counts of '$', C, G and T before the block
+// (A is the remainder), a bitmask of '$' and the 2-bit codes of
+// A, C, G, T ('$' is stored as A)
+struct PackedBWTBlock
+{
+    uint32_t counts[4];
+    uint64_t dollar[2];
+    uint64_t sym[4];
+};
+
+class PackedBWT
+{
+    public:
+
+        // Largest text stored packed. Longer texts use an RLBWT
+        static const size_t DEFAULT_MAX_PACKED_SYMBOLS = 0xFFFFFFFF;
+
+        PackedBWT(const SuffixArray* pSA, const ReadTable* pRT, size_t maxPackedSymbols = DEFAULT_MAX_PACKED_SYMBOLS);
+
+        // From the reads of a packed read table, in the orientation of the view
+        PackedBWT(const SuffixArray* pSA, const PackedReadView& reads, size_t maxPackedSymbols = DEFAULT_MAX_PACKED_SYMBOLS);
+        ~PackedBWT();
+
+        PackedBWT(const PackedBWT&) = delete;
+        PackedBWT& operator=(const PackedBWT&) = delete;
+
+        inline char getChar(size_t idx) const
+        {
+            if(m_pRL)
+                return m_pRL->getChar(idx);
+            const PackedBWTBlock& blk = m_pBlocks[idx >> 7];
+            size_t j = idx & 127;
+            if((blk.dollar[j >> 6] >> (j & 63)) & 1)
+                return '$';
+            return "ACGT"[(blk.sym[j >> 5] >> (2 * (j & 31))) & 3];
+        }
+
+        inline BaseCount getPC(char b) const { return m_predCount.get(b); }
+
+        // Return the number of times char b appears in bwt[0, idx]
+        inline BaseCount getOcc(char b, size_t idx) const
+        {
+            if(m_pRL)
+                return m_pRL->getOcc(b, idx);
+
+            // counts are not inclusive, so count the first idx + 1 symbols
+            ++idx;
+            const PackedBWTBlock& blk = m_pBlocks[idx >> 7];
+            size_t off = idx & 127;
+            switch(b)
+            {
+                case '$': return blk.counts[0] + countDollar(blk, off);
+                case 'C': return blk.counts[1] + countCode(blk, 1, off);
+                case 'G': return blk.counts[2] + countCode(blk, 2, off);
+                case 'T': return blk.counts[3] + countCode(blk, 3, off);
+                default: break;
+            }
+            size_t other = blk.counts[0] + blk.counts[1] + blk.counts[2] + blk.counts[3];
+            return (idx & ~(size_t)127) - other + countCode(blk, 0, off) - countDollar(blk, off);
+        }
+
+        // Return the number of times each symbol in the alphabet appears in bwt[0, idx]
+        inline AlphaCount64 getFullOcc(size_t idx) const
+        {
+            if(m_pRL)
+                return m_pRL->getFullOcc(idx);
+
+            ++idx;
+            const PackedBWTBlock& blk = m_pBlocks[idx >> 7];
+            size_t off = idx & 127;
+
+            uint64_t c = blk.counts[1], g = blk.counts[2], t = blk.counts[3];
+            uint64_t d = blk.counts[0] + countDollar(blk, off);
+            for(size_t w = 0; w < 4; ++w)
+            {
+                uint64_t x = blk.sym[w] & wordMask(off, w); // masked symbols become A, which is not counted here
+                uint64_t lo = x & 0x5555555555555555ULL, hi = (x >> 1) & 0x5555555555555555ULL;
+                c += packedPopcount(lo & ~hi);
+                g += packedPopcount(hi & ~lo);
+                t += packedPopcount(lo & hi);
+            }
+
+            AlphaCount64 out;
+            out.setByIdx(0, d);
+            out.setByIdx(1, idx - d - c - g - t);
+            out.setByIdx(2, c);
+            out.setByIdx(3, g);
+            out.setByIdx(4, t);
+            return out;
+        }
+
+        // Fetch the cache line read by getOcc/getFullOcc(idx) ahead of the call
+        inline void prefetch(size_t idx) const
+        {
+            if(m_pRL)
+                m_pRL->prefetch(idx);
+            else
+                __builtin_prefetch(m_pBlocks + ((idx + 1) >> 7));
+        }
+
+        // Return the number of times each symbol in the alphabet appears ins bwt[idx0, idx1]
+        inline AlphaCount64 getOccDiff(size_t idx0, size_t idx1) const
+        {
+            return getFullOcc(idx1) - getFullOcc(idx0);
+        }
+
+        inline size_t getNumStrings() const { return m_numStrings; }
+        inline size_t getBWLen() const { return m_numSymbols; }
+
+        // Return the first letter of the suffix starting at idx
+        inline char getF(size_t idx) const
+        {
+            size_t ci = 0;
+            while(ci < ALPHABET_SIZE && m_predCount.getByIdx(ci) <= idx)
+                ci++;
+            assert(ci != 0);
+            return RANK_ALPHABET[ci - 1];
+        }
+
+        bool isPacked() const { return m_pRL == NULL; }
+
+        void printInfo() const;
+        void print() const;
+
+    private:
+
+        // Fill the blocks from the suffix array and the reads it was built
+        // from. Text is a ReadTable or a PackedReadView
+        template<typename Text>
+        void build(const SuffixArray* pSA, const Text& text, size_t maxPackedSymbols);
+
+        // bits of word w of a block holding the first off symbols of the block
+        static inline uint64_t wordMask(size_t off, size_t w)
+        {
+            size_t n = off > w * 32 ? off - w * 32 : 0;
+            return n >= 32 ? ~0ULL : (1ULL << (2 * n)) - 1;
+        }
+
+        // occurrences of 2-bit code in the first off symbols of the block, counting '$' as A
+        static inline size_t countCode(const PackedBWTBlock& blk, uint64_t code, size_t off)
+        {
+            const uint64_t pattern = code * 0x5555555555555555ULL;
+            size_t n = 0;
+            for(size_t w = 0; w < 4; ++w)
+            {
+                uint64_t x = blk.sym[w] ^ pattern; // 00 where the symbol matches
+                n += packedPopcount(~(x | (x >> 1)) & 0x5555555555555555ULL & wordMask(off, w));
+            }
+            return n;
+        }
+
+        // occurrences of '$' in the first off symbols of the block
+        static inline size_t countDollar(const PackedBWTBlock& blk, size_t off)
+        {
+            if(off < 64)
+                return packedPopcount(blk.dollar[0] & ((1ULL << off) - 1));
+            return packedPopcount(blk.dollar[0]) + packedPopcount(blk.dollar[1] & ((1ULL << (off - 64)) - 1));
+        }
+
+        // The C(a) array
+        AlphaCount64 m_predCount;
+
+        PackedBWTBlock* m_pBlocks;
+        size_t m_numBlocks;
+
+        // Set instead of the blocks for long texts
+        RLBWT* m_pRL;
+
+        size_t m_numStrings;
+        size_t m_numSymbols;
+};
+
+#endif
@@ -33,6 +33,19 @@ RLBWT::RLBWT(const std::string& filename, int sampleRate) : m_numStrings(0),
 
 // Construct the BWT from a suffix array
 RLBWT::RLBWT(const SuffixArray* pSA, const ReadTable* pRT)
+{
+    build(pSA, *pRT);
+}
+
+//
+RLBWT::RLBWT(const SuffixArray* pSA, const PackedReadView& reads)
+{
+    build(pSA, reads);
+}
+
+//
+template<typename Text>
+void RLBWT::build(const SuffixArray* pSA, const Text& text)
 {
 
       // Set up BWT state
@@ -48,12 +61,12 @@ RLBWT::RLBWT(const SuffixArray* pSA, const ReadTable* pRT)
     {
 
         SAElem saElem = pSA->get(i);
-        const SeqItem& si = pRT->getRead(saElem.getID());
+        size_t len = text.getReadLength(saElem.getID());
 
         // Get the position of the start of the suffix
         uint64_t f_pos = saElem.getPos();
-        uint64_t l_pos = (f_pos == 0) ? si.seq.length() : f_pos - 1;
-        char b = (l_pos == si.seq.length()) ? '$' : si.seq.get(l_pos);
+        uint64_t l_pos = (f_pos == 0) ? len : f_pos - 1;
+        char b = (l_pos == len) ? '$' : text.getChar(saElem.getID(), l_pos);
 
         // Add to the current run or append in the new char
         if(currRun.isInitialized())
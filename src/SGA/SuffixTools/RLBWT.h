@@ -13,6 +13,7 @@
 #include "Occurrence.h"
 #include "SuffixArray.h"
 #include "ReadTable.h"
+#include "PackedReadTable.h"
 #include "HitData.h"
 #include "BWTReader.h"
 #include "EncodedString.h"
@@ -32,6 +33,7 @@ class RLBWT
         // Constructors
         RLBWT(const std::string& filename, int sampleRate = DEFAULT_SAMPLE_RATE_SMALL);
         RLBWT(const SuffixArray* pSA, const ReadTable* pRT);
+        RLBWT(const SuffixArray* pSA, const PackedReadView& reads);
 
         //    
         void initializeFMIndex();
@@ -117,6 +119,14 @@ class RLBWT
 
         inline BaseCount getPC(char b) const { return m_predCount.get(b); }
 
+        // Fetch the markers read by getOcc/getFullOcc(idx) ahead of the call
+        inline void prefetch(size_t idx) const
+        {
+            size_t small_idx = getNearestMarkerIdx(idx + 1, m_smallSampleRate, m_smallShiftValue);
+            __builtin_prefetch(m_smallMarkers.data() + small_idx);
+            __builtin_prefetch(m_largeMarkers.data() + ((small_idx << m_smallShiftValue) >> m_largeShiftValue));
+        }
+
         // Return the number of times char b appears in bwt[0, idx]
         inline BaseCount getOcc(char b, size_t idx) const
         {
@@ -269,6 +279,11 @@ class RLBWT
 
         // Default constructor is not allowed
         RLBWT() {}
+
+        // Run-length encode the BWT of the suffix array and the reads it
+        // was built from. Text is a ReadTable or a PackedReadView
+        template<typename Text>
+        void build(const SuffixArray* pSA, const Text& text);
         
         // Calculate the number of markers to place
         size_t getNumRequiredMarkers(size_t n, size_t d) const;
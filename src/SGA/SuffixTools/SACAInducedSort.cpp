@@ -0,0 +1,398 @@
+//-----------------------------------------------
+// Released under the GPL license
+//-----------------------------------------------
+//
+// SACAInducedSort - SA-IS over a packed read table
+//
+#include "SACAInducedSort.h"
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+// Text and work space shared by the forward and reverse builds
+struct SAISText
+{
+    std::vector<int32_t> text; // reads, each followed by its sentinel, then a final 0
+    std::vector<int32_t> sa;
+    std::vector<uint32_t> ids; // read index of each text position
+    std::vector<int32_t> starts; // text position of the first base of each read
+    int32_t K; // largest symbol
+};
+
+// The passes below follow Mori's sais-lite: the L/S types are not stored but
+// recomputed from neighbouring symbols, SA entries that still have to induce
+// their predecessor are marked by complementing them, and the bucket pointer
+// of the last symbol seen is cached, as runs of one symbol are common.
+
+// Symbol counts of s[0, n)
+static void sais_counts(const int32_t* s, int32_t* C, int32_t n, int32_t k)
+{
+    std::fill(C, C + k, 0);
+    for(int32_t i = 0; i < n; ++i)
+        ++C[s[i]];
+}
+
+// Bucket starts, or ends if end is set, from the symbol counts
+static void sais_buckets(const int32_t* C, int32_t* B, int32_t k, bool end)
+{
+    int32_t sum = 0;
+    for(int32_t i = 0; i < k; ++i)
+    {
+        sum += C[i];
+        B[i] = end ? sum : sum - C[i];
+    }
+}
+
+// Sort the LMS substrings by inducing from their positions, which are in the
+// bucket ends, each stored as the position before it
+static void sais_lms_sort(const int32_t* s, int32_t* SA, const int32_t* C, int32_t* B, int32_t n, int32_t k)
+{
+    int32_t *b, i, j, c0, c1;
+
+    // L-type substrings
+    sais_buckets(C, B, k, false);
+    j = n - 1;
+    b = SA + B[c1 = s[j]];
+    --j;
+    *b++ = (s[j] < c1) ? ~j : j;
+    for(i = 0; i < n; ++i)
+    {
+        if(0 < (j = SA[i]))
+        {
+            if((c0 = s[j]) != c1)
+            {
+                B[c1] = b - SA;
+                b = SA + B[c1 = c0];
+            }
+            --j;
+            *b++ = (s[j] < c1) ? ~j : j;
+            SA[i] = 0;
+        }
+        else if(j < 0)
+        {
+            SA[i] = ~j;
+        }
+    }
+
+    // S-type substrings
+    sais_buckets(C, B, k, true);
+    for(i = n - 1, b = SA + B[c1 = 0]; 0 <= i; --i)
+    {
+        if(0 < (j = SA[i]))
+        {
+            if((c0 = s[j]) != c1)
+            {
+                B[c1] = b - SA;
+                b = SA + B[c1 = c0];
+            }
+            --j;
+            *--b = (s[j] > c1) ? ~(j + 1) : j;
+            SA[i] = 0;
+        }
+    }
+}
+
+// Move the m sorted LMS substrings to the front of SA and name them,
+// comparing substrings of equal length only. Returns the number of names
+static int32_t sais_lms_name(const int32_t* s, int32_t* SA, int32_t n, int32_t m)
+{
+    int32_t i, j, p, q, plen, qlen, name, c0, c1;
+
+    // the sorted substrings are the complemented entries
+    for(i = 0; (p = SA[i]) < 0; ++i)
+        SA[i] = ~p;
+    if(i < m)
+    {
+        for(j = i, ++i;; ++i)
+        {
+            if((p = SA[i]) < 0)
+            {
+                SA[j++] = ~p;
+                SA[i] = 0;
+                if(j == m)
+                    break;
+            }
+        }
+    }
+
+    // the length of each substring, stored by half its position
+    i = n - 1;
+    j = n - 1;
+    c0 = s[n - 1];
+    do { c1 = c0; } while((0 <= --i) && ((c0 = s[i]) >= c1));
+    while(0 <= i)
+    {
+        do { c1 = c0; } while((0 <= --i) && ((c0 = s[i]) <= c1));
+        if(0 <= i)
+        {
+            SA[m + ((i + 1) >> 1)] = j - i;
+            j = i + 1;
+            do { c1 = c0; } while((0 <= --i) && ((c0 = s[i]) >= c1));
+        }
+    }
+
+    // names, in place of the lengths
+    for(i = 0, name = 0, q = n, qlen = 0; i < m; ++i)
+    {
+        p = SA[i];
+        plen = SA[m + (p >> 1)];
+        bool diff = true;
+        if(plen == qlen && q + plen < n)
+        {
+            for(j = 0; j < plen && s[p + j] == s[q + j]; ++j) {}
+            if(j == plen)
+                diff = false;
+        }
+        if(diff)
+        {
+            ++name;
+            q = p;
+            qlen = plen;
+        }
+        SA[m + (p >> 1)] = name;
+    }
+    return name;
+}
+
+// Induce the suffix array from the sorted LMS suffixes in the bucket ends
+static void sais_induce(const int32_t* s, int32_t* SA, const int32_t* C, int32_t* B, int32_t n, int32_t k)
+{
+    int32_t *b, i, j, c0, c1;
+
+    // L-type suffixes
+    sais_buckets(C, B, k, false);
+    j = n - 1;
+    b = SA + B[c1 = s[j]];
+    *b++ = (0 < j && s[j - 1] < c1) ? ~j : j;
+    for(i = 0; i < n; ++i)
+    {
+        j = SA[i];
+        SA[i] = ~j;
+        if(0 < j)
+        {
+            --j;
+            if((c0 = s[j]) != c1)
+            {
+                B[c1] = b - SA;
+                b = SA + B[c1 = c0];
+            }
+            *b++ = (0 < j && s[j - 1] < c1) ? ~j : j;
+        }
+    }
+
+    // S-type suffixes
+    sais_buckets(C, B, k, true);
+    for(i = n - 1, b = SA + B[c1 = 0]; 0 <= i; --i)
+    {
+        if(0 < (j = SA[i]))
+        {
+            --j;
+            if((c0 = s[j]) != c1)
+            {
+                B[c1] = b - SA;
+                b = SA + B[c1 = c0];
+            }
+            *--b = (j == 0 || s[j - 1] > c1) ? ~j : j;
+        }
+        else
+        {
+            SA[i] = ~j;
+        }
+    }
+}
+
+// Suffix array of s[0, n) over the symbols [0, k). The reduced problem is
+// solved in the same SA, which is why it needs no work space beyond the buckets
+static void sais(const int32_t* s, int32_t* SA, int32_t n, int32_t k)
+{
+    int32_t *b, i, j, m, p, q, name, c0, c1, t;
+    std::vector<int32_t> C(k), B(k);
+
+    // place the LMS positions in their bucket ends and sort the LMS substrings
+    sais_counts(s, C.data(), n, k);
+    sais_buckets(C.data(), B.data(), k, true);
+    std::fill(SA, SA + n, 0);
+    b = &t;
+    i = n - 1;
+    j = n;
+    m = 0;
+    c0 = s[n - 1];
+    do { c1 = c0; } while((0 <= --i) && ((c0 = s[i]) >= c1));
+    while(0 <= i)
+    {
+        do { c1 = c0; } while((0 <= --i) && ((c0 = s[i]) <= c1));
+        if(0 <= i)
+        {
+            *b = j;
+            b = SA + --B[c1];
+            j = i;
+            ++m;
+            do { c1 = c0; } while((0 <= --i) && ((c0 = s[i]) >= c1));
+        }
+    }
+
+    if(1 < m)
+    {
+        sais_lms_sort(s, SA, C.data(), B.data(), n, k);
+        name = sais_lms_name(s, SA, n, m);
+    }
+    else if(m == 1)
+    {
+        *b = j + 1;
+        name = 1;
+    }
+    else
+    {
+        name = 0;
+    }
+
+    // sort the reduced string, recursing if the names are not unique
+    if(name < m)
+    {
+        int32_t* RA = SA + n - m;
+        for(i = m + (n >> 1) - 1, j = m - 1; m <= i; --i)
+            if(SA[i] != 0)
+                RA[j--] = SA[i] - 1;
+        sais(RA, SA, m, name);
+
+        // map the reduced suffixes back to LMS positions
+        i = n - 1;
+        j = m - 1;
+        c0 = s[n - 1];
+        do { c1 = c0; } while((0 <= --i) && ((c0 = s[i]) >= c1));
+        while(0 <= i)
+        {
+            do { c1 = c0; } while((0 <= --i) && ((c0 = s[i]) <= c1));
+            if(0 <= i)
+            {
+                RA[j--] = i + 1;
+                do { c1 = c0; } while((0 <= --i) && ((c0 = s[i]) >= c1));
+            }
+        }
+        for(i = 0; i < m; ++i)
+            SA[i] = RA[SA[i]];
+    }
+
+    // put the sorted LMS suffixes in their bucket ends and induce the rest. A
+    // single LMS suffix is already in its bucket end
+    if(1 < m)
+    {
+        sais_buckets(C.data(), B.data(), k, true);
+        std::fill(SA + m, SA + n, 0);
+        i = m - 1;
+        j = n;
+        p = SA[m - 1];
+        c1 = s[p];
+        do
+        {
+            q = B[c0 = c1];
+            while(q < j)
+                SA[--j] = 0;
+            do
+            {
+                SA[--j] = p;
+                if(--i < 0)
+                    break;
+                p = SA[i];
+            } while((c1 = s[p]) == c0);
+        } while(0 <= i);
+        while(0 < j)
+            SA[--j] = 0;
+    }
+    sais_induce(s, SA, C.data(), B.data(), n, k);
+}
+
+// Pack the reads into the text. Text is a ReadTable or a PackedReadView
+template<typename Text>
+static bool sais_pack(SAISText& st, const Text& rt)
+{
+    size_t num_strings = rt.getCount();
+    size_t n = rt.countSumLengths() + num_strings + 1;
+    if(n + num_strings + 6 > (size_t)std::numeric_limits<int32_t>::max())
+        return false;
+
+    st.text.resize(n);
+    st.ids.resize(n);
+    st.starts.resize(num_strings);
+    st.K = num_strings + 5;
+
+    // symbols ranked as in the character comparison of saca_induced_copying:
+    // sentinels by read index, then A, C, G, other (eg N), T
+    int32_t code[256];
+    std::fill(code, code + 256, num_strings + 4);
+    code[(uint8_t)'A'] = num_strings + 1;
+    code[(uint8_t)'C'] = num_strings + 2;
+    code[(uint8_t)'G'] = num_strings + 3;
+    code[(uint8_t)'T'] = num_strings + 5;
+
+    size_t p = 0;
+    for(size_t i = 0; i < num_strings; ++i)
+    {
+        size_t len = rt.getReadLength(i);
+        st.starts[i] = p;
+        for(size_t j = 0; j < len; ++j)
+        {
+            st.ids[p] = i;
+            st.text[p++] = code[(uint8_t)rt.getChar(i, j)];
+        }
+        st.ids[p] = i;
+        st.text[p++] = i + 1;
+    }
+    st.text[p] = 0;
+    return true;
+}
+
+// Run SA-IS on the packed text and copy the (read, position) suffixes to pSA
+static void sais_fill(SAISText& st, SuffixArray* pSA, size_t num_strings)
+{
+    int32_t n = st.text.size();
+    st.sa.resize(n);
+    sais(st.text.data(), st.sa.data(), n, st.K + 1);
+
+    // the first suffix is the final 0, which is not part of the read table
+    pSA->initialize(n - 1, num_strings);
+    for(int32_t i = 1; i < n; ++i)
+    {
+        int32_t p = st.sa[i];
+        uint32_t id = st.ids[p];
+        pSA->set(i - 1, SAElem(id, p - st.starts[id]));
+    }
+}
+
+bool saca_induced_sort(SuffixArray* pSA, const ReadTable* pRT)
+{
+    SAISText st;
+    if(!sais_pack(st, *pRT))
+        return false;
+    sais_fill(st, pSA, pRT->getCount());
+    return true;
+}
+
+//
+template<typename Text>
+static bool sais_sort_pair(SuffixArray* pFwdSA, SuffixArray* pRevSA, const Text& rt)
+{
+    SAISText st;
+    if(!sais_pack(st, rt))
+        return false;
+    sais_fill(st, pFwdSA, rt.getCount());
+
+    // reverse each read in place, leaving the sentinels
+    for(size_t i = 0; i < rt.getCount(); ++i)
+    {
+        int32_t* b = st.text.data() + st.starts[i];
+        std::reverse(b, b + rt.getReadLength(i));
+    }
+    sais_fill(st, pRevSA, rt.getCount());
+    return true;
+}
+
+bool saca_induced_sort_pair(SuffixArray* pFwdSA, SuffixArray* pRevSA, const ReadTable* pRT)
+{
+    return sais_sort_pair(pFwdSA, pRevSA, *pRT);
+}
+
+bool saca_induced_sort_pair(SuffixArray* pFwdSA, SuffixArray* pRevSA, const PackedReadView& reads)
+{
+    return sais_sort_pair(pFwdSA, pRevSA, reads);
+}
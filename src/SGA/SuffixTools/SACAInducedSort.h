@@ -0,0 +1,29 @@
+//-----------------------------------------------
+// Released under the GPL license
+//-----------------------------------------------
+//
+// SACAInducedSort - SA-IS (Nong, Zhang, Chan 2009) over
+// the reads of a read table packed into one integer text.
+// Each read ends in its own sentinel, ranked by read index,
+// so the order is the same as saca_induced_copying: suffixes
+// equal up to the end of their reads are ordered by read index.
+//
+#ifndef SACA_INDUCED_SORT_H
+#define SACA_INDUCED_SORT_H
+
+#include "SuffixArray.h"
+#include "ReadTable.h"
+#include "PackedReadTable.h"
+
+// Build the suffix array of the reads in pRT.
+// Returns false, without touching pSA, if the text is too long for 32-bit positions
+bool saca_induced_sort(SuffixArray* pSA, const ReadTable* pRT);
+
+// Build the suffix arrays of the reads and of the reversed reads in one pass,
+// packing the text once and reusing the work space. The read table is not changed
+bool saca_induced_sort_pair(SuffixArray* pFwdSA, SuffixArray* pRevSA, const ReadTable* pRT);
+
+// As above, for the reads of a packed read table in the orientation of the view
+bool saca_induced_sort_pair(SuffixArray* pFwdSA, SuffixArray* pRevSA, const PackedReadView& reads);
+
+#endif
@@ -12,6 +12,7 @@
 #include "SuffixCompare.h"
 #include "mkqs.h"
 #include "SACAInducedCopying.h"
+#include "SACAInducedSort.h"
 #include "Timer.h"
 #include "SAReader.h"
 #include "SAWriter.h"
@@ -28,7 +29,8 @@ SuffixArray::SuffixArray(const std::string& filename)
 SuffixArray::SuffixArray(const ReadTable* pRT, int numThreads, bool silent)
 {
     //Timer timer("SuffixArray Construction", silent);
-    saca_induced_copying(this, pRT, numThreads, silent);
+    if(!saca_induced_sort(this, pRT))
+        saca_induced_copying(this, pRT, numThreads, silent);
 }
 
 // Initialize a suffix array for the strings in RT
@@ -0,0 +1,96 @@
+//-----------------------------------------------
+// Released under the GPL
+//-----------------------------------------------
+//
+// PackedReadTable - A 0-indexed table of 2-bit packed reads
+//
+#include "PackedReadTable.h"
+
+// 2-bit code of a base, or 4 for anything that can't be packed
+static uint8_t packCode(char b)
+{
+    switch(b)
+    {
+        case 'A': case 'a': return 0;
+        case 'C': case 'c': return 1;
+        case 'G': case 'g': return 2;
+        case 'T': case 't': return 3;
+        default: return 4;
+    }
+}
+
+//
+bool PackedReadTable::addRead(const std::string& id, const char* seq, size_t len, bool rc)
+{
+    for(size_t i = 0; i < len; ++i)
+    {
+        if(packCode(seq[i]) > 3)
+            return false;
+    }
+
+    if(rc)
+    {
+        for(size_t i = len; i > 0; --i)
+            append(3 - packCode(seq[i - 1]));
+    }
+    else
+    {
+        for(size_t i = 0; i < len; ++i)
+            append(packCode(seq[i]));
+    }
+    m_offsets.push_back(m_numBases);
+    m_ids.push_back(id);
+    return true;
+}
+
+//
+void PackedReadTable::addRead(const PackedReadTable& other, size_t idx)
+{
+    size_t len = other.getReadLength(idx);
+    for(size_t i = 0; i < len; ++i)
+        append(other.getBaseRank(idx, i));
+    m_offsets.push_back(m_numBases);
+    m_ids.push_back(other.getReadID(idx));
+}
+
+//
+std::string PackedReadTable::getSequence(size_t idx) const
+{
+    size_t len = getReadLength(idx);
+    std::string out(len, 'A');
+    for(size_t i = 0; i < len; ++i)
+        out[i] = getChar(idx, i);
+    return out;
+}
+
+//
+size_t PackedReadTable::getBytes() const
+{
+    size_t bytes = m_bases.capacity() * sizeof(uint64_t) + m_offsets.capacity() * sizeof(size_t) +
+                   m_ids.capacity() * sizeof(std::string);
+    for(size_t i = 0; i < m_ids.size(); ++i)
+    {
+        // ids too long for the string's own buffer are on the heap
+        if(m_ids[i].capacity() >= sizeof(std::string))
+            bytes += m_ids[i].capacity() + 1;
+    }
+    return bytes;
+}
+
+//
+void PackedReadTable::clear()
+{
+    m_ids.clear();
+    m_offsets.assign(1, 0);
+    m_bases.clear();
+    m_numBases = 0;
+}
+
+//
+void PackedReadTable::append(uint8_t rank)
+{
+    if((m_numBases & 31) == 0)
+        m_bases.push_back(0);
+    m_bases.back() |= (uint64_t)rank << (2 * (m_numBases & 31));
+    ++m_numBases;
+}
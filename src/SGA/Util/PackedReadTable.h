@@ -0,0 +1,125 @@
+//-----------------------------------------------
+// Released under the GPL
+//-----------------------------------------------
+//
+// PackedReadTable - A 0-indexed table of reads packed
+// 2 bits per base into one array, for the reads of a local
+// assembly. Reads are packed straight from a character buffer,
+// optionally reverse complemented, and are read back forward,
+// reversed or complemented through a PackedReadView without
+// copying them. Only A, C, G and T can be stored.
+//
+#ifndef PACKEDREADTABLE_H
+#define PACKEDREADTABLE_H
+
+#include <stdint.h>
+#include <assert.h>
+#include <string>
+#include <vector>
+
+class PackedReadTable;
+
+// The reads of a PackedReadTable, read in one orientation. Has the
+// parts of the ReadTable interface that suffix array and BWT
+// construction use
+class PackedReadView
+{
+    public:
+
+        PackedReadView(const PackedReadTable* pRT, bool reversed, bool complemented) : m_pRT(pRT),
+                                                                                     m_reversed(reversed),
+                                                                                     m_complemented(complemented) {}
+
+        size_t getCount() const;
+        size_t getReadLength(size_t idx) const;
+        size_t countSumLengths() const;
+
+        // Get a particular character for a particular read
+        inline char getChar(size_t str_idx, size_t char_idx) const;
+
+    private:
+
+        const PackedReadTable* m_pRT;
+        bool m_reversed;
+        bool m_complemented;
+};
+
+class PackedReadTable
+{
+    public:
+
+        PackedReadTable() : m_offsets(1, 0), m_numBases(0) {}
+
+        // Add the len bases of seq as a read, reverse complemented if rc is set.
+        // Returns false, and adds nothing, if seq has a base other than A, C, G or T
+        bool addRead(const std::string& id, const char* seq, size_t len, bool rc = false);
+
+        // Copy read idx of another table, without unpacking it
+        void addRead(const PackedReadTable& other, size_t idx);
+
+        size_t getCount() const { return m_ids.size(); }
+        size_t getReadLength(size_t idx) const { return m_offsets[idx + 1] - m_offsets[idx]; }
+        size_t countSumLengths() const { return m_offsets.back(); }
+        const std::string& getReadID(size_t idx) const { return m_ids[idx]; }
+
+        // 2-bit code (A=0, C=1, G=2, T=3) of a base of a read
+        inline uint8_t getBaseRank(size_t str_idx, size_t char_idx) const
+        {
+            assert(str_idx < getCount() && char_idx < getReadLength(str_idx));
+            size_t pos = m_offsets[str_idx] + char_idx;
+            return (m_bases[pos >> 5] >> (2 * (pos & 31))) & 3;
+        }
+
+        inline char getChar(size_t str_idx, size_t char_idx) const
+        {
+            return "ACGT"[getBaseRank(str_idx, char_idx)];
+        }
+
+        // Unpack a read
+        std::string getSequence(size_t idx) const;
+
+        // The reads in one orientation, without copying them
+        PackedReadView getView(bool reversed = false, bool complemented = false) const
+        {
+            return PackedReadView(this, reversed, complemented);
+        }
+
+        // Memory held by the table
+        size_t getBytes() const;
+
+        void clear();
+
+    private:
+
+        void append(uint8_t rank);
+
+        std::vector<std::string> m_ids;
+        std::vector<size_t> m_offsets; // start of each read in m_bases, then the total length
+        std::vector<uint64_t> m_bases; // 32 bases per word
+        size_t m_numBases;
+};
+
+inline size_t PackedReadView::getCount() const
+{
+    return m_pRT->getCount();
+}
+
+inline size_t PackedReadView::getReadLength(size_t idx) const
+{
+    return m_pRT->getReadLength(idx);
+}
+
+inline size_t PackedReadView::countSumLengths() const
+{
+    return m_pRT->countSumLengths();
+}
+
+inline char PackedReadView::getChar(size_t str_idx, size_t char_idx) const
+{
+    if(m_reversed)
+        char_idx = m_pRT->getReadLength(str_idx) - 1 - char_idx;
+    uint8_t rank = m_pRT->getBaseRank(str_idx, char_idx);
+    return "ACGT"[m_complemented ? 3 - rank : rank];
+}
+
+#endif
@@ -21,6 +21,16 @@ ReadInfoTable::ReadInfoTable(ReadTable *pRT) : m_numericIDs(false) {
   }
 }
 
+//
+ReadInfoTable::ReadInfoTable(const PackedReadTable *pRT) : m_numericIDs(false) {
+  m_lengths.reserve(pRT->getCount());
+  m_ids.reserve(pRT->getCount());
+  for (size_t i = 0; i < pRT->getCount(); i++) {
+    m_lengths.push_back(pRT->getReadLength(i));
+    m_ids.push_back(pRT->getReadID(i));
+  }
+}
+
 // Read the sequences from a file
 ReadInfoTable::ReadInfoTable(std::string filename, 
                              size_t num_expected, 
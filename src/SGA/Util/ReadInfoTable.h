@@ -12,6 +12,7 @@
 #include "Util.h"
 #include "SeqReader.h"
 #include "ReadTable.h"
+#include "PackedReadTable.h"
 #include <map>
 
 enum ReadInfoOption
@@ -36,6 +37,7 @@ class ReadInfoTable
         //
         ReadInfoTable() {}
         ReadInfoTable(ReadTable *pRT);
+        ReadInfoTable(const PackedReadTable *pRT);
 
         // Load the table using the read in filename
         // If num_expected > 0, reserve room in the table for num_expected reads
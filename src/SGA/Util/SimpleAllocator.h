@@ -6,7 +6,11 @@
 //
 // SimpleAllocator - High-level manager of SimplePool
 // memory pools. See SimplePool.h for description of allocation
-// strategy
+// strategy. The pools start small and double in size, up to
+// SimplePool::NUM_OBJECTS, so an allocator per local assembly
+// graph does not reserve megabytes for a few hundred reads.
+// All of the memory is freed at once when the allocator is
+// destroyed.
 //
 #ifndef SIMPLEALLOCATOR_H
 #define SIMPLEALLOCATOR_H
@@ -37,7 +41,10 @@ class SimpleAllocator
             if(m_pPoolList.empty() || m_pPoolList.back()->isFull())
             {
                 // new storage must be allocated
-                m_pPoolList.push_back(new StorageType);
+                size_t num_objects = m_pPoolList.empty() ? FIRST_POOL_OBJECTS : 2 * m_pPoolList.back()->getCapacity();
+                if(num_objects > StorageType::NUM_OBJECTS)
+                    num_objects = StorageType::NUM_OBJECTS;
+                m_pPoolList.push_back(new StorageType(num_objects));
             }
 
             // allocate from the last pool
@@ -51,6 +58,8 @@ class SimpleAllocator
 
     private:
 
+        static const size_t FIRST_POOL_OBJECTS = 256;
+
         StorageList m_pPoolList;
 };
 
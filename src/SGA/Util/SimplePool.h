@@ -20,10 +20,10 @@ class SimplePool
 {
     public:
 
-        SimplePool()
+        SimplePool(size_t num_objects = NUM_OBJECTS)
         {
             size_t bytes_per_object = sizeof(T);
-            size_t total_bytes = NUM_OBJECTS * bytes_per_object;
+            size_t total_bytes = num_objects * bytes_per_object;
             m_pPool = malloc(total_bytes);
             if(m_pPool == NULL)
             {
@@ -60,12 +60,15 @@ class SimplePool
             return m_used >= m_capacity;
         }
 
+        size_t getCapacity() const { return m_capacity / sizeof(T); }
+
+        static const size_t NUM_OBJECTS = 50*1024;
+
     private:
 
         void* m_pPool;
         size_t m_capacity;
         size_t m_used;
-        static const size_t NUM_OBJECTS = 50*1024;
 };
 
 #endif
@@ -142,22 +142,25 @@ void AlignedContig::blacklist(SeqLib::GRC &grv) {
   }
   
   void AlignedContig::splitCoverage() { 
+
+    // one pass over the reads for all the breakpoints on this contig
+    ContigReadTable tab(m_bamreads, getContigName());
     
     for (auto& i : m_local_breaks_secondaries) 
-      i.splitCoverage(m_bamreads);
+      i.splitCoverage(tab);
 
     for (auto& i : m_global_bp_secondaries) 
-      i.splitCoverage(m_bamreads);
+      i.splitCoverage(tab);
 
     for (auto& i : m_frag_v) 
       for (auto& j : i.m_indel_breaks) 
-      j.splitCoverage(m_bamreads);
+      j.splitCoverage(tab);
     
     for (auto& i : m_local_breaks) 
-      i.splitCoverage(m_bamreads);
+      i.splitCoverage(tab);
     
     if (!m_global_bp.isEmpty()) 
-      m_global_bp.splitCoverage(m_bamreads);
+      m_global_bp.splitCoverage(tab);
     
   }
  
@@ -440,7 +443,7 @@ bool AlignedContig::checkLocal(const SeqLib::GenomicRegion& window)
   }
   
   
-void AlignedContig::checkAgainstCigarMatches(const std::unordered_map<std::string, SeqLib::CigarMap>& cmap) {
+void AlignedContig::checkAgainstCigarMatches(const std::unordered_map<std::string, IndelCigarMap>& cmap) {
 
     for (auto& i : m_frag_v)
       i.indelCigarMatches(cmap);
@@ -32,7 +32,7 @@ class AlignedContig {
   SeqLib::GenomicRegionVector getAsGenomicRegionVector() const;
 
   // Loop through all the alignment framgents and their indel breaks and check against cigar database
-  void checkAgainstCigarMatches(const std::unordered_map<std::string, SeqLib::CigarMap>& cmap); 
+  void checkAgainstCigarMatches(const std::unordered_map<std::string, IndelCigarMap>& cmap); 
 
   // apply repeat filter to each indel break
   void assessRepeats();
@@ -138,21 +138,21 @@ std::string AlignmentFragment::print() const {
 }
 
 
-void AlignmentFragment::indelCigarMatches(const std::unordered_map<std::string, SeqLib::CigarMap>& cmap) {
+void AlignmentFragment::indelCigarMatches(const std::unordered_map<std::string, IndelCigarMap>& cmap) {
 
     // loop through the indel breakpoints
     for (auto& i : m_indel_breaks) {
       
       assert(i.getSpan() > 0);
 
-      // get the hash string in same formate as cigar map (eg. pos_3D)
-      std::string st = i.getHashString();
+      // look up the indel as the walker stored it (chr, pos, span, D or I)
+      char type = i.insertion.length() == 0 ? 'D' : 'I';
 
       for (auto& c : cmap) {
-	SeqLib::CigarMap::const_iterator ff = c.second.find(st);
+	size_t n = c.second.count(i.b1.gr.chr, i.b1.gr.pos1, i.getSpan(), type);
 	// if it is, add it
-	if (ff != c.second.end()) {
-	  i.allele[c.first].cigar = ff->second;	  
+	if (n) {
+	  i.allele[c.first].cigar = n;	  
 	}
       }
     }      
@@ -8,6 +8,7 @@
 #include <string>
 #include <set>
 #include "BreakPoint.h"
+#include "IndelCigarMap.h"
 #include "svaba_params.h"
 
 #define MAX_CONTIG_SIZE 5000000
@@ -34,7 +35,7 @@ class AlignedContig;
     // sort AlignmentFragment objects by start position
     bool operator < (const AlignmentFragment& str) const { return (start < str.start); }
 
-    void indelCigarMatches(const std::unordered_map<std::string, SeqLib::CigarMap>& cmap);
+    void indelCigarMatches(const std::unordered_map<std::string, IndelCigarMap>& cmap);
     
     // print the AlignmentFragment
     std::string print() const;
@@ -0,0 +1,160 @@
+#include "AssemblyCache.h"
+
+#include <cstring>
+#include <fstream>
+
+#include "svaba_params.h"
+#include "svabaUtils.h"
+
+using svabaUtils::mix64;
+
+// first bytes of a cache file. Last character is the format version
+static const char ASSEMBLY_CACHE_MAGIC[] = "SVASMC01";
+#define ASSEMBLY_CACHE_MAGIC_LEN 8
+
+// sums of two independent hashes of each read, so the key is the same for any read order
+void AssemblyFingerprint::add(const std::string& seq) {
+  uint64_t h = svabaUtils::fnv1a(seq);
+  m_sum1 += mix64(h);
+  m_sum2 += mix64(h ^ 0x9e3779b97f4a7c15ULL);
+  ++m_count;
+}
+
+AssemblyKey AssemblyFingerprint::key(double error_rate, size_t min_overlap, size_t readlen, int num_assembly_rounds, 
+				     AssemblerType assembler) const {
+
+  uint64_t er;
+  static_assert(sizeof(er) == sizeof(error_rate), "double is not 64 bits");
+  memcpy(&er, &error_rate, sizeof(er));
+
+  uint64_t p = mix64(er);
+  p = mix64(p ^ min_overlap);
+  p = mix64(p ^ readlen);
+  p = mix64(p ^ (uint64_t)num_assembly_rounds);
+  p = mix64(p ^ m_count);
+  if (assembler != ASSEMBLER_SGA)
+    p = mix64(p ^ ((uint64_t)assembler << 32));
+
+  AssemblyKey k;
+  k.a = mix64(m_sum1 ^ p);
+  k.b = mix64(m_sum2 + p);
+  return k;
+}
+
+AssemblyCache::AssemblyCache() {
+  pthread_mutex_init(&m_lock, NULL);
+}
+
+AssemblyCache::~AssemblyCache() {
+  pthread_mutex_destroy(&m_lock);
+}
+
+// a string as a 32-bit length, then its bytes
+static void __write_string(std::ofstream& out, const std::string& s) {
+  uint32_t len = s.length();
+  out.write((const char*)&len, sizeof(uint32_t));
+  out.write(s.data(), len);
+}
+
+static bool __read_string(std::ifstream& in, std::string& s) {
+  uint32_t len;
+  if (!in.read((char*)&len, sizeof(uint32_t)))
+    return false;
+  s.resize(len);
+  return len == 0 || in.read(&s[0], len);
+}
+
+bool AssemblyCache::Open(const std::string& file) {
+
+  m_file = file;
+
+  std::ifstream in(file.c_str(), std::ios::binary);
+  if (!in)
+    return true; // new cache
+
+  char magic[ASSEMBLY_CACHE_MAGIC_LEN];
+  if (!in.read(magic, ASSEMBLY_CACHE_MAGIC_LEN) || memcmp(magic, ASSEMBLY_CACHE_MAGIC, ASSEMBLY_CACHE_MAGIC_LEN))
+    return false;
+
+  // entries: key, number of contigs, then name suffix, sequence and quality of each
+  AssemblyKey k;
+  uint32_t n;
+  while (in.read((char*)&k.a, sizeof(uint64_t)) && in.read((char*)&k.b, sizeof(uint64_t)) &&
+	 in.read((char*)&n, sizeof(uint32_t))) {
+    SeqLib::UnalignedSequenceVector& v = m_map[k];
+    v.resize(n);
+    for (auto& u : v)
+      if (!__read_string(in, u.Name) || !__read_string(in, u.Seq) || !__read_string(in, u.Qual))
+	return false;
+  }
+
+  return true;
+
+}
+
+long AssemblyCache::Save() const {
+
+  if (m_file.empty())
+    return 0;
+
+  std::ofstream out(m_file.c_str(), std::ios::binary);
+  if (!out)
+    return -1;
+
+  pthread_mutex_lock(&m_lock);
+  out.write(ASSEMBLY_CACHE_MAGIC, ASSEMBLY_CACHE_MAGIC_LEN);
+  for (auto& e : m_map) {
+    uint32_t n = e.second.size();
+    out.write((const char*)&e.first.a, sizeof(uint64_t));
+    out.write((const char*)&e.first.b, sizeof(uint64_t));
+    out.write((const char*)&n, sizeof(uint32_t));
+    for (auto& u : e.second) {
+      __write_string(out, u.Name);
+      __write_string(out, u.Seq);
+      __write_string(out, u.Qual);
+    }
+  }
+  long count = m_map.size();
+  pthread_mutex_unlock(&m_lock);
+
+  return out ? count : -1;
+
+}
+
+bool AssemblyCache::Find(const AssemblyKey& key, const std::string& id, SeqLib::UnalignedSequenceVector& contigs) {
+
+  pthread_mutex_lock(&m_lock);
+  ++m_lookups;
+  auto ff = m_map.find(key);
+  bool hit = ff != m_map.end();
+  if (hit) {
+    ++m_hits;
+    contigs = ff->second;
+  }
+  pthread_mutex_unlock(&m_lock);
+
+  for (auto& u : contigs)
+    u.Name = id + u.Name;
+  return hit;
+
+}
+
+void AssemblyCache::Insert(const AssemblyKey& key, const std::string& id, const SeqLib::UnalignedSequenceVector& contigs) {
+
+  // store the names without the window name
+  SeqLib::UnalignedSequenceVector v = contigs;
+  for (auto& u : v)
+    if (!u.Name.compare(0, id.length(), id))
+      u.Name = u.Name.substr(id.length());
+
+  pthread_mutex_lock(&m_lock);
+  if (m_map.insert(std::make_pair(key, std::move(v))).second && m_file.empty()) {
+    m_order.push_back(key);
+    if (m_order.size() > ASSEMBLY_CACHE_MAX_ENTRIES) {
+      m_map.erase(m_order.front());
+      m_order.pop_front();
+    }
+  }
+  pthread_mutex_unlock(&m_lock);
+
+}
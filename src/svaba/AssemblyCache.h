@@ -0,0 +1,100 @@
+#ifndef SVABA_ASSEMBLY_CACHE_H__
+#define SVABA_ASSEMBLY_CACHE_H__
+
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "SeqLib/UnalignedSequence.h"
+
+/** Assembler that made a cached assembly. SGA is 0, so keys from before there was a choice stay valid */
+enum AssemblerType { ASSEMBLER_SGA = 0, ASSEMBLER_FML = 1 };
+
+/** Order-independent fingerprint of the reads and parameters of one assembly */
+struct AssemblyKey {
+
+  uint64_t a = 0;
+  uint64_t b = 0;
+
+  bool operator==(const AssemblyKey& k) const { return a == k.a && b == k.b; }
+
+};
+
+struct AssemblyKeyHash {
+  size_t operator()(const AssemblyKey& k) const { return k.a; }
+};
+
+/** Builds an AssemblyKey one read at a time, in any order */
+class AssemblyFingerprint {
+
+ public:
+
+  void add(const std::string& seq);
+
+  /** Finish the key by mixing in the assembly parameters */
+  AssemblyKey key(double error_rate, size_t min_overlap, size_t readlen, int num_assembly_rounds, 
+		  AssemblerType assembler = ASSEMBLER_SGA) const;
+
+ private:
+
+  uint64_t m_sum1 = 0;
+  uint64_t m_sum2 = 0;
+  uint64_t m_count = 0;
+
+};
+
+/** Contigs of previous assemblies, keyed by the fingerprint of their read set.
+ *
+ * Neighboring windows overlap, and reruns over the same BAMs with different
+ * downstream parameters give the assembler exactly the same reads, so a hit
+ * skips the assembly. Contig names are stored without the window name, and are
+ * re-prefixed with the name of the window asking. Held in memory, with the
+ * oldest entries dropped past a cap, unless a file is given to load from and
+ * save to, in which case every entry is kept.
+ */
+class AssemblyCache {
+
+ public:
+
+  AssemblyCache();
+
+  ~AssemblyCache();
+
+  /** Load the entries of a cache file, if it exists, and save to it at the end of the run.
+   * @return false if the file exists but is not a cache file
+   */
+  bool Open(const std::string& file);
+
+  /** Write all of the entries to the file given to Open
+   * @return number of entries written, or -1 if the file could not be written
+   */
+  long Save() const;
+
+  /** Look up an assembly. On a hit, fill contigs with names starting with id */
+  bool Find(const AssemblyKey& key, const std::string& id, SeqLib::UnalignedSequenceVector& contigs);
+
+  /** Store the contigs from an assembly of window id */
+  void Insert(const AssemblyKey& key, const std::string& id, const SeqLib::UnalignedSequenceVector& contigs);
+
+  size_t NumHits() const { return m_hits; }
+  size_t NumLookups() const { return m_lookups; }
+  size_t size() const { return m_map.size(); }
+
+ private:
+
+  std::unordered_map<AssemblyKey, SeqLib::UnalignedSequenceVector, AssemblyKeyHash> m_map;
+
+  std::deque<AssemblyKey> m_order; // insertion order, to drop the oldest when not persisting
+
+  std::string m_file;
+
+  size_t m_hits = 0;
+  size_t m_lookups = 0;
+
+  mutable pthread_mutex_t m_lock;
+
+};
+
+#endif
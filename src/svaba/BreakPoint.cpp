@@ -43,17 +43,47 @@ static std::unordered_map<int, double> ERROR_RATES = {{0, scale_factor * 1e-4},
 
 using namespace SeqLib;
 
+// text of the evidence and confidence codes, in enum order
+static const char* EVIDENCE_STRINGS[EVDNC_COUNT] = {"", "INDEL", "ASDIS", "DSCRD", "ASSMB", "TSI_G", "TSI_L"};
+
+static const char* CONFIDENCE_STRINGS[CONF_COUNT] = {
+  "", "PASS", "NOLOCAL", "LOCALMATCH", "DUPREADS", "NODISC", "TOOSHORT",
+  "BLACKLIST", "LOWMAPQ", "LOWAS", "LOWSPLITSMALL", "LOWICSUPPORT",
+  "LOWMATCHLEN", "MULTIMATCH", "SECONDARY", "WEAKSUPPORTHIREP", "LOWQINVERSION",
+  "SIMPLESEQUENCE", "HIGHHOMOLOGY", "LOWSUPPORT", "LOWSPANDSCRD", "LOWMAPQDISC",
+  "COMPETEDISC", "WEAKDISC", "LOWLOD", "VLOWAF", "SHORTALIGNMENT", "NONVAR",
+  "SINGLEBX", "REPVAR"};
+
+const char* EvidenceString(BreakPointEvidence e) {
+  return e < EVDNC_COUNT ? EVIDENCE_STRINGS[e] : "";
+}
+
+const char* ConfidenceString(BreakPointConfidence c) {
+  return c < CONF_COUNT ? CONFIDENCE_STRINGS[c] : "";
+}
+
+BreakPointEvidence ParseEvidence(const std::string& s) {
+  for (int i = 1; i < EVDNC_COUNT; ++i)
+    if (s == EVIDENCE_STRINGS[i])
+      return (BreakPointEvidence)i;
+  return EVDNC_NONE;
+}
+
+BreakPointConfidence ParseConfidence(const std::string& s) {
+  for (int i = 1; i < CONF_COUNT; ++i)
+    if (s == CONFIDENCE_STRINGS[i])
+      return (BreakPointConfidence)i;
+  return CONF_NONE;
+}
+
   double __myround(double x) { return std:: floor(x * 10) / 10; }
 
   // make the file string
-  std::string BreakPoint::toFileString(bool noreads) {
-    
+  void BreakPoint::prep_output(bool noreads) {
+
     // make sure we already ran scoring
-    assert(evidence.length());
-    assert(confidence.length());
-    
-    std::string sep = "\t";
-    std::stringstream ss;
+    assert(evidence != EVDNC_NONE);
+    assert(confidence != CONF_NONE);
     
     // put the read names into a string
     if (!noreads)  
@@ -62,9 +92,23 @@ using namespace SeqLib;
     // make the BX table
     format_bx_string();
 
+  }
+
+  double BreakPoint::getMaxLod() const {
     double max_lod = 0;
     for (auto& s : allele) 
       max_lod = std::max(max_lod, s.second.LO);
+    return max_lod;
+  }
+
+  std::string BreakPoint::toFileString(bool noreads) {
+    
+    prep_output(noreads);
+
+    std::string sep = "\t";
+    std::stringstream ss;
+    
+    double max_lod = getMaxLod();
 
     ss << b1.chr_name << sep << b1.gr.pos1 << sep << b1.gr.strand << sep //1-3
        << b2.chr_name << sep << b2.gr.pos1 << sep << b2.gr.strand << sep //4-6
@@ -80,7 +124,7 @@ using namespace SeqLib;
        << (insertion.length() ? insertion : "x") << sep 
        << cname << sep
        << num_align << sep 
-       << confidence << sep << evidence << sep
+       << ConfidenceString(confidence) << sep << EvidenceString(evidence) << sep
        << quality << sep
        << secondary << sep << somatic_score << sep << somatic_lod << sep 
        << max_lod << sep 
@@ -273,8 +317,8 @@ BreakPoint::BreakPoint(const std::string &line, const SeqLib::BamHeader& h) {
 	case 23: insertion = (val == "x" ? "" : val); break;
 	case 24: cname = val; break;
 	case 25: num_align = std::stoi(val); break;
-	case 26: confidence = val; break;
-	case 27: evidence = val; break;
+	case 26: confidence = ParseConfidence(val); break;
+	case 27: evidence = ParseEvidence(val); break;
 	case 28: quality = std::stoi(val); break;
 	case 29: secondary = val == "1";
 	case 30: somatic_score = std::stod(val); break;
@@ -287,7 +331,7 @@ BreakPoint::BreakPoint(const std::string &line, const SeqLib::BamHeader& h) {
 	case 37: read_names = val; break;
 	case 38: bxtable = val; break;
         default: 
-	  aaa.indel = evidence == "INDEL";
+	  aaa.indel = evidence == EVDNC_INDEL;
 	  aaa.fromString(val);
 	  id += "A";
 	  allele[id] = aaa; //id is dummy. just keep in order as came in;
@@ -307,20 +351,66 @@ BreakPoint::BreakPoint(const std::string &line, const SeqLib::BamHeader& h) {
 
   }
   
+ContigReadTable::ContigReadTable(svabaReadVector& r, const std::string& cname) : reads(r) {
+
+  size_t n = reads.size();
+  aln.reserve(n); start.reserve(n); end.reserve(n); qname.reserve(n); sample.reserve(n);
+  tumor.reserve(n); first.reserve(n); homopolymer.reserve(n);
+  op_start.reserve(n + 1);
+  op_start.push_back(0);
+
+  std::unordered_map<std::string, uint32_t> qname_ids;
+  for (auto& j : reads) {
+
+    r2c& this_r2c = j.GetR2C(cname);
+    aln.push_back(&this_r2c);
+    start.push_back(this_r2c.start_on_contig);
+    end.push_back(this_r2c.end_on_contig);
+
+    qname.push_back(qname_ids.insert(std::pair<std::string, uint32_t>(j.Qname(), qname_ids.size())).first->second);
+
+    std::string prefix = j.Prefix();
+    size_t s = std::find(samples.begin(), samples.end(), prefix) - samples.begin();
+    if (s == samples.size())
+      samples.push_back(prefix);
+    sample.push_back((uint16_t)s);
+
+    tumor.push_back(j.Tumor());
+    first.push_back(j.FirstFlag());
+
+    // if this is a nasty repeat, don't trust non-perfect alignments on r2c alignment
+    homopolymer.push_back(__check_homopolymer(j.Sequence()));
+
+    // positions on contig (from start of read alignment) of the r2c indels
+    int pos = 0;
+    for (auto& i : this_r2c.cig) {
+      if (i.Type() == 'D' || i.Type() == 'I') {
+	op_pos.push_back(pos);
+	op_del.push_back(i.Type() == 'D');
+      }
+      if (i.ConsumesReference())
+	pos += i.Length();
+    }
+    op_start.push_back(op_pos.size());
+  }
+  num_qnames = qname_ids.size();
+
+}
+
 //void BreakPoint::splitCoverage(SeqLib::BamRecordVector &bav) {
-  void BreakPoint::splitCoverage(svabaReadVector &bav) {
+  void BreakPoint::splitCoverage(ContigReadTable &tab) {
     
     // track if first and second mate covers same split. fishy and remove them both
-    std::unordered_map<std::string, bool> qname_and_num;
+    std::vector<bool> qname_seen(tab.num_qnames), qname_first(tab.num_qnames);
 
     // keep track of which reads already added
-    std::unordered_set<std::string> qnames;
+    std::vector<bool> qnames(tab.num_qnames);
 
     // keep track of reads to reject
-    std::set<std::string> reject_qnames;
+    std::vector<bool> reject_qnames(tab.num_qnames);
 
-    // keep track of which SR tags are valid splits
-    std::unordered_set<std::string> valid_reads;
+    // keep track of which reads are valid splits
+    std::vector<bool> valid_reads(tab.size());
 
     // get the homology length. useful bc if read alignment ends in homologous region, it is not split
     int homlen = b1.cpos - b2.cpos;
@@ -328,65 +418,41 @@ BreakPoint::BreakPoint(const std::string &line, const SeqLib::BamHeader& h) {
       homlen = 0;
    
     // loop all of the read to contig alignments for this contig
-    for (auto& j : bav) {
-
-      r2c& this_r2c = j.GetR2C(cname);
+    for (size_t r = 0; r < tab.size(); ++r) {
 
       bool read_should_be_skipped = false;
       if (num_align == 1) {
 
-	std::vector<int> del_breaks;
-	std::vector<int> ins_breaks;
-	int pos = 0;
-	
 	// if this is a nasty repeat, don't trust non-perfect alignmentx on r2c alignment
-	if (__check_homopolymer(j.Sequence())) 
+	if (tab.homopolymer[r]) 
 	  read_should_be_skipped = true;
 	
-	// loop through r2c cigar and see positions
-	for(auto& i : this_r2c.cig) {
-	  
-	  if (i.Type() == 'D') 
-	    del_breaks.push_back(pos);
-	  else if (i.Type() == 'I')
-	    ins_breaks.push_back(pos);
-	  
-	  // update position on contig
-	  if (i.ConsumesReference())
-	    pos += i.Length(); // update position on contig
-	  
-	}
-	
 	size_t buff = std::max((size_t)3, repeat_seq.length() + 3);
-	for (auto& i : del_breaks)
-	  if (i > b1.cpos - buff || i < b1.cpos + buff) // if start of insertion is at start of a del of r2c
-	    read_should_be_skipped = true;
-	for (auto& i : ins_breaks)
+	for (uint32_t o = tab.op_start[r]; o < tab.op_start[r + 1]; ++o) {
+	  int i = tab.op_pos[o];
 	  if (i > b1.cpos - buff || i < b1.cpos + buff) // if start of insertion is at start of a del of r2c
 	    read_should_be_skipped = true;
+	}
       } 
 
       if (read_should_be_skipped)  // default is r2c does not support var, so don't amend this_r2c
 	continue;
       
-      // get read ID
-      std::string sample_id = j.Prefix(); //substr(0,4); // maybe just make this prefix
-      std::string sr = j.SR(); 
+      bool tumor = tab.tumor[r];
 
       // need read to cover past variant by some buffer. If there is a repeat,
       // then this needs to be even longer to avoid ambiguity
       int this_tbuff = T_SPLIT_BUFF + repeat_seq.length();
       int this_nbuff = N_SPLIT_BUFF + repeat_seq.length();      
 
-      int rightbreak1 = b1.cpos + (j.Tumor() ? this_tbuff : this_nbuff); // read must extend this far right of break1
-      int leftbreak1  = b1.cpos - (j.Tumor() ? this_tbuff : this_nbuff); // read must extend this far left of break1
-      int rightbreak2 = b2.cpos + (j.Tumor() ? this_tbuff : this_nbuff);
-      int leftbreak2  = b2.cpos - (j.Tumor() ? this_tbuff : this_nbuff);
+      int rightbreak1 = b1.cpos + (tumor ? this_tbuff : this_nbuff); // read must extend this far right of break1
+      int leftbreak1  = b1.cpos - (tumor ? this_tbuff : this_nbuff); // read must extend this far left of break1
+      int rightbreak2 = b2.cpos + (tumor ? this_tbuff : this_nbuff);
+      int leftbreak2  = b2.cpos - (tumor ? this_tbuff : this_nbuff);
 
-      std::string contig_qname; // for sanity checking
       // get the alignment position on contig
-      int pos = this_r2c.start_on_contig;
-      int te  = this_r2c.end_on_contig;
+      int pos = tab.start[r];
+      int te  = tab.end[r];
 
       int rightend = te; 
       int leftend  = pos;
@@ -397,7 +463,7 @@ BreakPoint::BreakPoint(const std::string &line, const SeqLib::BamHeader& h) {
       bool one_split = issplit1 || issplit2;
 
       // be more permissive for NORMAL, so keep out FPs
-      bool valid  = (both_split && (j.Tumor() || homlen > 0)) || (one_split && !j.Tumor() && homlen == 0) || (one_split && insertion.length() >= INSERT_SIZE_TOO_BIG_SPAN_READS);
+      bool valid  = (both_split && (tumor || homlen > 0)) || (one_split && !tumor && homlen == 0) || (one_split && insertion.length() >= INSERT_SIZE_TOO_BIG_SPAN_READS);
       // requiring both break ends to be split for homlen > 0 is for situation beow
       // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>A..........................
       // ............................B>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
@@ -407,36 +473,25 @@ BreakPoint::BreakPoint(const std::string &line, const SeqLib::BamHeader& h) {
       // insertions at junctions, where one can split at one and not the other because of the intervening sequence buffer
 
       // check that deletion (in read to contig coords) doesn't cover break point
-      size_t p = pos; // move along on contig, starting at first non-clipped base
-      for (SeqLib::Cigar::const_iterator c = this_r2c.cig.begin(); c != this_r2c.cig.end(); ++c) {
-	if (c->Type() == 'D') { 
-	  if ( (p >= leftbreak1 && p <= rightbreak1) || (p >= leftbreak2 && p <= rightbreak2) )
-	    read_should_be_skipped = true;
-	}
-	if (c->ConsumesReference()) // if it moves it along the contig
-	  p += c->Length();
+      for (uint32_t o = tab.op_start[r]; o < tab.op_start[r + 1]; ++o) {
+	int p = pos + tab.op_pos[o]; // position on contig
+	if (tab.op_del[o] && ( (p >= leftbreak1 && p <= rightbreak1) || (p >= leftbreak2 && p <= rightbreak2) ))
+	  read_should_be_skipped = true;
       }
 
-      //debug
-      /*if (sr == "t000_163_H01PEALXX140819:2:2202:14804:18907")
-	std::cerr << " te " << te << " pos " << pos << " CIG " << j.GetZTag("SC") << " SL " << j.GetZTag("SL") << " SE " << j.GetZTag("SE") << 
-	  " leftbreak " << leftbreak1 << " rightbreak " << rightbreak1 << " leftbreak2 " << leftbreak2 << " rightbreak2 " << rightbreak2 << 
-	  " issplit1 " << issplit1 << " issplit2 " << issplit2 << " valid " << valid << std::endl;
-      */
-
       // add the split reads for each end of the break
       // a read is split if it is spans both break ends for tumor, one break end for normal (to
       // be more sensitive to germline) and if it spans both ends for deletion (should be next to 
       // each other), or one end for insertions larger than 10, or this is a complex breakpoint
 
       if (valid) { 
-	std::string qn = j.Qname();
+	uint32_t qn = tab.qname[r];
 
 	// if read seen and other read was other mate, then reject
-	if (num_align > 1 && qname_and_num.count(qn) && qname_and_num[qn] != j.FirstFlag()) {
+	if (num_align > 1 && qname_seen[qn] && qname_first[qn] != tab.first[r]) {
 	  // need to reject all reads of this qname
 	  // because we saw both first and second in pair hit same split
-	  reject_qnames.insert(qn);
+	  reject_qnames[qn] = true;
 	  
 	} else {
 
@@ -444,12 +499,14 @@ BreakPoint::BreakPoint(const std::string &line, const SeqLib::BamHeader& h) {
 	  // e.g. if we see a split read with first designation, we want to reject all reads with same qname if at any time
 	  // we see one with second mate designation. If we don't have this conditional, we can get fooled if the order is 
 	  // 1, 2, 1
-	  if (!qname_and_num.count(qn)) 
-	    qname_and_num[qn] = j.FirstFlag();
+	  if (!qname_seen[qn]) {
+	    qname_seen[qn] = true;
+	    qname_first[qn] = tab.first[r];
+	  }
 	  
 	  // this is a valid read
-	  this_r2c.supports_var = true;
-	  valid_reads.insert(sr);
+	  tab.aln[r]->supports_var = true;
+	  valid_reads[r] = true;
 
 	  // how much of the contig do these span
 	  // for a given read QNAME, get the coverage that 
@@ -460,38 +517,33 @@ BreakPoint::BreakPoint(const std::string &line, const SeqLib::BamHeader& h) {
 
       // update the counters for each break end
       if (issplit1 && valid)
-	++b1.split[sample_id];
+	++b1.split[tab.samples[tab.sample[r]]];
       if (issplit2 && valid)
-	++b2.split[sample_id];	
-
-      // add r2c back, but as amended
-      //j.AddR2C(cname, this_r2c);
+	++b2.split[tab.samples[tab.sample[r]]];
 
     } // end read loop
 
     // process valid reads
-    for (auto& i : bav) {
+    for (size_t r = 0; r < tab.size(); ++r) {
       
-      r2c& this_r2c = i.GetR2C(cname);
-      if (valid_reads.count(i.SR())) {
+      if (valid_reads[r]) {
 
-	std::string qn = i.Qname();
-	if (qnames.count(qn))
+	uint32_t qn = tab.qname[r];
+	if (qnames[qn])
 	  continue; // don't count support if already added and not a short event
 	// check that it's not a bad 1, 2 split
-	if (reject_qnames.count(qn)) {
-	  this_r2c.supports_var = false;
-	  i.AddR2C(cname, this_r2c); // update that this actually does not support
+	if (reject_qnames[qn]) {
+	  tab.aln[r]->supports_var = false; // update that this actually does not support
 	  continue; 
 	}
 
-	reads.push_back(i);
+	reads.push_back(tab.reads[r]);
 
 	// keep track of qnames of split reads
-	qnames.insert(qn);
-	allele[i.Prefix()].supporting_reads.insert(i.SR());
-	
-      	++allele[i.Prefix()].split;
+	qnames[qn] = true;
+	SampleInfo& si = allele[tab.samples[tab.sample[r]]];
+	si.supporting_reads.insert(tab.reads[r].SR());
+      	++si.split;
       }
     }
 
@@ -549,12 +601,12 @@ std::string BreakPoint::print(const SeqLib::BamHeader& h) const {
   std::stringstream out;
   if (isindel) {
     out << ">" << (insertion.size() ? "INS: " : "DEL: ") << getSpan() << " " << 
-      b1.gr.ToString(h) << " " << cname << " " << evidence;
+      b1.gr.ToString(h) << " " << cname << " " << EvidenceString(evidence);
     for (auto& i : allele)
       out << " " << i.first << ":" << i.second.split;  
   } else {
     out << ": " << b1.gr.PointString(h) << " to " << b2.gr.PointString(h) << " SPAN " << getSpan() << " " << cname
-	<< " " << evidence;
+	<< " " << EvidenceString(evidence);
     for (auto& i : allele)
       out << " " << i.first << ":" << i.second.split;  
   }
@@ -692,25 +744,25 @@ BreakEnd::BreakEnd(const SeqLib::BamRecord& b) {
   void BreakPoint::set_evidence() {
 
     // if we are in refilter, then this is already set
-    if (!evidence.empty())
+    if (evidence != EVDNC_NONE)
       return;
 
     bool isdisc = (dc.tcount + dc.ncount) != 0;
 
     if (num_align == 1)
-      evidence = "INDEL";
+      evidence = EVDNC_INDEL;
     else if ( isdisc && !complex && num_align > 0)
-      evidence = "ASDIS";
+      evidence = EVDNC_ASDIS;
     else if ( isdisc && num_align < 3)
-      evidence = "DSCRD";
+      evidence = EVDNC_DSCRD;
     else if (!complex) 
-      evidence = "ASSMB";
+      evidence = EVDNC_ASSMB;
     else if (complex && !complex_local) // is A-C of an ABC
-      evidence = "TSI_G";
+      evidence = EVDNC_TSI_G;
     else if (complex && complex_local) // is AB or BC of an ABC 
-      evidence = "TSI_L";
+      evidence = EVDNC_TSI_L;
 
-    assert(evidence.length());
+    assert(evidence != EVDNC_NONE);
 
   }
 
@@ -730,63 +782,63 @@ BreakEnd::BreakEnd(const SeqLib::BamRecord& b) {
       // issue is that if a read is secondary aligned, it could be 
       // aligned to way off region. Saw cases where this happend in tumor
       // and not normal, so false-called germline event as somatic.
-      confidence = "NOLOCAL";
+      confidence = CONF_NOLOCAL;
     else if (has_local_alignment)
-      confidence = "LOCALMATCH";
+      confidence = CONF_LOCALMATCH;
     else if ( num_split > 1 && ( (cov_span <= (readlen + 5 ) && cov_span > 0) || cov_span < 0) )
-      confidence = "DUPREADS"; // the same sequences keep covering the split
+      confidence = CONF_DUPREADS; // the same sequences keep covering the split
     else if (homology.length() >= 20 && (span > 1500 || span == -1) && std::max(b1.mapq, b2.mapq) < 60)
-      confidence = "NODISC";
+      confidence = CONF_NODISC;
     else if ((int)seq.length() < readlen + 30)
-      confidence = "TOOSHORT";
+      confidence = CONF_TOOSHORT;
     else if (blacklist)
-      confidence = "BLACKLIST";
+      confidence = CONF_BLACKLIST;
     else if (a.split < 7 && (span > 1500 || span == -1))  // large and inter chrom need 7+
-      confidence = "NODISC";
+      confidence = CONF_NODISC;
     else if (std::max(b1.mapq, b2.mapq) <= 40 || std::min(b1.mapq, b2.mapq) <= 10) 
-      confidence = "LOWMAPQ";
+      confidence = CONF_LOWMAPQ;
     else if ( std::min(b1.mapq, b2.mapq) <= 30 && a.split <= 8 ) 
-      confidence = "LOWMAPQ";
+      confidence = CONF_LOWMAPQ;
     else if (std::max(b1.nm, b2.nm) >= 10 || std::min(b1.as_frac, b2.as_frac) < 0.8) 
-      confidence = "LOWAS";
+      confidence = CONF_LOWAS;
     else if ( (std::max(b1.nm, b2.nm) >= 3 || std::min(b1.as_frac, b2.as_frac) < 0.85) && getSpan() < 0 )
-      confidence = "LOWAS";      
+      confidence = CONF_LOWAS;      
     else if ((double)aligned_covered / (double)seq.length() < 0.80) // less than 80% of read is covered by some alignment
-      confidence = "LOWAS";        
+      confidence = CONF_LOWAS;        
     else if ( (b1.matchlen < 50 && b1.mapq < 60) || (b2.matchlen < 50 && b2.mapq < 60) )
-      confidence = "LOWMAPQ";
+      confidence = CONF_LOWMAPQ;
     else if ( std::min(b1.nm, b2.nm) >= 10)
-      confidence = "LOWMAPQ";
+      confidence = CONF_LOWMAPQ;
     else if (a.split <= 3 && span <= 1500 && span != -1) // small with little split
-      confidence = "LOWSPLITSMALL";
+      confidence = CONF_LOWSPLITSMALL;
     else if (b1.gr.chr != b2.gr.chr && std::min(b1.matchlen, b2.matchlen) < 60) // inter-chr, but no disc reads, weird alignment
-      confidence = "LOWICSUPPORT";
+      confidence = CONF_LOWICSUPPORT;
     else if (b1.gr.chr != b2.gr.chr && std::max(b1.nm, b2.nm) >= 3 && std::min(b1.matchlen, b2.matchlen) < 150) // inter-chr, but no disc reads, and too many nm
-      confidence = "LOWICSUPPORT";
+      confidence = CONF_LOWICSUPPORT;
     else if (std::min(b1.matchlen, b2.matchlen) < 0.6 * readlen)
-      confidence = "LOWICSUPPORT";      
+      confidence = CONF_LOWICSUPPORT;      
     else if (std::min(b1.mapq, b2.mapq) < 50 && b1.gr.chr != b2.gr.chr) // interchr need good mapq for assembly only
-      confidence = "LOWMAPQ";
+      confidence = CONF_LOWMAPQ;
     else if (std::min(b1.matchlen, b2.matchlen) < 40 || (complex_local && std::min(b1.matchlen, b2.matchlen) < 100)) // not enough evidence
-      confidence = "LOWMATCHLEN";    
+      confidence = CONF_LOWMATCHLEN;    
     else if (std::min(b1.matchlen - homology.length(), b2.matchlen - homology.length()) < 40)
-      confidence = "LOWMATCHLEN";          
+      confidence = CONF_LOWMATCHLEN;          
     else if ((b1.sub_n && b1.mapq < 50) || (b2.sub_n && b2.mapq < 50)) 
-      confidence = "MULTIMATCH";
+      confidence = CONF_MULTIMATCH;
     else if (secondary && std::min(b1.mapq, b2.mapq) < 30)
-      confidence = "SECONDARY";
+      confidence = CONF_SECONDARY;
     else if ((repeat_seq.length() >= 10 && std::max(t.split, n.split) < 7) || hi_rep)
-      confidence = "WEAKSUPPORTHIREP";
+      confidence = CONF_WEAKSUPPORTHIREP;
     else if (num_split < 6 && getSpan() < 300 && b1.gr.strand==b2.gr.strand) 
-      confidence = "LOWQINVERSION";
+      confidence = CONF_LOWQINVERSION;
     else if ( (b1.matchlen - b1.simple < 15 || b2.matchlen - b2.simple < 15) )
-      confidence = "SIMPLESEQUENCE";
+      confidence = CONF_SIMPLESEQUENCE;
     else if ((int)homology.length() * HOMOLOGY_FACTOR > readlen) // if homology is too high, tough to tell from mis-assemly
-      confidence = "HIGHHOMOLOGY";
+      confidence = CONF_HIGHHOMOLOGY;
     else
-      confidence = "PASS";
+      confidence = CONF_PASS;
 
-    assert(confidence.length());
+    assert(confidence != CONF_NONE);
 
   }
   
@@ -799,7 +851,7 @@ BreakEnd::BreakEnd(const SeqLib::BamRecord& b) {
     // find the somatic to normal ratio
     double ratio = n.alt > 0 ? (double)t.alt / (double)n.alt : 100;    
     
-    if (evidence == "INDEL") {
+    if (evidence == EVDNC_INDEL) {
       
       // somatic score is just true or false for now
       // use the specified cutoff for indels, taking into account whether at dbsnp site
@@ -819,7 +871,7 @@ BreakEnd::BreakEnd(const SeqLib::BamRecord& b) {
   }
     
   // set germline if single normal read in discordant clsuter
-  if (evidence == "DSCRD" && n.alt > 0)
+  if (evidence == EVDNC_DSCRD && n.alt > 0)
     somatic_score = 0;
   
   }
@@ -853,29 +905,29 @@ BreakEnd::BreakEnd(const SeqLib::BamRecord& b) {
     int hq = dc.tcount_hq + dc.ncount_hq;
 
     if ( (max_a_mapq < 30 && !b1.local && hq < 3) || (max_b_mapq < 30 && !b2.local && hq < 3) || (b1.sub_n > 7 && b1.mapq < 10 && !b1.local && hq < 3) || (b2.sub_n > 7 && b2.mapq < 10 && !b2.local && hq < 3) )
-      confidence = "LOWMAPQ";
+      confidence = CONF_LOWMAPQ;
     else if ( std::min(b1.nm, b2.nm) >= 10)
-      confidence = "LOWMAPQ";
+      confidence = CONF_LOWMAPQ;
     else if ( std::min(b1.mapq, b2.mapq) < 10/* && std::min(dc.mapq1, dc.mapq2) < 10 */&& hq < 2)
-      confidence = "LOWMAPQ";      
+      confidence = CONF_LOWMAPQ;      
     else if ( total_count < 4 || (std::max(t.split, n.split) <= 5 && cov_span < (readlen + 5) && disc_count < 7) )
-      confidence = "LOWSUPPORT";
+      confidence = CONF_LOWSUPPORT;
     else if ( total_count < 15 && germ && span == -1) // be super strict about germline interchrom
-      confidence = "LOWSUPPORT";
+      confidence = CONF_LOWSUPPORT;
     else if ( std::min(b1.matchlen, b2.matchlen) < 50 && b1.gr.chr != b2.gr.chr ) 
-      confidence = "LOWICSUPPORT";
+      confidence = CONF_LOWICSUPPORT;
     else if (secondary && getSpan() < 1000) // local alignments are more likely to be false for alignemnts with secondary mappings
-      confidence = "SECONDARY";	
+      confidence = CONF_SECONDARY;	
     else if (dc.tcount_hq + dc.ncount_hq < 3) { // multimathces are bad if we don't have good disc support too
       if ( ((b1.sub_n && dc.mapq1 < 1) || (b2.sub_n && dc.mapq2 < 1))  )
-	confidence = "MULTIMATCH";
+	confidence = CONF_MULTIMATCH;
       else if ( ( (secondary || b1.sub_n > 1) && !b1.local) && ( std::min(max_a_mapq, max_b_mapq) < 30 || std::max(dc.tcount, dc.ncount) < 10)) 
-	confidence = "SECONDARY";
+	confidence = CONF_SECONDARY;
       else 
-	confidence = "PASS";
+	confidence = CONF_PASS;
     }
     else
-      confidence = "PASS";
+      confidence = CONF_PASS;
   }
 
   void BreakPoint::score_dscrd(int min_dscrd_size) {
@@ -889,29 +941,29 @@ BreakEnd::BreakEnd(const SeqLib::BamRecord& b) {
     int hq_disc_cutoff = disc_count >= 10 ? 3 : 5; // reads with both pair-mates have high MAPQ
 
     if (getSpan() > 0 && (getSpan() < min_dscrd_size && b1.gr.strand == '+' && b2.gr.strand == '-')) // restrict span for del (FR) type 
-      confidence = "LOWSPANDSCRD";
+      confidence = CONF_LOWSPANDSCRD;
     else if (hq_disc_count < hq_disc_cutoff && (disc_count < disc_cutoff || std::min(dc.mapq1, dc.mapq2) < 15))
-      confidence = "LOWMAPQDISC";
+      confidence = CONF_LOWMAPQDISC;
     else if (!dc.m_id_competing.empty())
-      confidence = "COMPETEDISC";
+      confidence = CONF_COMPETEDISC;
     else if ( disc_count < disc_cutoff)
-      confidence = "WEAKDISC";
+      confidence = CONF_WEAKDISC;
     else 
-      confidence = "PASS";
+      confidence = CONF_PASS;
     
-    assert(confidence.length());
+    assert(confidence != CONF_NONE);
   }
 
 void BreakPoint::score_indel(double LOD_CUTOFF, double LOD_CUTOFF_DBSNP) {
 
     assert(b1.mapq == b2.mapq);
 
-    bool is_refilter = !confidence.empty(); // act differently if this is refilter run
+    bool is_refilter = confidence != CONF_NONE; // act differently if this is refilter run
     
     // for refilter, only consider ones that were low lod or PASS
     // ie ones that with a different lod threshold may be changed
     // if confidence is empty, this is original run so keep going
-    if (confidence != "LOWLOD" && confidence != "PASS" && is_refilter)
+    if (confidence != CONF_LOWLOD && confidence != CONF_PASS && is_refilter)
       return;
     
     double max_lod = 0;
@@ -932,23 +984,23 @@ void BreakPoint::score_indel(double LOD_CUTOFF, double LOD_CUTOFF_DBSNP) {
     double af = std::max(af_t, af_n);
 
     if (b1.mapq < 10) 
-      confidence="LOWMAPQ";
+      confidence=CONF_LOWMAPQ;
     else if (!is_refilter && (double)aligned_covered / (double)seq.length() < 0.80) // less than 80% of read is covered by some alignment
-      confidence = "LOWAS";  
+      confidence = CONF_LOWAS;  
     else if ((b1.sub_n && b1.mapq < 50) || (b2.sub_n && b2.mapq < 50)) 
-      confidence = "MULTIMATCH";      
+      confidence = CONF_MULTIMATCH;      
     else if (max_lod < LOD_CUTOFF && rs.empty())        // non db snp site
-      confidence = "LOWLOD";
+      confidence = CONF_LOWLOD;
     else if (max_lod < LOD_CUTOFF_DBSNP && !rs.empty()) // be more permissive for dbsnp site
-      confidence = "LOWLOD";
+      confidence = CONF_LOWLOD;
     else if (af < 0.05) // if really low AF, get rid of 
-      confidence = "VLOWAF";
+      confidence = CONF_VLOWAF;
     else if (!is_refilter && std::min(left_match, right_match) < 20) 
-      confidence = "SHORTALIGNMENT"; // no conf in indel if match on either side is too small
+      confidence = CONF_SHORTALIGNMENT; // no conf in indel if match on either side is too small
     else if (homozygous_ref)
-      confidence = "NONVAR";
+      confidence = CONF_NONVAR;
     else
-      confidence="PASS";
+      confidence=CONF_PASS;
 
   }
 
@@ -972,7 +1024,7 @@ void BreakPoint::scoreBreakpoint(double LOD_CUTOFF, double LOD_CUTOFF_DBSNP, dou
     }
 
     // kludge. make sure we have included the DC counts (should have done this arleady...)
-    if (evidence == "DSCRD" || evidence == "ASDIS") {
+    if (evidence == EVDNC_DSCRD || evidence == EVDNC_ASDIS) {
       t.disc = dc.tcount;
       n.disc = dc.ncount;
     }
@@ -994,29 +1046,29 @@ void BreakPoint::scoreBreakpoint(double LOD_CUTOFF, double LOD_CUTOFF_DBSNP, dou
     assert( (split == 0 && t.split == 0 && n.split==0) || (split > 0 && (t.split + n.split > 0)));
 
     // do the scoring
-    bool iscomplex = evidence.find("TSI") != std::string::npos;
-    if (confidence.empty() && evidence != "INDEL") {
-      if (evidence == "ASSMB" || (iscomplex  && (dc.ncount + dc.tcount)==0))
+    bool iscomplex = IsComplexEvidence(evidence);
+    if (confidence == CONF_NONE && evidence != EVDNC_INDEL) {
+      if (evidence == EVDNC_ASSMB || (iscomplex  && (dc.ncount + dc.tcount)==0))
 	score_assembly_only();
-      if (evidence == "ASDIS" || (iscomplex && (dc.ncount + dc.tcount))) 
+      if (evidence == EVDNC_ASDIS || (iscomplex && (dc.ncount + dc.tcount))) 
 	score_assembly_dscrd();
-      if (evidence == "DSCRD")
+      if (evidence == EVDNC_DSCRD)
 	score_dscrd(min_dscrd_size);
       // it failed assembly filters, but might pass discordant filters
-      if (evidence == "ASDIS" && confidence != "PASS") { 
-	evidence = "DSCRD";
+      if (evidence == EVDNC_ASDIS && confidence != CONF_PASS) { 
+	evidence = EVDNC_DSCRD;
 	score_dscrd(min_dscrd_size);
       }
     }
-    else if (evidence == "INDEL") {
+    else if (evidence == EVDNC_INDEL) {
       score_indel(LOD_CUTOFF, LOD_CUTOFF_DBSNP);
     }
 
     // filter out SVs with only 1 BX tag supporting
     // if we have bx tags
     format_bx_string();
-    if (bx_count == 1 && confidence == "PASS")
-      confidence = "SINGLEBX";
+    if (bx_count == 1 && confidence == CONF_PASS)
+      confidence = CONF_SINGLEBX;
 
     // set the somatic_score field to true or false
     score_somatic(LOD_CUTOFF_SOMATIC, LOD_CUTOFF_SOMATIC_DBSNP);
@@ -1120,7 +1172,7 @@ void BreakPoint::format_bx_string() {
     assert(ref.empty());
     assert(alt.empty());
     
-    if (evidence != "INDEL") {
+    if (evidence != EVDNC_INDEL) {
 
       try {
 	// get the reference for BP1
@@ -1220,13 +1272,11 @@ ReducedBreakPoint::ReducedBreakPoint(const std::string &line, const SeqLib::BamH
     ref = nullptr;
     alt = nullptr;
     cname = nullptr;
-    evidence = nullptr;
-    confidence = nullptr;
     insertion = nullptr;
     homology = nullptr;
 
     //float afn, aft;
-    std::string ref_s, alt_s, cname_s, insertion_s, homology_s, evidence_s, confidence_s, read_names_s, bxtable_s;
+    std::string ref_s, alt_s, cname_s, insertion_s, homology_s, read_names_s, bxtable_s;
     
     std::string chr1, pos1, chr2, pos2, chr_name1, chr_name2, repeat_s; 
     char strand1 = '*', strand2 = '*';
@@ -1269,13 +1319,13 @@ ReducedBreakPoint::ReducedBreakPoint(const std::string &line, const SeqLib::BamH
 	case 24: cname_s = val; break;
 	case 25: num_align = std::min((int)31, std::stoi(val)); break;
 	case 26: 
-	  pass = val == "PASS";
-	  confidence_s = val;
+	  confidence = ParseConfidence(val);
+	  pass = confidence == CONF_PASS;
 	  break;
 	case 27: 
-	  evidence_s = val;
-	  indel = val == "INDEL"; 
-	  imprecise = val == "DSCRD"; 
+	  evidence = ParseEvidence(val);
+	  indel = evidence == EVDNC_INDEL;
+	  imprecise = evidence == EVDNC_DSCRD;
 	  break; 
 	case 28: quality = std::stod(val); break; //std::min((int)255,std::stoi(val)); break;
 	case 29: secondary = val == "1" ? 1 : 0;
@@ -1299,20 +1349,67 @@ ReducedBreakPoint::ReducedBreakPoint(const std::string &line, const SeqLib::BamH
       }
     }
     
-    confidence = __string_alloc2char(confidence_s, confidence);
-    evidence   = __string_alloc2char(evidence_s, evidence);
     insertion  = __string_alloc2char(insertion_s, insertion);
     homology   = __string_alloc2char(homology_s, homology);
     cname      = __string_alloc2char(cname_s, cname);
     ref        = __string_alloc2char(ref_s, ref);
     alt        = __string_alloc2char(alt_s, alt);
     repeat     = repeat_s.empty() ? nullptr : __string_alloc2char(repeat_s, repeat);
-    if (somatic_score && confidence_s == "PASS")
+    if (somatic_score && pass)
       read_names     = read_names_s; // == "x" ? nullptr : __string_alloc2char(read_names_s, read_names);
     bxtable = bxtable_s;
 
   }
 
+ReducedBreakPoint::ReducedBreakPoint(const BreakPoint& bp) {
+
+  ref = nullptr;
+  alt = nullptr;
+  cname = nullptr;
+  insertion = nullptr;
+  homology = nullptr;
+  repeat = nullptr;
+
+  // same fields and caps as reading the line from a bps.txt file
+  b1 = ReducedBreakEnd(bp.b1.gr, bp.b1.mapq, bp.b1.chr_name);
+  b2 = ReducedBreakEnd(bp.b2.gr, bp.b2.mapq, bp.b2.chr_name);
+  b1.nm = std::min(255, bp.b1.nm);
+  b2.nm = std::min(255, bp.b2.nm);
+  b1.sub_n = std::min(255, bp.b1.sub_n);
+  b2.sub_n = std::min(255, bp.b2.sub_n);
+  dc.mapq1 = std::min(255, bp.dc.mapq1);
+  dc.mapq2 = std::min(255, bp.dc.mapq2);
+  cov = std::min(65535, bp.a.cov);
+  num_align = std::min(31, bp.num_align);
+  evidence = bp.evidence;
+  confidence = bp.confidence;
+  pass = confidence == CONF_PASS;
+  indel = evidence == EVDNC_INDEL;
+  imprecise = evidence == EVDNC_DSCRD;
+  quality = bp.quality;
+  secondary = bp.secondary ? 1 : 0;
+  somatic_score = bp.somatic_score;
+  somatic_lod = bp.somatic_lod;
+  true_lod = bp.a.LO;
+  pon = std::min(255, bp.pon);
+  blacklist = bp.blacklist ? 1 : 0;
+  dbsnp = !bp.rs.empty() && bp.rs != "x";
+
+  for (auto& a : bp.allele)
+    format_s.push_back(a.second.toFileString());
+
+  insertion  = __string_alloc2char(bp.insertion, insertion);
+  homology   = __string_alloc2char(bp.homology, homology);
+  cname      = __string_alloc2char(bp.cname, cname);
+  ref        = __string_alloc2char(bp.ref, ref);
+  alt        = __string_alloc2char(bp.alt, alt);
+  repeat     = __string_alloc2char(bp.repeat_seq, repeat);
+  if (somatic_score && pass)
+    read_names = bp.read_names.empty() ? "x" : bp.read_names;
+  bxtable = bp.bxtable.empty() ? "x" : bp.bxtable;
+
+}
+
   double SampleInfo::__log_likelihood(double ref, double alt, double f, double e) {
     
     // less negative log-likelihoods means more likely
@@ -1633,12 +1730,6 @@ std::string BreakEnd::print(const SeqLib::BamHeader& h) const {
       rseq = sss.substr(cpos, std::min(end - cpos, (int)seq.length() - cpos));
   }
 
-  std::string BreakEnd::hash(int offset) const {
-    
-    return (std::to_string(gr.chr) + ":" + std::to_string(gr.pos1 + offset));
-    
-  }
-
   void BreakPoint::checkLocal(const GenomicRegion& window) {
 
     b1.checkLocal(window);
@@ -1677,9 +1768,11 @@ std::string BreakEnd::print(const SeqLib::BamHeader& h) const {
 bool ReducedBreakPoint::operator<(const ReducedBreakPoint& bp) const { 
 
   //ASDIS > ASSMB > COMP > DSCRD
-  if (std::strcmp(evidence,bp.evidence) < 0) // <
+  // alphabetical by the evidence text, not by code
+  int ecmp = std::strcmp(EvidenceString(evidence), EvidenceString(bp.evidence));
+  if (ecmp < 0) // <
     return true;
-  else if (std::strcmp(evidence, bp.evidence) > 0) // >
+  else if (ecmp > 0) // >
     return false;
   
   if (cov > bp.cov)
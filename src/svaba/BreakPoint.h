@@ -6,6 +6,9 @@
 #include <map>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
 
 #include "SeqLib/BWAWrapper.h"
 #include "SeqLib/BamHeader.h"
@@ -18,6 +21,94 @@
   struct BreakPoint;
 
   typedef std::vector<BreakPoint> BPVec;
+
+ /** Evidence type of a breakpoint (EVDNC). Stored as a code, formatted only at output */
+ enum BreakPointEvidence : uint8_t {
+   EVDNC_NONE = 0, // not yet scored
+   EVDNC_INDEL, EVDNC_ASDIS, EVDNC_DSCRD, EVDNC_ASSMB, EVDNC_TSI_G, EVDNC_TSI_L,
+   EVDNC_COUNT
+ };
+
+ /** Filter result of a breakpoint (the VCF FILTER). Stored as a code, formatted only at output */
+ enum BreakPointConfidence : uint8_t {
+   CONF_NONE = 0, // not yet scored
+   CONF_PASS, CONF_NOLOCAL, CONF_LOCALMATCH, CONF_DUPREADS, CONF_NODISC, CONF_TOOSHORT,
+   CONF_BLACKLIST, CONF_LOWMAPQ, CONF_LOWAS, CONF_LOWSPLITSMALL, CONF_LOWICSUPPORT,
+   CONF_LOWMATCHLEN, CONF_MULTIMATCH, CONF_SECONDARY, CONF_WEAKSUPPORTHIREP, CONF_LOWQINVERSION,
+   CONF_SIMPLESEQUENCE, CONF_HIGHHOMOLOGY, CONF_LOWSUPPORT, CONF_LOWSPANDSCRD, CONF_LOWMAPQDISC,
+   CONF_COMPETEDISC, CONF_WEAKDISC, CONF_LOWLOD, CONF_VLOWAF, CONF_SHORTALIGNMENT, CONF_NONVAR,
+   CONF_SINGLEBX, CONF_REPVAR,
+   CONF_COUNT
+ };
+
+ const char* EvidenceString(BreakPointEvidence e);
+ const char* ConfidenceString(BreakPointConfidence c);
+
+ // parse the text form (e.g. from bps.txt.gz). Unknown strings give the NONE code
+ BreakPointEvidence ParseEvidence(const std::string& s);
+ BreakPointConfidence ParseConfidence(const std::string& s);
+
+ inline bool IsComplexEvidence(BreakPointEvidence e) { return e == EVDNC_TSI_G || e == EVDNC_TSI_L; }
+
+ /** Per-sample values keyed by sample prefix (e.g. n000, t001).
+  *
+  * A flat array of (prefix, value) kept sorted by prefix, so a sample's slot
+  * is its ordinal among the samples present and iteration is alphabetical
+  * (n000 before t000), as the output columns expect. There are only ever a
+  * handful of samples, so this is smaller and faster than a node-based map.
+  */
+ template <typename T>
+ class PerSample {
+
+ public:
+
+   typedef std::pair<std::string, T> value_type;
+   typedef typename std::vector<value_type>::iterator iterator;
+   typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+   T& operator[](const std::string& id) {
+     iterator it = __lower(id);
+     if (it == m_v.end() || it->first != id)
+       it = m_v.insert(it, value_type(id, T()));
+     return it->second;
+   }
+
+   iterator find(const std::string& id) {
+     iterator it = __lower(id);
+     return (it != m_v.end() && it->first == id) ? it : m_v.end();
+   }
+
+   const_iterator find(const std::string& id) const {
+     const_iterator it = std::lower_bound(m_v.begin(), m_v.end(), id,
+					  [](const value_type& v, const std::string& k) { return v.first < k; });
+     return (it != m_v.end() && it->first == id) ? it : m_v.end();
+   }
+
+   size_t count(const std::string& id) const { return find(id) != m_v.end(); }
+
+   // value by sample ordinal
+   T& at(size_t i) { return m_v[i].second; }
+   const T& at(size_t i) const { return m_v[i].second; }
+
+   iterator begin() { return m_v.begin(); }
+   iterator end() { return m_v.end(); }
+   const_iterator begin() const { return m_v.begin(); }
+   const_iterator end() const { return m_v.end(); }
+
+   size_t size() const { return m_v.size(); }
+   bool empty() const { return m_v.empty(); }
+   void clear() { m_v.clear(); }
+
+ private:
+
+   iterator __lower(const std::string& id) {
+     return std::lower_bound(m_v.begin(), m_v.end(), id,
+			     [](const value_type& v, const std::string& k) { return v.first < k; });
+   }
+
+   std::vector<value_type> m_v;
+
+ };
    
 struct ReducedBreakEnd {
   
@@ -43,7 +134,10 @@ struct ReducedBreakEnd {
 
    std::string print(const SeqLib::BamHeader& h) const;
 
-   std::string hash(int offset = 0) const;
+   // integer key of the (offset) break position, for hashing
+   uint64_t key(int offset = 0) const {
+     return ((uint64_t)(uint32_t)gr.chr << 32) | (uint32_t)(gr.pos1 + offset);
+   }
 
    std::string id;
    std::string chr_name;
@@ -55,9 +149,7 @@ struct ReducedBreakEnd {
    int matchlen = -1;
    int simple = 0;
 
-   std::unordered_map<std::string, int> split;  // for high-confidence reads
-   std::unordered_map<std::string, int> splitI; // for informative reads
-   std::unordered_map<std::string, double> af;
+   PerSample<int> split;  // for high-confidence reads
 
    int sub_n = -1;
    double as_frac= 0;
@@ -113,17 +205,16 @@ struct ReducedBreakEnd {
      smart_check_free(cname);
      smart_check_free(homology);
      smart_check_free(insertion);
-     smart_check_free(evidence);
-     smart_check_free(confidence);
      smart_check_free(repeat);
    }
    ReducedBreakPoint(const std::string &line, const SeqLib::BamHeader& h);
 
+   // make from a breakpoint read back from the binary breakpoint store
+   ReducedBreakPoint(const BreakPoint& bp);
+
    char * ref;
    char * alt;
    char * cname;
-   char * evidence;
-   char * confidence;
    char * insertion;
    char * homology;
    char * repeat;
@@ -143,6 +234,8 @@ struct ReducedBreakEnd {
    uint32_t tcigar:8, ncigar:8, dummy:8, af_t:8; 
    float quality;
    uint8_t pon;
+   BreakPointEvidence evidence = EVDNC_NONE;
+   BreakPointConfidence confidence = CONF_NONE;
 
    ReducedDiscordantCluster dc;
 
@@ -194,6 +287,40 @@ struct ReducedBreakEnd {
    
  };
  
+ /** Read to contig alignments of the reads on one contig, stored as columns.
+  *
+  * Built once per contig and shared by every breakpoint on it in
+  * BreakPoint::splitCoverage, so the r2c lookups, qname hashing and repeat
+  * checks are done once per read rather than once per read per breakpoint.
+  * Reads and qnames are numbered densely, so the sets of reads a breakpoint
+  * keeps are bitsets.
+  */
+ struct ContigReadTable {
+
+   ContigReadTable(svabaReadVector& r, const std::string& cname);
+
+   size_t size() const { return start.size(); }
+
+   svabaReadVector& reads;
+
+   std::vector<r2c*> aln;            // r2c of each read on this contig
+   std::vector<int32_t> start, end;  // alignment span on the contig
+   std::vector<uint32_t> qname;      // qname ordinal, shared by mates
+   std::vector<uint16_t> sample;     // index into samples
+   std::vector<bool> tumor, first, homopolymer;
+
+   std::vector<std::string> samples; // sample prefixes (e.g. t000)
+
+   // contig offsets (from the read start) of the D and I operations of each
+   // read's r2c cigar. Ops of read i are [op_start[i], op_start[i+1])
+   std::vector<uint32_t> op_start;
+   std::vector<int32_t> op_pos;
+   std::vector<bool> op_del;
+
+   size_t num_qnames = 0;
+
+ };
+
  struct BreakPoint {
    
    static std::string header() { 
@@ -207,7 +334,10 @@ struct ReducedBreakEnd {
 
    int aligned_covered = 0;
    
-   std::string seq, cname, rs, insertion, homology, repeat_seq, evidence, confidence, ref, alt, read_names, bxtable;   
+   std::string seq, cname, rs, insertion, homology, repeat_seq, ref, alt, read_names, bxtable;   
+
+   BreakPointEvidence evidence = EVDNC_NONE;
+   BreakPointConfidence confidence = CONF_NONE;
 
    // count of unique bx tags
    size_t bx_count = 0;
@@ -236,7 +366,7 @@ struct ReducedBreakEnd {
    int quality = 0;
 
    // total coverage at that position
-   std::map<std::string, SampleInfo> allele; // ordered to keep in alphabetical order by prefix (e.g. n001)
+   PerSample<SampleInfo> allele; // ordered to keep in alphabetical order by prefix (e.g. n001)
 
    bool secondary = false;
 
@@ -289,7 +419,7 @@ struct ReducedBreakEnd {
     * The AL tag is filled in by AlignedContig::alignReadsToContigs.
     */
    //void splitCoverage(SeqLib::BamRecordVector &bav);
-   void splitCoverage(svabaReadVector &bav);
+   void splitCoverage(ContigReadTable &tab);
    
    /*! Determines if the BreakPoint overlays a blacklisted region. If 
     * and overlap is found, sets the blacklist bool to true.
@@ -338,6 +468,12 @@ struct ReducedBreakEnd {
    bool isEmpty() const { return (b1.gr.pos1 == 0 && b2.gr.pos1 == 0); }
    
    std::string toFileString(bool noreads = false);
+
+   // format the read name and BX strings for output (as done by toFileString)
+   void prep_output(bool noreads);
+
+   // max LOD of variant vs error across samples
+   double getMaxLod() const;
    
    bool hasDiscordant() const;
    
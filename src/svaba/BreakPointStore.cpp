@@ -0,0 +1,514 @@
+#include "BreakPointStore.h"
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "gzstream.h"
+#include "svabaUtils.h"
+#include "svaba_params.h"
+
+// first bytes of the file. Last character is the format version
+static const char BPSTORE_MAGIC[] = "SVABABP1";
+#define BPSTORE_MAGIC_LEN 8
+
+// numbers are written in the native byte order
+
+template <typename T>
+static void __put(std::string& out, const T& val) {
+  out.append((const char*)&val, sizeof(T));
+}
+
+template <typename T>
+static void __put(std::string& out, const std::vector<T>& v) {
+  if (v.size())
+    out.append((const char*)v.data(), v.size() * sizeof(T));
+}
+
+static void __put(std::string& out, const StringColumn& c) {
+  __put(out, c.len);
+  out.append(c.data);
+}
+
+template <typename T>
+static bool __take(const std::string& in, size_t& p, T& val) {
+  if (p + sizeof(T) > in.size())
+    return false;
+  memcpy(&val, in.data() + p, sizeof(T));
+  p += sizeof(T);
+  return true;
+}
+
+template <typename T>
+static bool __take(const std::string& in, size_t& p, std::vector<T>& v, size_t n) {
+  if (p + n * sizeof(T) > in.size())
+    return false;
+  v.resize(n);
+  if (n)
+    memcpy(v.data(), in.data() + p, n * sizeof(T));
+  p += n * sizeof(T);
+  return true;
+}
+
+static bool __take(const std::string& in, size_t& p, StringColumn& c, size_t n) {
+  if (!__take(in, p, c.len, n))
+    return false;
+  c.off.resize(n);
+  size_t total = 0;
+  for (size_t i = 0; i < n; ++i) {
+    c.off[i] = total;
+    total += c.len[i];
+  }
+  if (p + total > in.size())
+    return false;
+  c.data = in.substr(p, total);
+  p += total;
+  return true;
+}
+
+// write and read with BGZF, failing on a short read
+static bool __bgzf_read(BGZF * fp, void * data, size_t len) {
+  return bgzf_read(fp, data, len) == (ssize_t)len;
+}
+
+static bool __bgzf_read_string(BGZF * fp, std::string& s) {
+  uint32_t len = 0;
+  if (!__bgzf_read(fp, &len, sizeof(uint32_t)))
+    return false;
+  s.resize(len);
+  return !len || __bgzf_read(fp, &s[0], len);
+}
+
+static void __put_string(std::string& out, const std::string& s) {
+  __put(out, (uint32_t)s.length());
+  out.append(s);
+}
+
+// chromosome ID, or -1 if not in the header (e.g. "Unknown" for unmapped discordant mates)
+static int32_t __chr_id(const std::string& name, const SeqLib::BamHeader& h) {
+  try {
+    return h.Name2ID(name);
+  } catch (...) {
+    return -1;
+  }
+}
+
+void StringColumn::add(const std::string& s) {
+  off.push_back(data.size());
+  len.push_back(s.length());
+  data.append(s);
+}
+
+uint32_t BreakPointBlock::__code(const std::string& s) {
+  std::unordered_map<std::string, uint32_t>::const_iterator ff = dict_idx.find(s);
+  if (ff != dict_idx.end())
+    return ff->second;
+  dict_idx[s] = dict.size();
+  dict.push_back(s);
+  return dict.size() - 1;
+}
+
+void BreakPointBlock::clear() {
+  size_t ns = samples.size();
+  *this = BreakPointBlock(ns);
+}
+
+void BreakPointBlock::add(const BreakPoint& bp, const std::vector<std::string>& sample_ids) {
+
+  pos1.push_back(bp.b1.gr.pos1);
+  pos2.push_back(bp.b2.gr.pos1);
+  chr1.push_back(__code(bp.b1.chr_name));
+  chr2.push_back(__code(bp.b2.chr_name));
+  strand1.push_back(bp.b1.gr.strand);
+  strand2.push_back(bp.b2.gr.strand);
+  mapq1.push_back(bp.b1.mapq);
+  mapq2.push_back(bp.b2.mapq);
+  nm1.push_back(bp.b1.nm);
+  nm2.push_back(bp.b2.nm);
+  dmapq1.push_back(bp.dc.mapq1);
+  dmapq2.push_back(bp.dc.mapq2);
+  split.push_back(bp.a.split);
+  cigar.push_back(bp.a.cigar);
+  alt.push_back(bp.a.alt);
+  cov.push_back(bp.a.cov);
+  sub_n1.push_back(bp.b1.sub_n);
+  sub_n2.push_back(bp.b2.sub_n);
+  num_align.push_back(bp.num_align);
+  quality.push_back(bp.quality);
+  pon.push_back(bp.pon);
+  secondary.push_back(bp.secondary);
+  blacklist.push_back(bp.blacklist);
+  somatic_score.push_back(bp.somatic_score);
+  somatic_lod.push_back(bp.somatic_lod);
+  max_lod.push_back(bp.getMaxLod());
+  confidence.push_back(__code(ConfidenceString(bp.confidence)));
+  evidence.push_back(__code(EvidenceString(bp.evidence)));
+  ref.add(bp.ref);
+  alt_seq.add(bp.alt);
+  homology.add(bp.homology);
+  insertion.add(bp.insertion);
+  cname.add(bp.cname);
+  repeat_seq.add(bp.repeat_seq);
+  rs.add(bp.rs);
+  read_names.add(bp.read_names);
+  bxtable.add(bp.bxtable);
+
+  for (size_t s = 0; s < sample_ids.size(); ++s) {
+    PerSample<SampleInfo>::const_iterator ff = bp.allele.find(sample_ids[s]);
+    static const SampleInfo missing = SampleInfo();
+    const SampleInfo& a = ff == bp.allele.end() ? missing : ff->second;
+    SampleColumns& c = samples[s];
+    c.indel.push_back(a.indel);
+    c.genotype.push_back(__code(a.genotype));
+    c.split.push_back(a.split);
+    c.cigar.push_back(a.cigar);
+    c.alt.push_back(a.alt);
+    c.cov.push_back(a.cov);
+    c.disc.push_back(a.disc);
+    c.GQ.push_back(a.GQ);
+    c.LO_n.push_back(a.LO_n);
+    c.LO.push_back(a.LO);
+    c.PL.add(a.PL);
+  }
+
+}
+
+void BreakPointBlock::get(size_t i, BreakPoint& bp, const std::vector<std::string>& sample_ids, const SeqLib::BamHeader& h) const {
+
+  bp = BreakPoint();
+
+  const std::string& chr_name1 = dict[chr1[i]];
+  const std::string& chr_name2 = dict[chr2[i]];
+  int32_t c1 = h.isEmpty() ? chr1[i] : __chr_id(chr_name1, h);
+  int32_t c2 = h.isEmpty() ? chr2[i] : __chr_id(chr_name2, h);
+
+  bp.b1 = BreakEnd(SeqLib::GenomicRegion(c1, pos1[i], pos1[i], strand1[i]), mapq1[i], chr_name1);
+  bp.b2 = BreakEnd(SeqLib::GenomicRegion(c2, pos2[i], pos2[i], strand2[i]), mapq2[i], chr_name2);
+  bp.b1.nm = nm1[i];
+  bp.b2.nm = nm2[i];
+  bp.b1.sub_n = sub_n1[i];
+  bp.b2.sub_n = sub_n2[i];
+  bp.dc.mapq1 = dmapq1[i];
+  bp.dc.mapq2 = dmapq2[i];
+  bp.a.split = split[i];
+  bp.a.cigar = cigar[i];
+  bp.a.alt = alt[i];
+  bp.a.cov = cov[i];
+  bp.a.LO = max_lod[i];
+  bp.num_align = num_align[i];
+  bp.quality = quality[i];
+  bp.pon = pon[i];
+  bp.secondary = secondary[i];
+  bp.blacklist = blacklist[i];
+  bp.somatic_score = somatic_score[i];
+  bp.somatic_lod = somatic_lod[i];
+  bp.confidence = ParseConfidence(dict[confidence[i]]);
+  bp.evidence = ParseEvidence(dict[evidence[i]]);
+  bp.ref = ref.get(i);
+  bp.alt = alt_seq.get(i);
+  bp.homology = homology.get(i);
+  bp.insertion = insertion.get(i);
+  bp.cname = cname.get(i);
+  bp.repeat_seq = repeat_seq.get(i);
+  bp.rs = rs.get(i);
+  bp.read_names = read_names.get(i);
+  bp.bxtable = bxtable.get(i);
+
+  for (size_t s = 0; s < sample_ids.size() && s < samples.size(); ++s) {
+    const SampleColumns& c = samples[s];
+    SampleInfo& a = bp.allele[sample_ids[s]];
+    a.indel = c.indel[i];
+    a.genotype = dict[c.genotype[i]];
+    a.split = c.split[i];
+    a.cigar = c.cigar[i];
+    a.alt = c.alt[i];
+    a.cov = c.cov[i];
+    a.disc = c.disc[i];
+    a.GQ = c.GQ[i];
+    a.LO_n = c.LO_n[i];
+    a.LO = c.LO[i];
+    a.PL = c.PL.get(i);
+  }
+
+}
+
+void BreakPointBlock::serialize(std::string& out) const {
+
+  out.clear();
+  __put(out, (uint32_t)size());
+
+  // dictionary
+  __put(out, (uint32_t)dict.size());
+  for (auto& d : dict)
+    __put_string(out, d);
+
+  // fixed width columns
+  __put(out, pos1); __put(out, pos2); __put(out, chr1); __put(out, chr2);
+  __put(out, strand1); __put(out, strand2);
+  __put(out, mapq1); __put(out, mapq2); __put(out, nm1); __put(out, nm2); __put(out, dmapq1); __put(out, dmapq2);
+  __put(out, split); __put(out, cigar); __put(out, alt); __put(out, cov); __put(out, sub_n1); __put(out, sub_n2);
+  __put(out, num_align); __put(out, quality); __put(out, pon);
+  __put(out, secondary); __put(out, blacklist);
+  __put(out, somatic_score); __put(out, somatic_lod); __put(out, max_lod);
+  __put(out, confidence); __put(out, evidence);
+
+  // string columns
+  __put(out, ref); __put(out, alt_seq); __put(out, homology); __put(out, insertion); __put(out, cname);
+  __put(out, repeat_seq); __put(out, rs); __put(out, read_names); __put(out, bxtable);
+
+  // one block of columns per sample
+  for (auto& c : samples) {
+    __put(out, c.indel); __put(out, c.genotype);
+    __put(out, c.split); __put(out, c.cigar); __put(out, c.alt); __put(out, c.cov); __put(out, c.disc);
+    __put(out, c.GQ); __put(out, c.LO_n); __put(out, c.LO);
+    __put(out, c.PL);
+  }
+
+}
+
+bool BreakPointBlock::deserialize(const std::string& in, size_t num_samples) {
+
+  *this = BreakPointBlock(num_samples);
+
+  size_t p = 0;
+  uint32_t nrec = 0, ndict = 0;
+  if (!__take(in, p, nrec) || !__take(in, p, ndict))
+    return false;
+
+  dict.resize(ndict);
+  for (auto& d : dict) {
+    uint32_t len = 0;
+    if (!__take(in, p, len) || p + len > in.size())
+      return false;
+    d = in.substr(p, len);
+    p += len;
+  }
+
+  bool ok =
+    __take(in, p, pos1, nrec) && __take(in, p, pos2, nrec) && __take(in, p, chr1, nrec) && __take(in, p, chr2, nrec) &&
+    __take(in, p, strand1, nrec) && __take(in, p, strand2, nrec) &&
+    __take(in, p, mapq1, nrec) && __take(in, p, mapq2, nrec) && __take(in, p, nm1, nrec) && __take(in, p, nm2, nrec) &&
+    __take(in, p, dmapq1, nrec) && __take(in, p, dmapq2, nrec) &&
+    __take(in, p, split, nrec) && __take(in, p, cigar, nrec) && __take(in, p, alt, nrec) && __take(in, p, cov, nrec) &&
+    __take(in, p, sub_n1, nrec) && __take(in, p, sub_n2, nrec) &&
+    __take(in, p, num_align, nrec) && __take(in, p, quality, nrec) && __take(in, p, pon, nrec) &&
+    __take(in, p, secondary, nrec) && __take(in, p, blacklist, nrec) &&
+    __take(in, p, somatic_score, nrec) && __take(in, p, somatic_lod, nrec) && __take(in, p, max_lod, nrec) &&
+    __take(in, p, confidence, nrec) && __take(in, p, evidence, nrec) &&
+    __take(in, p, ref, nrec) && __take(in, p, alt_seq, nrec) && __take(in, p, homology, nrec) &&
+    __take(in, p, insertion, nrec) && __take(in, p, cname, nrec) && __take(in, p, repeat_seq, nrec) &&
+    __take(in, p, rs, nrec) && __take(in, p, read_names, nrec) && __take(in, p, bxtable, nrec);
+
+  for (auto& c : samples)
+    ok = ok &&
+      __take(in, p, c.indel, nrec) && __take(in, p, c.genotype, nrec) &&
+      __take(in, p, c.split, nrec) && __take(in, p, c.cigar, nrec) && __take(in, p, c.alt, nrec) &&
+      __take(in, p, c.cov, nrec) && __take(in, p, c.disc, nrec) &&
+      __take(in, p, c.GQ, nrec) && __take(in, p, c.LO_n, nrec) && __take(in, p, c.LO, nrec) &&
+      __take(in, p, c.PL, nrec);
+
+  return ok;
+
+}
+
+bool BreakPointWriter::Open(const std::string& file, const std::vector<std::string>& sample_ids, const std::vector<std::string>& sample_labels) {
+
+  m_fp = bgzf_open(file.c_str(), "w");
+  if (!m_fp)
+    return false;
+
+  m_file = file;
+  m_ids = sample_ids;
+  m_block = BreakPointBlock(m_ids.size());
+  m_offsets.clear();
+  m_block_sizes.clear();
+  m_count = 0;
+
+  // header: magic, then the sample IDs and labels
+  std::string hdr(BPSTORE_MAGIC, BPSTORE_MAGIC_LEN);
+  __put(hdr, (uint32_t)m_ids.size());
+  for (size_t i = 0; i < m_ids.size(); ++i) {
+    __put_string(hdr, m_ids[i]);
+    __put_string(hdr, i < sample_labels.size() ? sample_labels[i] : m_ids[i]);
+  }
+  bgzf_write(m_fp, hdr.data(), hdr.size());
+  bgzf_flush(m_fp);
+
+  return true;
+
+}
+
+void BreakPointWriter::Write(BreakPoint& bp, bool noreads) {
+
+  assert(m_fp);
+  bp.prep_output(noreads);
+  m_block.add(bp, m_ids);
+  ++m_count;
+
+  if (m_block.size() >= BPSTORE_BLOCK_SIZE)
+    __flush_block();
+
+}
+
+void BreakPointWriter::__flush_block() {
+
+  if (!m_block.size())
+    return;
+
+  std::string payload;
+  m_block.serialize(payload);
+
+  // each block starts a new BGZF block, so its virtual offset can be seeked to
+  m_offsets.push_back(bgzf_tell(m_fp));
+  m_block_sizes.push_back(m_block.size());
+
+  uint32_t nrec = m_block.size();
+  uint64_t nbytes = payload.size();
+  bgzf_write(m_fp, &nrec, sizeof(uint32_t));
+  bgzf_write(m_fp, &nbytes, sizeof(uint64_t));
+  bgzf_write(m_fp, payload.data(), payload.size());
+  bgzf_flush(m_fp);
+
+  m_block.clear();
+
+}
+
+void BreakPointWriter::Close() {
+
+  if (!m_fp)
+    return;
+
+  __flush_block();
+  bgzf_close(m_fp);
+  m_fp = nullptr;
+
+  // index of block offsets and sizes
+  std::ofstream idx(m_file + ".bpi");
+  for (size_t i = 0; i < m_offsets.size(); ++i)
+    idx << m_offsets[i] << "\t" << m_block_sizes[i] << std::endl;
+
+}
+
+BreakPointReader::~BreakPointReader() {
+  if (m_fp)
+    bgzf_close(m_fp);
+}
+
+bool BreakPointReader::Open(const std::string& file) {
+
+  m_fp = bgzf_open(file.c_str(), "r");
+  if (!m_fp)
+    return false;
+
+  char magic[BPSTORE_MAGIC_LEN];
+  uint32_t ns = 0;
+  if (!__bgzf_read(m_fp, magic, BPSTORE_MAGIC_LEN) || memcmp(magic, BPSTORE_MAGIC, BPSTORE_MAGIC_LEN) ||
+      !__bgzf_read(m_fp, &ns, sizeof(uint32_t)))
+    return false;
+
+  m_ids.resize(ns);
+  m_labels.resize(ns);
+  for (size_t i = 0; i < ns; ++i)
+    if (!__bgzf_read_string(m_fp, m_ids[i]) || !__bgzf_read_string(m_fp, m_labels[i]))
+      return false;
+
+  m_block = BreakPointBlock(ns);
+  m_next = 0;
+
+  // load the block index, if there is one
+  m_offsets.clear();
+  std::ifstream idx(file + ".bpi");
+  std::string line;
+  while (std::getline(idx, line)) {
+    std::istringstream iss(line);
+    int64_t off;
+    if (iss >> off)
+      m_offsets.push_back(off);
+  }
+
+  return true;
+
+}
+
+bool BreakPointReader::NextBlock(BreakPointBlock& block) {
+
+  uint32_t nrec = 0;
+  uint64_t nbytes = 0;
+  if (!__bgzf_read(m_fp, &nrec, sizeof(uint32_t)) || !__bgzf_read(m_fp, &nbytes, sizeof(uint64_t)))
+    return false;
+
+  std::string payload(nbytes, '\0');
+  if (!__bgzf_read(m_fp, &payload[0], nbytes) || !block.deserialize(payload, m_ids.size()) || block.size() != nrec) {
+    std::cerr << "BreakPointReader - truncated or corrupt block" << std::endl;
+    return false;
+  }
+
+  return true;
+
+}
+
+bool BreakPointReader::Next(BreakPoint& bp, const SeqLib::BamHeader& h) {
+
+  while (m_next >= m_block.size()) {
+    if (!NextBlock(m_block))
+      return false;
+    m_next = 0;
+  }
+
+  m_block.get(m_next++, bp, m_ids, h);
+  return true;
+
+}
+
+bool BreakPointReader::SeekBlock(size_t i) {
+
+  if (i >= m_offsets.size() || bgzf_seek(m_fp, m_offsets[i], SEEK_SET) < 0)
+    return false;
+
+  m_block.clear();
+  m_next = 0;
+  return true;
+
+}
+
+bool IsBreakPointStore(const std::string& file) {
+
+  BGZF * fp = bgzf_open(file.c_str(), "r");
+  if (!fp)
+    return false;
+
+  char magic[BPSTORE_MAGIC_LEN];
+  bool is_store = __bgzf_read(fp, magic, BPSTORE_MAGIC_LEN) && !memcmp(magic, BPSTORE_MAGIC, BPSTORE_MAGIC_LEN);
+  bgzf_close(fp);
+  return is_store;
+
+}
+
+long ExportBreakPoints(const std::string& store, const std::string& text_file, const SeqLib::BamHeader& h) {
+
+  BreakPointReader reader;
+  if (!reader.Open(store))
+    return -1;
+
+  ogzstream out;
+  out.open(text_file.c_str(), std::ios::out);
+  if (!out)
+    return -1;
+
+  out << BreakPoint::header();
+  for (auto& l : reader.SampleLabels())
+    out << "\t" << l;
+  out << std::endl;
+
+  long count = 0;
+  BreakPoint bp;
+  while (reader.Next(bp, h)) {
+    out << bp.toFileString(true) << std::endl;
+    ++count;
+  }
+
+  out.close();
+  return count;
+
+}
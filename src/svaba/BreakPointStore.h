@@ -0,0 +1,167 @@
+#ifndef SVABA_BREAKPOINT_STORE_H__
+#define SVABA_BREAKPOINT_STORE_H__
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "htslib/bgzf.h"
+#include "SeqLib/BamHeader.h"
+
+#include "BreakPoint.h"
+
+/** A string column: lengths, then the bytes back to back */
+struct StringColumn {
+
+  std::vector<uint32_t> len;
+  std::string data;
+  std::vector<size_t> off; // start of each string. Filled on add and on read
+
+  void add(const std::string& s);
+  std::string get(size_t i) const { return data.substr(off[i], len[i]); }
+  void clear() { len.clear(); data.clear(); off.clear(); }
+
+};
+
+/** Columns of one sample's SampleInfo */
+struct SampleColumns {
+
+  std::vector<uint8_t> indel;
+  std::vector<uint32_t> genotype; // dictionary code
+  std::vector<int32_t> split, cigar, alt, cov, disc;
+  std::vector<double> GQ, LO_n, LO;
+  StringColumn PL;
+
+};
+
+/** One block of breakpoints, stored column by column.
+ *
+ * Numbers are fixed width. Chromosome names, evidence, confidence and genotype
+ * strings are coded against a dictionary that is local to the block, so each
+ * block can be decoded on its own.
+ */
+struct BreakPointBlock {
+
+  BreakPointBlock(size_t num_samples = 0) : samples(num_samples) {}
+
+  size_t size() const { return pos1.size(); }
+
+  void clear();
+
+  /** Add a breakpoint. Its alleles are stored in the order of sample_ids */
+  void add(const BreakPoint& bp, const std::vector<std::string>& sample_ids);
+
+  /** Fill bp with the i-th breakpoint of the block. If the header is empty,
+   * chromosome IDs are only consistent within the block (enough to export text) */
+  void get(size_t i, BreakPoint& bp, const std::vector<std::string>& sample_ids, const SeqLib::BamHeader& h) const;
+
+  void serialize(std::string& out) const;
+
+  bool deserialize(const std::string& in, size_t num_samples);
+
+  std::vector<std::string> dict;
+  std::unordered_map<std::string, uint32_t> dict_idx;
+
+  std::vector<int32_t> pos1, pos2, chr1, chr2; // chr1/chr2 are dictionary codes
+  std::vector<char> strand1, strand2;
+  std::vector<int32_t> mapq1, mapq2, nm1, nm2, dmapq1, dmapq2;
+  std::vector<int32_t> split, cigar, alt, cov, sub_n1, sub_n2;
+  std::vector<int32_t> num_align, quality, pon;
+  std::vector<uint8_t> secondary, blacklist;
+  std::vector<double> somatic_score, somatic_lod, max_lod;
+  std::vector<uint32_t> confidence, evidence; // dictionary codes
+  StringColumn ref, alt_seq, homology, insertion, cname, repeat_seq, rs, read_names, bxtable;
+
+  std::vector<SampleColumns> samples;
+
+ private:
+
+  uint32_t __code(const std::string& s);
+
+};
+
+/** Writes the breakpoints of a run to a BGZF-compressed, block columnar file.
+ *
+ * Each block is flushed to start a new BGZF block, so its virtual offset can
+ * be seeked to directly. The offsets are written to an index next to the file
+ * (file + ".bpi") on Close. Not thread safe: callers hold the output lock.
+ */
+class BreakPointWriter {
+
+ public:
+
+  BreakPointWriter() {}
+
+  ~BreakPointWriter() { Close(); }
+
+  /** Open the file and write the sample IDs (e.g. t000) and labels (column names of the text file) */
+  bool Open(const std::string& file, const std::vector<std::string>& sample_ids, const std::vector<std::string>& sample_labels);
+
+  /** Add a scored breakpoint. Formats its read name and BX strings the same way as BreakPoint::toFileString */
+  void Write(BreakPoint& bp, bool noreads);
+
+  /** Flush the last block, write the index and close the file */
+  void Close();
+
+  size_t NumWritten() const { return m_count; }
+
+ private:
+
+  void __flush_block();
+
+  BGZF * m_fp = nullptr;
+  std::string m_file;
+  std::vector<std::string> m_ids;
+  BreakPointBlock m_block;
+  std::vector<int64_t> m_offsets;
+  std::vector<size_t> m_block_sizes;
+  size_t m_count = 0;
+
+};
+
+/** Reads a file written by BreakPointWriter, one breakpoint or one block at a time */
+class BreakPointReader {
+
+ public:
+
+  BreakPointReader() {}
+
+  ~BreakPointReader();
+
+  /** Open a breakpoint store. Loads the block index if there is one */
+  bool Open(const std::string& file);
+
+  /** Read the next breakpoint into bp. False at the end of the file */
+  bool Next(BreakPoint& bp, const SeqLib::BamHeader& h);
+
+  /** Read the next whole block. False at the end of the file */
+  bool NextBlock(BreakPointBlock& block);
+
+  /** Jump to the start of the i-th block. Needs the index */
+  bool SeekBlock(size_t i);
+
+  size_t NumBlocks() const { return m_offsets.size(); }
+
+  const std::vector<std::string>& SampleIDs() const { return m_ids; }
+
+  const std::vector<std::string>& SampleLabels() const { return m_labels; }
+
+ private:
+
+  BGZF * m_fp = nullptr;
+  std::vector<std::string> m_ids, m_labels;
+  std::vector<int64_t> m_offsets;
+  BreakPointBlock m_block;
+  size_t m_next = 0; // next record in m_block
+
+};
+
+/** Check if the file is a breakpoint store (rather than a bps.txt.gz text file) */
+bool IsBreakPointStore(const std::string& file);
+
+/** Write the breakpoints in a store out as the bps.txt.gz text format.
+ * @return number of breakpoints written, or -1 if the files could not be opened
+ */
+long ExportBreakPoints(const std::string& store, const std::string& text_file, const SeqLib::BamHeader& h);
+
+#endif
@@ -1,126 +1,313 @@
 #include "DBSnpFilter.h"
 #include "gzstream.h"
 
+#include <algorithm>
+#include <fstream>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 using namespace SeqLib;
 
-DBSnpSite::DBSnpSite(const std::string& tchr, const std::string& pos, const std::string& rs, const std::string& ref, const std::string& alt, const BamHeader& h) {
-    
-    // make the genomic region
-    try { 
-      GenomicRegion gr(tchr, pos, pos, h);
-      chr = gr.chr; 
-      pos1 = std::stoi(pos);
-    } catch (...) {
-      //std::cerr << "DBSnpSite: Error trying to convert " << tchr << ":" << pos << " to number" << std::endl;
+// first bytes of the index. Last character is the format version
+static const char DBSNP_INDEX_MAGIC[] = "SVDBSNP2";
+#define DBSNP_INDEX_MAGIC_LEN 8
+
+static size_t __pad8(size_t n) { return (n + 7) & ~(size_t)7; }
+
+// read the indel sites of a VCF, grouped by chromosome in order of appearance
+static bool __parse_vcf(const std::string& vcf, std::vector<std::string>& names, std::vector<std::vector<DBSnpEntry> >& sites) {
+
+  if (!read_access_test(vcf))
+    return false;
+  igzstream in(vcf.c_str());
+  if (!in)
+    return false;
+
+  std::unordered_map<std::string, size_t> chr_idx;
+  std::string line;
+  std::string fields[5];
+  while (std::getline(in, line)) {
+
+    if (line.empty() || line.at(0) == '#')
+      continue;
+
+    // first five columns: CHROM POS ID REF ALT
+    size_t start = 0, f = 0;
+    for (; f < 5; ++f) {
+      size_t end = line.find('\t', start);
+      fields[f] = line.substr(start, end == std::string::npos ? std::string::npos : end - start);
+      if (end == std::string::npos) {
+	++f;
+	break;
+      }
+      start = end + 1;
+    }
+    const std::string& ref = fields[3];
+    const std::string& alt = fields[4];
+    if (f < 5 || ref.empty() || alt.empty()) {
+      std::cerr << "DBSnpFilter: Is the VCF formated correctly for this entry? " << line.substr(0, 100) << std::endl;
+      continue;
     }
 
-    //m_rs = rs;
-    //m_ref = ref;
-    //m_alt = alt;
+    // for now reject SNP sites
+    if (ref.length() + alt.length() <= 2)
+      continue;
 
-    if (ref.length() == 0 || alt.length() == 0) // || m_rs.length() == 0)
-      std::cerr << "DBSnpSite: Is the VCF formated correctly for this entry? Ref " << ref << " ALT " << alt << " rs " << rs << std::endl;
+    DBSnpEntry e;
+    try {
+      e.pos1 = std::stoi(fields[1]);
+    } catch (...) {
+      continue;
+    }
+    e.pos2 = ref.length() == 1 ? e.pos1 + 1 /* insertion */ : e.pos1 + ref.length() + 1; /* deletion */
 
-    // insertion
-    if (ref.length() == 1)
-      pos2 = pos1 + 1;
-    // deletion
-    else
-      pos2 = pos1 + ref.length() + 1;
-    
+    std::unordered_map<std::string, size_t>::const_iterator ff = chr_idx.find(fields[0]);
+    if (ff == chr_idx.end()) {
+      ff = chr_idx.insert(std::pair<std::string, size_t>(fields[0], names.size())).first;
+      names.push_back(fields[0]);
+      sites.push_back(std::vector<DBSnpEntry>());
+    }
+    sites[ff->second].push_back(e);
   }
 
+  // sort each chromosome by position
+  for (auto& s : sites)
+    std::sort(s.begin(), s.end(), [](const DBSnpEntry& a, const DBSnpEntry& b) {
+	return a.pos1 < b.pos1 || (a.pos1 == b.pos1 && a.pos2 < b.pos2);
+      });
+
+  return true;
+
+}
+
 DBSnpFilter::DBSnpFilter(const std::string& db, const BamHeader& h) {
-    
-    // read in the file
-    if (!read_access_test(db)) {
-      std::cerr << std::endl << "**** Cannot read DBSnp database " << db << "   Expecting a VCF file" << std::endl;
-      return;
-    }
 
-    // read it in
-    igzstream in(db.c_str());
-    if (!in) {
-      std::cerr << std::endl << "**** Cannot read DBSnp database " << db << "   Expecting a VCF file" << std::endl;
-      return;
-    }
+  bool ok = false;
+  if (IsIndex(db)) {
+    ok = __map_index(db);
+  } else if (IsIndex(db + ".svdb")) {
+    ok = __map_index(db + ".svdb");
+  } else {
+    std::cerr << "...reading DBSnp VCF " << db << ". Run \"svaba index-dbsnp " << db << "\" once to skip this" << std::endl;
+    ok = __read_vcf(db);
+  }
 
-    std::string line;
-    while (std::getline(in, line)) {
-
-      if (line.find("#") != std::string::npos || line.length() == 0)
-	continue;
-
-      std::istringstream thisline(line);
-      std::string val;
-      int this_count = -1;
-      std::string chr, pos, rs, ref, alt;
-      while (std::getline(thisline, val, '\t')) {
-	++this_count;
-	switch (this_count) { 
-	case 0: chr = val; break;
-	case 1: pos = val; break;
-	case 2: rs = val; break;
-	case 3: ref = val; break;
-	case 4: alt = val; break;
-	}
-      }
+  if (!ok) {
+    std::cerr << std::endl << "**** Cannot read DBSnp database " << db << "   Expecting a VCF file or svaba dbSNP index" << std::endl;
+    return;
+  }
+
+  __set_chr_ids(h);
+
+}
+
+DBSnpFilter::~DBSnpFilter() {
+  if (m_map)
+    munmap(m_map, m_map_size);
+}
+
+bool DBSnpFilter::IsIndex(const std::string& file) {
+
+  std::ifstream in(file.c_str(), std::ios::binary);
+  char magic[DBSNP_INDEX_MAGIC_LEN];
+  return in && in.read(magic, DBSNP_INDEX_MAGIC_LEN) && !memcmp(magic, DBSNP_INDEX_MAGIC, DBSNP_INDEX_MAGIC_LEN);
+
+}
+
+long DBSnpFilter::BuildIndex(const std::string& vcf, const std::string& index) {
+
+  std::vector<std::string> names;
+  std::vector<std::vector<DBSnpEntry> > sites;
+  if (!__parse_vcf(vcf, names, sites))
+    return -1;
+
+  std::ofstream out(index.c_str(), std::ios::binary);
+  if (!out)
+    return -1;
+
+  // header: magic, then the chromosome table, padded to 8 bytes so the entries are aligned
+  const char pad[8] = {0};
+  uint64_t nchr = names.size();
+  out.write(DBSNP_INDEX_MAGIC, DBSNP_INDEX_MAGIC_LEN);
+  out.write((const char*)&nchr, sizeof(uint64_t));
+  uint64_t start = 0;
+  for (size_t i = 0; i < names.size(); ++i) {
+    uint64_t len = names[i].length(), count = sites[i].size();
+    int64_t max_span = 0;
+    for (auto& e : sites[i])
+      max_span = std::max(max_span, (int64_t)(e.pos2 - e.pos1));
+    out.write((const char*)&len, sizeof(uint64_t));
+    out.write(names[i].data(), len);
+    out.write(pad, __pad8(len) - len);
+    out.write((const char*)&start, sizeof(uint64_t));
+    out.write((const char*)&count, sizeof(uint64_t));
+    out.write((const char*)&max_span, sizeof(int64_t));
+    start += count;
+  }
+
+  for (auto& s : sites)
+    if (s.size())
+      out.write((const char*)s.data(), s.size() * sizeof(DBSnpEntry));
+
+  return out ? (long)start : -1;
 
-      DBSnpSite db(chr, pos, rs, ref, alt, h);
-
-      // for now reject SNP sites
-      if (ref.length() + alt.length() > 2) {
-	m_sites.add(db);
-
-	// make the hash
-	cig.str(std::string());
-	//cig << db.chr << "_" << db.pos1 << "_" << (db.pos2-db.pos1) << (db.m_ref.length() == 1 ? "I" : "D");
-	cig << db.chr << "_" << db.pos1;
-	//m_hash.insert(cig.str());
-	
-	m_int_hash.insert(hasher(cig.str()));
-	//std::cerr << line << " hash " << cig.str() << std::endl;
-	
+}
+
+bool DBSnpFilter::__map_index(const std::string& index) {
+
+  int fd = open(index.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (fstat(fd, &st) < 0 || st.st_size < (off_t)(DBSNP_INDEX_MAGIC_LEN + sizeof(uint64_t))) {
+    close(fd);
+    return false;
+  }
+  m_map_size = st.st_size;
+  m_map = mmap(NULL, m_map_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (m_map == MAP_FAILED) {
+    m_map = nullptr;
+    return false;
+  }
+
+  // read the chromosome table
+  const char * base = (const char*)m_map;
+  size_t p = DBSNP_INDEX_MAGIC_LEN;
+  auto take = [&](size_t n) -> const char* {
+    if (p + n > m_map_size)
+      return nullptr;
+    const char * c = base + p;
+    p += n;
+    return c;
+  };
+
+  const char * c = take(sizeof(uint64_t));
+  uint64_t nchr = *(const uint64_t*)c;
+  m_chroms.resize(nchr);
+  for (auto& ch : m_chroms) {
+    if (!(c = take(sizeof(uint64_t))))
+      return false;
+    uint64_t len = *(const uint64_t*)c;
+    if (!(c = take(__pad8(len))))
+      return false;
+    ch.name.assign(c, len);
+    if (!(c = take(3 * sizeof(uint64_t))))
+      return false;
+    ch.start = ((const uint64_t*)c)[0];
+    ch.count = ((const uint64_t*)c)[1];
+    ch.max_span = ((const int64_t*)c)[2];
+    m_num_entries += ch.count;
+  }
+
+  if (p + m_num_entries * sizeof(DBSnpEntry) > m_map_size)
+    return false;
+  m_entries = (const DBSnpEntry*)(base + p);
+  return true;
+
+}
+
+bool DBSnpFilter::__read_vcf(const std::string& vcf) {
+
+  std::vector<std::string> names;
+  std::vector<std::vector<DBSnpEntry> > sites;
+  if (!__parse_vcf(vcf, names, sites))
+    return false;
+
+  for (size_t i = 0; i < names.size(); ++i) {
+    Chrom ch;
+    ch.name = names[i];
+    ch.start = m_own.size();
+    ch.count = sites[i].size();
+    for (auto& e : sites[i])
+      ch.max_span = std::max(ch.max_span, (int64_t)(e.pos2 - e.pos1));
+    m_own.insert(m_own.end(), sites[i].begin(), sites[i].end());
+    m_chroms.push_back(ch);
+  }
+  m_entries = m_own.data();
+  m_num_entries = m_own.size();
+  return true;
+
+}
+
+void DBSnpFilter::__set_chr_ids(const BamHeader& h) {
+
+  m_chr_idx.assign(h.NumSequences(), -1);
+  for (size_t i = 0; i < m_chroms.size(); ++i) {
+
+    // allow for the VCF and the BAM to disagree on the "chr" prefix
+    const std::string& n = m_chroms[i].name;
+    std::string alt_name = n.compare(0, 3, "chr") ? "chr" + n : n.substr(3);
+    for (auto& name : {n, alt_name}) {
+      int id = -1;
+      try {
+	id = h.Name2ID(name);
+      } catch (...) {
+      }
+      if (id >= 0 && id < (int)m_chr_idx.size() && m_chr_idx[id] < 0) {
+	m_chr_idx[id] = i;
+	break;
       }
     }
-    
-    // build the tree
-    m_sites.CreateTreeMap();
-
   }
 
+}
+
+const DBSnpFilter::Chrom* DBSnpFilter::__chrom(int32_t chr) const {
+  if (chr < 0 || chr >= (int32_t)m_chr_idx.size() || m_chr_idx[chr] < 0)
+    return nullptr;
+  return &m_chroms[m_chr_idx[chr]];
+}
+
   std::ostream& operator<<(std::ostream& out, const DBSnpFilter& d) {
-    out << "DBSnpFilter with a total of " << AddCommas<size_t>(d.m_sites.size());
+    out << "DBSnpFilter with a total of " << AddCommas<size_t>(d.size());
     return out;
   }
 
-  std::ostream& operator<<(std::ostream& out, const DBSnpSite& d) {
-    //out << d.chr << ":" << d.pos1 << "-" << d.pos2 << "\t" << d.m_rs << " REF " << d.m_ref << " ALT " << d.m_alt;
-    out << d.chr << ":" << d.pos1 << "-" << d.pos2;;
-    return out;
-  }
+  bool DBSnpFilter::queryBreakpoint(BreakPoint& bp) const {
 
-  bool DBSnpFilter::queryHash(const std::string& h) const {
-    //return m_hash.count(h);
-    return m_int_hash.count(hasher(h));
-  }
+    const Chrom * ch = __chrom(bp.b1.gr.chr);
+    if (!ch || !ch->count)
+      return false;
 
-  bool DBSnpFilter::queryBreakpoint(BreakPoint& bp) {
-    
-    std::vector<int32_t> sub, que;
-    GenomicRegion gr = bp.b1.gr;
-    gr.Pad(2);
-    GRC subject(gr);
-    GRC out = subject.FindOverlaps(m_sites, sub, que, true); // true = ignore_strand
-    
-    if (que.size()) {
-      //bp.rs = m_sites[sub[0]].m_rs;
-      bp.rs = "D"; 
-      //for (auto& j : que) {
-      //bp.rs += m_sites[j].m_rs + "_";
-      //}
-      //bp.rs.pop_back(); // just drop the last comma
-      return true;
+    // sites are sorted by start, so any site overlapping the (padded)
+    // breakpoint starts at most max_span before it
+    int64_t qs = (int64_t)bp.b1.gr.pos1 - 2, qe = (int64_t)bp.b1.gr.pos2 + 2;
+    const DBSnpEntry * first = m_entries + ch->start;
+    const DBSnpEntry * it = std::upper_bound(first, first + ch->count, qe,
+					     [](int64_t v, const DBSnpEntry& e) { return v < e.pos1; });
+    while (it != first) {
+      --it;
+      if (it->pos1 < qs - ch->max_span)
+	break;
+      if (it->pos2 >= qs) {
+	bp.rs = "D";
+	return true;
+      }
     }
     return false;
   }
+
+void runIndexDBSnp(int argc, char** argv) {
+
+  if (argc < 2 || argc > 3) {
+    std::cerr << "Usage: svaba index-dbsnp dbsnp.vcf[.gz] [index]\n\n"
+	      << "  Description: Index the indel sites of a dbSNP VCF for fast lookup with -D. The index\n"
+	      << "               is written to dbsnp.vcf.svdb by default, where -D dbsnp.vcf will find it\n";
+    exit(EXIT_FAILURE);
+  }
+
+  std::string vcf = argv[1];
+  std::string index = argc == 3 ? std::string(argv[2]) : vcf + ".svdb";
+  long count = DBSnpFilter::BuildIndex(vcf, index);
+  if (count < 0) {
+    std::cerr << "ERROR: Could not read " << vcf << " or write " << index << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  std::cerr << "...wrote " << AddCommas(count) << " dbSNP indel sites to " << index << std::endl;
+
+}
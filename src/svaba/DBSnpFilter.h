@@ -2,63 +2,89 @@
 #define SNOWTOOLS_DBSNP_FILTER_H__
 
 #include <vector>
+#include <string>
 #include <cstring>
 #include <iostream>
-#include <unordered_set>
-#include <functional> //for std::hash
+#include <stdint.h>
 
-#include "SeqLib/GenomicRegionCollection.h"
 #include "SeqLib/BamHeader.h"
 
 #include "BreakPoint.h"
 
-class DBSnpSite: public SeqLib::GenomicRegion {
+/** One dbSNP indel site, as stored in the index */
+struct DBSnpEntry {
+  int32_t pos1;
+  int32_t pos2;
+};
+
+  /** Lookup of dbSNP indel sites.
+   *
+   * Sites are kept per chromosome, sorted by position, so queries are a binary
+   * search. The sites are read from an index made once with "svaba index-dbsnp",
+   * which is memory-mapped rather than read in, or else parsed from the VCF.
+   */
+  class DBSnpFilter {
 
   public:
 
-  DBSnpSite(const std::string& tchr, const std::string& pos, const std::string& rs, const std::string& ref, const std::string& alt, const SeqLib::BamHeader& h);
+    DBSnpFilter() {}
 
-    //std::string m_rs;
-    //std::string m_ref;
-    //std::string m_alt;
+    /** Open a dbSNP index, or the index next to a VCF (db + ".svdb"), or else read the VCF */
+    DBSnpFilter(const std::string& db, const SeqLib::BamHeader& h);
 
-    friend std::ostream& operator<<(std::ostream& out, const DBSnpSite& d);
-    
-  };
+    ~DBSnpFilter();
 
-typedef SeqLib::GenomicRegionCollection<DBSnpSite> DBC;
+    DBSnpFilter(const DBSnpFilter&) = delete;
+    DBSnpFilter& operator=(const DBSnpFilter&) = delete;
 
-  class DBSnpFilter {
-    
-  public:
-
-    DBSnpFilter() {}
+    /** Test whether the variant overlaps a DBSnp site
+     * If it does, fill the BreakPoint rs field
+     */
+    bool queryBreakpoint(BreakPoint& bp) const;
 
-    DBSnpFilter(const std::string& db, const SeqLib::BamHeader& h); 
+    size_t size() const { return m_num_entries; }
 
-    /** Test whether the variant overlaps a DBSnp site 
-     * If it does, fill the BreakPoint rs field
+    /** Write the indel sites of a dbSNP VCF to an index file.
+     * @return number of sites written, or -1 if the files could not be opened
      */
-    bool queryBreakpoint(BreakPoint& bp);
+    static long BuildIndex(const std::string& vcf, const std::string& index);
 
-    bool queryRead(const SeqLib::BamRecord& r) const;
+    /** Check if the file is a dbSNP index */
+    static bool IsIndex(const std::string& file);
 
-    bool queryHash(const std::string& r) const;
-    
     friend std::ostream& operator<<(std::ostream& out, const DBSnpFilter& d);
 
   private:
 
-    std::hash<std::string> hasher;
-    
-    // initialize here once
-    std::stringstream cig;
+    // the sites of one chromosome
+    struct Chrom {
+      std::string name;
+      uint64_t start = 0; // first entry
+      uint64_t count = 0;
+      int64_t max_span = 0; // longest site, to bound the search for overlaps
+    };
+
+    bool __map_index(const std::string& index);
+
+    bool __read_vcf(const std::string& vcf);
+
+    void __set_chr_ids(const SeqLib::BamHeader& h);
 
-    DBC m_sites;
-    std::unordered_set<std::string> m_hash;
+    const Chrom* __chrom(int32_t chr) const;
+
+    std::vector<Chrom> m_chroms;
+    std::vector<int> m_chr_idx; // header chr ID -> index in m_chroms (-1 if none)
+
+    const DBSnpEntry * m_entries = nullptr;
+    size_t m_num_entries = 0;
+    std::vector<DBSnpEntry> m_own; // entries, if read from the VCF
+
+    void * m_map = nullptr;
+    size_t m_map_size = 0;
 
-    std::unordered_set<size_t> m_int_hash;
-    
   };
 
+/** svaba index-dbsnp */
+void runIndexDBSnp(int argc, char** argv);
+
 #endif
@@ -4,6 +4,8 @@
 #include <cassert>
 #include <numeric>
 #include <unordered_set>
+#include <algorithm>
+#include <cstring>
 
 #include "SeqLib/BamWalker.h"
 #include "svabaUtils.h"
@@ -16,15 +18,81 @@
 
 using namespace SeqLib;
 
-  DiscordantClusterMap DiscordantCluster::clusterReads(const svabaReadVector& bav, const GenomicRegion& interval, int max_mapq_possible, const std::unordered_map<std::string, int> * min_isize_for_disc) {
+  // pack a (chr, pos) pair into a single integer that sorts like BamRecordSort::ByReadPosition
+  static inline int64_t __pack_pos(int chr, int pos) {
+    return static_cast<int64_t>(chr) * 4294967296LL + static_cast<uint32_t>(pos);
+  }
+  static inline int __key_chr(int64_t k) { return static_cast<int>(k >> 32); }
+  static inline int __key_pos(int64_t k) { return static_cast<int32_t>(static_cast<uint32_t>(k)); }
+
+  void ReadGroupCutoffs::Add(const std::string& rg, int cutoff) {
+    for (auto& i : m_rg)
+      if (i == rg)
+	return;
+    m_rg.push_back(rg);
+    m_cutoff.push_back(cutoff);
+  }
+
+  const char* ReadGroupCutoffs::__rg_of(const svabaRead& r, size_t& len) {
+
+    const char* rg = "NA";
+    uint8_t* p = bam_aux_get(r.raw(), "RG");
+    if (p) {
+      const char* z = bam_aux2Z(p);
+      if (z)
+	rg = z;
+    }
+    len = strlen(rg);
+
+    // temporary hack for simulated data
+    if (strstr(rg, "tumor")) {
+      const char* qn = bam_get_qname(r.raw());
+      const char* c = strchr(qn, ':');
+      if (c) {
+	rg = qn;
+	len = c - qn;
+      }
+    }
+    return rg;
+  }
+
+  std::string ReadGroupCutoffs::Name(const svabaRead& r) {
+    size_t len;
+    const char* rg = __rg_of(r, len);
+    return std::string(rg, len);
+  }
+
+  int ReadGroupCutoffs::ID(const svabaRead& r, int hint) const {
+    
+    size_t len;
+    const char* rg = __rg_of(r, len);
+
+    // reads are usually from a run of the same read group, so check the last hit first
+    if (hint >= 0 && hint < (int)m_rg.size() && m_rg[hint].length() == len && !m_rg[hint].compare(0, len, rg, len))
+      return hint;
+
+    for (size_t i = 0; i < m_rg.size(); ++i)
+      if (m_rg[i].length() == len && !m_rg[i].compare(0, len, rg, len))
+	return i;
+    return -1;
+  }
+
+  DiscordantClusterMap DiscordantCluster::clusterReads(const svabaReadVector& bav, const GenomicRegion& interval, int max_mapq_possible, const ReadGroupCutoffs * min_isize_for_disc) {
 
 #ifdef DEBUG_CLUSTER    
     //for (auto& i : bav)
     //  std::cerr << " PRE DEDUPED CLUSTER " << i << std::endl;
 #endif
 
-    // only add the discordant reads, respecting diff size cutoffs for diff RG
+    // the orientations, in the order they are clustered
+    static const int orientations[4] = {FRORIENTATION, FFORIENTATION, RFORIENTATION, RRORIENTATION};
+
+    // only add the discordant reads, respecting diff size cutoffs for diff RG.
+    // Bucket them by orientation on the way in, so each orientation is swept once
     svabaReadVector bav_dd;
+    std::vector<int64_t> rkey, mkey; // packed read and mate positions, parallel to bav_dd
+    std::vector<size_t> obucket[4];
+    int rg_hint = -1;
     for (auto& r : bav) {
      
       // if suspicious as discordant, remove from clustering
@@ -34,97 +102,126 @@ using namespace SeqLib;
       // find the discordant size cutoff for this read
       int cutoff = DEFAULT_ISIZE_THRESHOLD;
       if (min_isize_for_disc) {
-
-	std::string RG;
-	if (!r.GetZTag("RG", RG))
-	  RG = "NA";
-
-	// temporary hack for simulated data
-	if (RG.find("tumor") != std::string::npos) {
-	  std::string qn = r.Qname();
-	  size_t posr = qn.find(":", 0);
-	  RG = (posr != std::string::npos) ? qn.substr(0, posr) : RG;
+	int id = min_isize_for_disc->ID(r, rg_hint);
+	if (id >= 0) {
+	  cutoff = min_isize_for_disc->Cutoff(id);
+	  rg_hint = id;
 	} else {
-	  // best practice without "tumor" hack
-	  //RG = r.ParseReadGroup();
+	  std::cerr << "Couldn't find RG " << ReadGroupCutoffs::Name(r) << " Setting cutoff to default (800) " << std::endl;
 	}
-
-	std::unordered_map<std::string, int>::const_iterator ff = min_isize_for_disc->find(RG);
-	if (ff != min_isize_for_disc->end()) {
-	  cutoff = ff->second;
-	} else {
-	  std::cerr << "Couldn't find RG " << RG << " Setting cutoff to default (800) " << std::endl;
-	}
-
       }
+
       // accept as discordant if not FR, has large enough isize, is inter-chromosomal, 
       // and has both mates mapping. Also dont cluster on weird chr
-      if ( ( r.PairOrientation() != FRORIENTATION || r.FullInsertSize() >= cutoff || r.Interchromosomal()) && 
+      int orientation = r.PairOrientation();
+      if ( ( orientation != FRORIENTATION || r.FullInsertSize() >= cutoff || r.Interchromosomal()) && 
 	   r.PairMappedFlag() /* && r.ChrID() < 24 && r.MateChrID() < 24 */  &&
-           r.NumMatchBases() > r.NumHardClip()) // has to have mostly not-hardclip
+           r.NumMatchBases() > r.NumHardClip()) { // has to have mostly not-hardclip
+	for (size_t o = 0; o < 4; ++o)
+	  if (orientation == orientations[o])
+	    obucket[o].push_back(bav_dd.size());
 	bav_dd.push_back(r);
+	rkey.push_back(__pack_pos(r.ChrID(), r.Position()));
+	mkey.push_back(__pack_pos(r.MateChrID(), r.MatePosition()));
+      }
     }
     
     if (!bav_dd.size())
       return DiscordantClusterMap();
 
-    // sort by position
-    std::sort(bav_dd.begin(), bav_dd.end(), BamRecordSort::ByReadPosition());
+    // give each qname a dense integer ID, and group the reads by it (CSR layout)
+    // so that mates can be found without scanning the full pile for every cluster
+    std::unordered_map<std::string, int> qid_map;
+    qid_map.reserve(bav_dd.size());
+    std::vector<int> qid(bav_dd.size());
+    for (size_t i = 0; i < bav_dd.size(); ++i)
+      qid[i] = qid_map.emplace(bav_dd[i].Qname(), qid_map.size()).first->second;
+
+    std::vector<size_t> qid_start(qid_map.size() + 1, 0);
+    for (auto& q : qid)
+      ++qid_start[q + 1];
+    for (size_t q = 1; q < qid_start.size(); ++q)
+      qid_start[q] += qid_start[q - 1];
+    std::vector<size_t> qid_reads(bav_dd.size());
+    std::vector<size_t> qid_fill(qid_start.begin(), qid_start.end() - 1);
+    for (size_t i = 0; i < bav_dd.size(); ++i)
+      qid_reads[qid_fill[qid[i]]++] = i;
+
+    // order by read position, as a sorted pile would be
+    auto by_rkey = [&rkey](size_t a, size_t b) { return rkey[a] < rkey[b]; };
+    auto by_mkey = [&mkey](size_t a, size_t b) { return mkey[a] < mkey[b]; };
+    for (size_t q = 0; q + 1 < qid_start.size(); ++q)
+      if (qid_start[q + 1] - qid_start[q] > 1)
+	std::stable_sort(qid_reads.begin() + qid_start[q], qid_reads.begin() + qid_start[q + 1], by_rkey);
 
 #ifdef DEBUG_CLUSTER    
     //for (auto& i : bav_dd)
     //  std::cerr << " DEDUPED CLUSTER " << i << std::endl;
 #endif
 
-    // clear the tmp map. Now we want to use it to store if we already clustered read
-    //tmp_map.clear();
+    std::vector<std::vector<size_t> > fwd, rev, fwdfwd, revrev, fwdrev, revfwd;
     
-    svabaReadClusterVector fwd, rev, fwdfwd, revrev, fwdrev, revfwd;
-    std::pair<int, int> fwd_info, rev_info; // refid, pos
-    fwd_info = {-1,-1};
-    rev_info = {-1,-1};
-    
-    // make the fwd and reverse READ clusters. dont consider mate yet
-    __cluster_reads(bav_dd, fwd, rev, FRORIENTATION);
-    __cluster_reads(bav_dd, fwd, rev, FFORIENTATION);
-    __cluster_reads(bav_dd, fwd, rev, RFORIENTATION);
-    __cluster_reads(bav_dd, fwd, rev, RRORIENTATION);
+    // make the fwd and reverse READ clusters. dont consider mate yet.
+    // Reads come off the walkers mostly sorted, so only sort a bucket if it needs it
+    std::vector<int> seen(qid_map.size(), -1);
+    for (size_t o = 0; o < 4; ++o) {
+      
+      std::vector<size_t>& ob = obucket[o];
+      if (!std::is_sorted(ob.begin(), ob.end(), by_rkey))
+	std::stable_sort(ob.begin(), ob.end(), by_rkey);
 
-    // remove singletons
-    __remove_singletons(fwd);
-    __remove_singletons(rev);
+      // only cluster if not seen before (e.g. left-most is READ, right most is MATE)
+      std::vector<size_t> this_fwd, this_rev;
+      for (auto& i : ob) {
+	if (seen[qid[i]] == (int)o)
+	  continue;
+	seen[qid[i]] = o;
+	if (!bav_dd[i].ReverseFlag())
+	  this_fwd.push_back(i);
+	else
+	  this_rev.push_back(i);
+      }
+
+      __sweep_clusters(this_fwd, rkey, fwd);
+      __sweep_clusters(this_rev, rkey, rev);
+    }
 
 #ifdef DEBUG_CLUSTER
     for (auto& i : fwd) {
       std::cerr << "fwd cluster " << std::endl;
       for (auto& j : i)
-	std::cerr << "fwd " << j << std::endl;
+	std::cerr << "fwd " << bav_dd[j] << std::endl;
     }
     for (auto& i : rev) {
       std::cerr << "rev cluster " << std::endl;
       for (auto& j : i)
-	std::cerr << "rev " << j << std::endl;
+	std::cerr << "rev " << bav_dd[j] << std::endl;
     }
 #endif
 
-    // within the forward read clusters, cluster mates on fwd and rev
-    __cluster_mate_reads(fwd, fwdfwd, fwdrev);
-    
-    // within the reverse read clusters, cluster mates on fwd and rev
-    __cluster_mate_reads(rev, revfwd, revrev); 
-
-    // remove singletons
-    __remove_singletons(fwdfwd);
-    __remove_singletons(revfwd);
-    __remove_singletons(fwdrev);
-    __remove_singletons(revrev);
+    // within the read clusters, cluster mates on fwd and rev
+    for (size_t k = 0; k < 2; ++k) {
+      std::vector<std::vector<size_t> >& brcv = k ? rev : fwd;
+      for (auto& v : brcv) {
+	std::stable_sort(v.begin(), v.end(), by_mkey);
+	std::vector<size_t> this_fwd, this_rev;
+	for (auto& i : v) {
+	  if (!bav_dd[i].MateReverseFlag())
+	    this_fwd.push_back(i);
+	  else
+	    this_rev.push_back(i);
+	}
+	__sweep_clusters(this_fwd, mkey, k ? revfwd : fwdfwd);
+	__sweep_clusters(this_rev, mkey, k ? revrev : fwdrev);
+      }
+    }
     
     // we have the reads in their clusters. Just convert to discordant reads clusters
     DiscordantClusterMap dd;
-    __convertToDiscordantCluster(dd, fwdfwd, bav_dd, max_mapq_possible);
-    __convertToDiscordantCluster(dd, fwdrev, bav_dd, max_mapq_possible);
-    __convertToDiscordantCluster(dd, revfwd, bav_dd, max_mapq_possible);
-    __convertToDiscordantCluster(dd, revrev, bav_dd, max_mapq_possible);
+    __convertToDiscordantCluster(dd, fwdfwd, bav_dd, qid, qid_start, qid_reads, max_mapq_possible);
+    __convertToDiscordantCluster(dd, fwdrev, bav_dd, qid, qid_start, qid_reads, max_mapq_possible);
+    __convertToDiscordantCluster(dd, revfwd, bav_dd, qid, qid_start, qid_reads, max_mapq_possible);
+    __convertToDiscordantCluster(dd, revrev, bav_dd, qid, qid_start, qid_reads, max_mapq_possible);
 
 #ifdef DEBUG_CLUSTER
     std::cerr << "----fwd cluster count: " << fwd.size() << std::endl;
@@ -133,18 +230,6 @@ using namespace SeqLib;
     std::cerr << "----fwdrev cluster count: " << fwdrev.size() << std::endl;
     std::cerr << "----revfwd cluster count: " << revfwd.size() << std::endl;
     std::cerr << "----revrev cluster count: " << revrev.size() << std::endl;
-
-    for (auto& ii : fwdrev) {
-      std::cerr << " ____________ CLUSTER ______________" << std::endl;
-      for (auto& jj : ii)
-	std::cerr << "FWDREV _____ " << jj << std::endl;
-    }
-    for (auto& ii : revfwd) {
-      std::cerr << " ____________ CLUSTER ______________" << std::endl;
-      for (auto& jj : ii)
-	std::cerr << "FWDREV _____ " << jj << std::endl;
-    }
-      
 #endif    
 
     // remove clusters that dont overlap with the window
@@ -502,139 +587,62 @@ std::string DiscordantCluster::print(const SeqLib::BamHeader& h) const {
   /**
    * Cluster reads by alignment position 
    * 
-   * Checks whether a read belongs to a cluster. If so, adds it. If not, ends
-   * and stores cluster, adds a new one.
+   * Sweeps a position-ordered list of reads. A read joins the current cluster if it
+   * is on the same chromosome and within DISC_PAD of the last read, unless the cluster
+   * already spans more than 3000bp. Otherwise the current cluster is closed and stored
+   * (if it has at least MIN_PER_CLUST reads) and a new one is started.
    *
-   * @param cvec Stores the vector of clusters, which themselves are vectors of read pointers
-   * @param clust The current cluster that is being added to
-   * @param a Read to add to cluster
-   * @param mate Flag to specify if we should cluster on mate position instead of read position
-   * @return Description of the return value
+   * @param idx Indices of the reads to cluster, ordered by key
+   * @param key Packed (chr, pos) for each read (read or mate position)
+   * @param out Stores the clusters, as vectors of read indices
    */
-  bool DiscordantCluster::__add_read_to_cluster(svabaReadClusterVector &cvec, svabaReadVector &clust, const svabaRead &a, bool mate) {
-
-    // get the position of the previous read. If none, we're starting a new one so make a dummy
-    std::pair<int,int> last_info;
-    if (clust.size() == 0)
-      last_info = {-1, -1};
-    else if (mate)
-      last_info = {clust.back().MateChrID(), clust.back().MatePosition()};
-    else
-      last_info = {clust.back().ChrID(), clust.back().Position()};
-    
-    // get the position of the current read
-    std::pair<int,int> this_info;
-    if (mate)
-      this_info = {a.MateChrID(), a.MatePosition()};
-    else 
-      this_info = {a.ChrID(), a.Position()};
-
-    // is this cluster too big? happens if too many discordant reads. Enforce a hard cutoff
-    bool too_big;
-    if (mate)
-      too_big = (clust.size() > 1 && (clust.back().MatePosition() - clust[0].MatePosition()) > 3000);
-    else
-      too_big = (clust.size() > 1 && (clust.back().Position() - clust[0].Position()) > 3000);      
-    
-    // note to self. this rarely gets hit?
-    //if (too_big) 
-    //  std::cerr << "Cluster too big at " << clust[0].Brief() << " to " << clust.back().Brief() << ". Breaking off after 3000bp" << std::endl;
+  void DiscordantCluster::__sweep_clusters(const std::vector<size_t>& idx, const std::vector<int64_t>& key, std::vector<std::vector<size_t> >& out) {
 
-    // check if this read is close enough to the last
-    if (!too_big &&  (this_info.first == last_info.first) && (this_info.second - last_info.second) <= DISC_PAD) {
+    std::vector<size_t> clust;
+    for (auto& i : idx) {
 
-      // read belongs in current cluster, so add
-      clust.push_back(a);
-      last_info = this_info;
-      return true;
-      
-    // read does not belong to cluster. close this cluster and add to cvec
-    } else {
-      
-      // if enough supporting reads, add as a cluster
-      if (clust.size() >= MIN_PER_CLUST) {
-	cvec.push_back(clust);
-      }
-      
-      // clear this cluster and start a new one
-      clust.clear();
-      clust.push_back(a);
-      
-      return false;
-    }
-  }
+      if (clust.size()) {
+	int64_t last = key[clust.back()];
 
-  void DiscordantCluster::__cluster_mate_reads(svabaReadClusterVector& brcv, svabaReadClusterVector& fwd, svabaReadClusterVector& rev)
-  {
-    // loop through the clusters, and cluster within clusters based on mate read
-    for (auto& v : brcv) 
-      {
-	svabaReadVector this_fwd, this_rev;
-	std::sort(v.begin(), v.end(), BamRecordSort::ByMatePosition());
+	// is this cluster too big? happens if too many discordant reads. Enforce a hard cutoff
+	bool too_big = clust.size() > 1 && (__key_pos(last) - __key_pos(key[clust[0]])) > 3000;
 
-	for (auto& r : v) 
-	  {
-	    // forward clustering
-	    if (!r.MateReverseFlag())
-	      __add_read_to_cluster(fwd, this_fwd, r, true);
-	    // reverse clustering 
-	    else if (r.MateReverseFlag()) 
-	      __add_read_to_cluster(rev, this_rev, r, true);
-	    
-	  }
-	// finish the last clusters
-	if (this_fwd.size() > 0)
-	  fwd.push_back(this_fwd);
-	if (this_rev.size() > 0)
-	  rev.push_back(this_rev);
-      } // finish main cluster loop
-  }
-  
-  void DiscordantCluster::__cluster_reads(const svabaReadVector& brv, svabaReadClusterVector& fwd, svabaReadClusterVector& rev, int orientation) 
-  {
-
-    // hold the current cluster
-    svabaReadVector this_fwd, this_rev;
-
-    std::unordered_set<std::string> tmp_set;
-
-    // cluster in the READ direction, separately for fwd and rev
-    for (auto& i : brv) {
-
-      // only cluster FR reads together, RF reads together, FF together and RR together
-      if (i.PairOrientation() != orientation) {
-	continue;
+	// check if this read is close enough to the last
+	if (!too_big && __key_chr(key[i]) == __key_chr(last) && (__key_pos(key[i]) - __key_pos(last)) <= DISC_PAD) {
+	  clust.push_back(i);
+	  continue;
+	}
       }
 
-      std::string qq = i.Qname();
-
-      // only cluster if not seen before (e.g. left-most is READ, right most is MATE)
-      if (i.PairMappedFlag() && tmp_set.count(qq) == 0) {
-
-	tmp_set.insert(qq);
-
-	// forward clustering
-	if (!i.ReverseFlag()) 
-	  __add_read_to_cluster(fwd, this_fwd, i, false);
-	// reverse clustering 
-	else 
-	  __add_read_to_cluster(rev, this_rev, i, false);
-      }
+      // read does not belong to cluster. close this cluster and start a new one
+      if (clust.size() >= MIN_PER_CLUST)
+	out.push_back(clust);
+      clust.clear();
+      clust.push_back(i);
     }
 
-    // finish the last clusters
-    if (this_fwd.size() > 0) 
-      fwd.push_back(this_fwd);
-    if (this_rev.size() > 0)
-      rev.push_back(this_rev);
-
+    // finish the last cluster
+    if (clust.size() >= MIN_PER_CLUST)
+      out.push_back(clust);
   }
 
-  void DiscordantCluster::__convertToDiscordantCluster(DiscordantClusterMap &dd, const svabaReadClusterVector& cvec, const svabaReadVector& bav, int max_mapq_possible) {
+  void DiscordantCluster::__convertToDiscordantCluster(DiscordantClusterMap &dd, const std::vector<std::vector<size_t> >& cvec, const svabaReadVector& bav, 
+						       const std::vector<int>& qid, const std::vector<size_t>& qid_start, const std::vector<size_t>& qid_reads, int max_mapq_possible) {
     
     for (auto& v : cvec) {
       if (v.size() > 1) {
-	DiscordantCluster d(v, bav, max_mapq_possible); /// slow but works (erm, not really slow)
+
+	// only the reads sharing a qname with this cluster can be its mates, so
+	// hand those (in position order) to the cluster instead of the full pile
+	svabaReadVector this_reads, cand;
+	this_reads.reserve(v.size());
+	for (auto& i : v) {
+	  this_reads.push_back(bav[i]);
+	  for (size_t j = qid_start[qid[i]]; j < qid_start[qid[i] + 1]; ++j)
+	    cand.push_back(bav[qid_reads[j]]);
+	}
+	
+	DiscordantCluster d(this_reads, cand, max_mapq_possible);
 	dd[d.m_id] = d;
       }
     }
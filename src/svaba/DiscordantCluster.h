@@ -11,6 +11,47 @@
 
 typedef std::vector<svabaReadVector> svabaReadClusterVector;
 
+  /** Minimum insert size to call a read pair discordant, stored densely by read group.
+   *
+   * Built once from the learned BAM parameters, so that clustering resolves the
+   * cutoff for a read by comparing its raw RG tag against a small array rather than
+   * copying the tag and hashing it for every read.
+   */
+  class ReadGroupCutoffs 
+  {
+
+  public:
+
+    ReadGroupCutoffs() {}
+
+    /** Add a read group and its cutoff. Read groups already present are ignored */
+    void Add(const std::string& rg, int cutoff);
+
+    /** Return the dense ID of the read group for this read, or -1 if not found 
+     * @param r Read to resolve
+     * @param hint ID to check first (e.g. the ID of the previous read)
+     */
+    int ID(const svabaRead& r, int hint = -1) const;
+
+    /** Return the read group name that would be looked up for this read */
+    static std::string Name(const svabaRead& r);
+
+    /** Return the cutoff for a dense read group ID */
+    int Cutoff(int id) const { return m_cutoff[id]; }
+
+    size_t size() const { return m_rg.size(); }
+
+    bool empty() const { return m_rg.empty(); }
+
+  private:
+
+    // resolve the RG of a read to a pointer into the raw record, without copying
+    static const char* __rg_of(const svabaRead& r, size_t& len);
+
+    std::vector<std::string> m_rg;
+    std::vector<int> m_cutoff;
+  };
+
   /** Class to hold clusters of discordant reads */
   class DiscordantCluster 
   {
@@ -70,15 +111,12 @@ typedef std::vector<svabaReadVector> svabaReadClusterVector;
 
     static void __remove_singletons(svabaReadClusterVector& b);
 
-    static std::unordered_map<std::string, DiscordantCluster> clusterReads(const svabaReadVector& bav, const SeqLib::GenomicRegion& interval, int max_mapq_possible, const std::unordered_map<std::string, int> * min_isize_for_disc);
-
-    static bool __add_read_to_cluster(svabaReadClusterVector &cvec, svabaReadVector &clust, const svabaRead &a, bool mate);
-
-    static void __cluster_reads(const svabaReadVector& brv, svabaReadClusterVector& fwd, svabaReadClusterVector& rev, int orientation);
+    static std::unordered_map<std::string, DiscordantCluster> clusterReads(const svabaReadVector& bav, const SeqLib::GenomicRegion& interval, int max_mapq_possible, const ReadGroupCutoffs * min_isize_for_disc);
 
-    static void __cluster_mate_reads(svabaReadClusterVector& brcv, svabaReadClusterVector& fwd, svabaReadClusterVector& rev);
+    static void __sweep_clusters(const std::vector<size_t>& idx, const std::vector<int64_t>& key, std::vector<std::vector<size_t> >& out);
 
-    static void __convertToDiscordantCluster(std::unordered_map<std::string, DiscordantCluster> &dd, const svabaReadClusterVector& cvec, const svabaReadVector& bav, int max_mapq_possible);
+    static void __convertToDiscordantCluster(std::unordered_map<std::string, DiscordantCluster> &dd, const std::vector<std::vector<size_t> >& cvec, const svabaReadVector& bav, 
+					     const std::vector<int>& qid, const std::vector<size_t>& qid_start, const std::vector<size_t>& qid_reads, int max_mapq_possible);
 
     /** Query an interval against the two regions of the cluster. If the region overlaps
      * with one region, return the other region. This is useful for finding the partner 
@@ -0,0 +1,26 @@
+#include "IndelCigarMap.h"
+#include "svaba_params.h"
+
+#include <algorithm>
+
+void IndelCigarMap::grow() {
+
+  std::vector<uint64_t> keys(std::max(m_keys.size() * 2, (size_t)INDEL_CIGAR_MAP_MIN_SLOTS), 0);
+  std::vector<uint32_t> counts(keys.size(), 0);
+  keys.swap(m_keys);
+  counts.swap(m_counts);
+
+  for (size_t i = 0; i < keys.size(); ++i)
+    if (keys[i]) {
+      size_t j = slot(keys[i]);
+      m_keys[j] = keys[i];
+      m_counts[j] = counts[i];
+    }
+}
+
+void IndelCigarMap::clear() {
+  m_keys.clear();
+  m_counts.clear();
+  m_size = 0;
+  m_overflow.clear();
+}
@@ -0,0 +1,93 @@
+#ifndef SVABA_INDEL_CIGAR_MAP_H__
+#define SVABA_INDEL_CIGAR_MAP_H__
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+
+#include "svabaUtils.h"
+
+/** Number of reads of one sample with each indel in their CIGAR.
+ *
+ * An indel (chr, position on the reference, length, D or I) is packed into a
+ * 64-bit key, and the keys are counted in an open-addressed table, so the walker
+ * and AlignmentFragment::indelCigarMatches don't build a string per indel. Indels
+ * too large to pack (chr id or length past 16/15 bits) are counted exactly in a
+ * small map on the side.
+ */
+class IndelCigarMap {
+
+ public:
+
+  IndelCigarMap() {}
+
+  /** Count one read with this indel. type is 'D' or 'I' */
+  void add(int32_t chr, int32_t pos, uint32_t len, char type) {
+    uint64_t key;
+    if (!pack(chr, pos, len, type, key)) {
+      ++m_overflow[overflowKey(chr, pos, len, type)];
+      return;
+    }
+    if ((m_size + 1) * 2 > m_keys.size())
+      grow();
+    size_t i = slot(key);
+    if (!m_keys[i]) {
+      m_keys[i] = key;
+      ++m_size;
+    }
+    ++m_counts[i];
+  }
+
+  /** Number of reads with this indel, 0 if none */
+  size_t count(int32_t chr, int32_t pos, uint32_t len, char type) const {
+    uint64_t key;
+    if (!pack(chr, pos, len, type, key)) {
+      auto ff = m_overflow.find(overflowKey(chr, pos, len, type));
+      return ff == m_overflow.end() ? 0 : ff->second;
+    }
+    if (m_keys.empty())
+      return 0;
+    size_t i = slot(key);
+    return m_keys[i] ? m_counts[i] : 0;
+  }
+
+  size_t size() const { return m_size + m_overflow.size(); }
+
+  void clear();
+
+ private:
+
+  // chr:16 pos:32 len:15 type:1. Lengths are never 0, so no indel packs to the empty key 0
+  static bool pack(int32_t chr, int32_t pos, uint32_t len, char type, uint64_t& key) {
+    if (chr < 0 || chr > 0xFFFF || pos < 0 || len == 0 || len > 0x7FFF)
+      return false;
+    key = ((uint64_t)chr << 48) | ((uint64_t)(uint32_t)pos << 16) | ((uint64_t)len << 1) | (type == 'I');
+    return true;
+  }
+
+  static std::string overflowKey(int32_t chr, int32_t pos, uint32_t len, char type) {
+    return std::to_string(chr) + "_" + std::to_string(pos) + "_" + std::to_string(len) + type;
+  }
+
+  // slot holding key, or the empty slot where it would go
+  size_t slot(uint64_t key) const {
+    size_t mask = m_keys.size() - 1;
+    size_t i = svabaUtils::mix64(key) & mask;
+    while (m_keys[i] && m_keys[i] != key)
+      i = (i + 1) & mask;
+    return i;
+  }
+
+  // double the table (kept at most half full) and reinsert the keys
+  void grow();
+
+  std::vector<uint64_t> m_keys; // 0 is empty
+  std::vector<uint32_t> m_counts;
+  size_t m_size = 0;
+
+  std::unordered_map<std::string, size_t> m_overflow;
+
+};
+
+#endif
@@ -30,7 +30,7 @@ class KmerFilter {
   
  private: 
 
-  RLBWT* pBWT;
+  BWT* pBWT;
   SuffixArray* pSAf;
 
   int m_kmer_len = 31;
@@ -0,0 +1,175 @@
+#include "LocalRefAligner.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "SeqLib/SeqLibUtils.h"
+
+#include "svaba_params.h"
+
+// BWA-MEM default scores
+#define LA_MATCH 1
+#define LA_MISMATCH 4
+#define LA_GAP_OPEN 6
+#define LA_GAP_EXT 1
+#define LA_CLIP_BONUS 5 // reaching the end of the query, instead of clipping
+
+#define LA_NEG -1000000000
+
+static inline int __base2bit(char c) {
+  switch (c) {
+  case 'A': case 'a': return 0;
+  case 'C': case 'c': return 1;
+  case 'G': case 'g': return 2;
+  case 'T': case 't': return 3;
+  default: return -1;
+  }
+}
+
+// call f(kmer, pos) for each k-mer (no N) of s
+template <typename F>
+static void __each_kmer(const std::string& s, F f) {
+  const uint32_t mask = (1u << (2 * LOCAL_ALIGN_K)) - 1;
+  uint32_t k = 0;
+  int len = 0;
+  for (int i = 0; i < (int)s.length(); ++i) {
+    int b = __base2bit(s[i]);
+    if (b < 0) {
+      len = 0;
+      continue;
+    }
+    k = ((k << 2) | b) & mask;
+    if (++len >= LOCAL_ALIGN_K)
+      f(k, i - LOCAL_ALIGN_K + 1);
+  }
+}
+
+void LocalRefAligner::SetRegion(const std::string& ref) {
+
+  m_ref = ref;
+  m_kmers.clear();
+  __each_kmer(m_ref, [this](uint32_t k, int p) { m_kmers.push_back(std::pair<uint32_t, int32_t>(k, p)); });
+  std::sort(m_kmers.begin(), m_kmers.end());
+
+}
+
+bool LocalRefAligner::Align(const std::string& seq, int& score, int& clip) {
+
+  score = 0;
+  clip = seq.length();
+  if (m_ref.empty() || (int)seq.length() < LOCAL_ALIGN_K)
+    return false;
+
+  int s1, c1, s2, c2;
+  bool fwd = __align_strand(seq, s1, c1);
+  std::string rc = seq;
+  SeqLib::rcomplement(rc);
+  bool rev = __align_strand(rc, s2, c2);
+
+  if (fwd && (!rev || s1 >= s2)) {
+    score = s1; clip = c1;
+  } else if (rev) {
+    score = s2; clip = c2;
+  }
+  return fwd || rev;
+
+}
+
+bool LocalRefAligner::__align_strand(const std::string& q, int& score, int& clip) {
+
+  // vote for the diagonal (ref pos - query pos) of the shared k-mers,
+  // ignoring k-mers repeated a lot in the window
+  std::unordered_map<int, int> votes;
+  __each_kmer(q, [&](uint32_t k, int p) {
+      auto lo = std::lower_bound(m_kmers.begin(), m_kmers.end(), std::pair<uint32_t, int32_t>(k, INT32_MIN));
+      auto hi = lo;
+      while (hi != m_kmers.end() && hi->first == k)
+	++hi;
+      if (hi - lo > LOCAL_ALIGN_MAX_OCC)
+	return;
+      for (; lo != hi; ++lo)
+	++votes[lo->second - p];
+    });
+  if (votes.empty())
+    return false;
+
+  int diag = 0, best_votes = 0;
+  for (auto& v : votes)
+    if (v.second > best_votes || (v.second == best_votes && v.first < diag)) {
+      best_votes = v.second;
+      diag = v.first;
+    }
+
+  // banded local alignment (Gotoh) of q against the ref, around the diagonal.
+  // Band cell k of query row i is ref position i + diag - w + k. Each cell
+  // also carries the query position its alignment started at
+  const int w = LOCAL_ALIGN_BAND;
+  const int nb = 2 * w + 1;
+  const int n = q.length();
+  const int m = m_ref.length();
+  m_h.assign(nb, LA_NEG); m_e.assign(nb, LA_NEG); m_f.assign(nb, LA_NEG);
+  m_hs.assign(nb, 0); m_es.assign(nb, 0); m_fs.assign(nb, 0);
+  m_ph.assign(nb + 1, LA_NEG); m_pf.assign(nb + 1, LA_NEG);
+  m_phs.assign(nb + 1, 0); m_pfs.assign(nb + 1, 0);
+
+  int best = 0, best_start = 0, best_end = -1;
+  for (int i = 0; i < n; ++i) {
+    for (int k = 0; k < nb; ++k) {
+
+      int j = i + diag - w + k;
+      if (j < 0 || j >= m) {
+	m_h[k] = m_e[k] = m_f[k] = LA_NEG;
+	continue;
+      }
+
+      // gap in the query (from the left, same row)
+      int e = LA_NEG, es = 0;
+      if (k > 0 && m_h[k-1] > LA_NEG) {
+	e = m_h[k-1] - LA_GAP_OPEN - LA_GAP_EXT; es = m_hs[k-1];
+	if (m_e[k-1] - LA_GAP_EXT > e) { e = m_e[k-1] - LA_GAP_EXT; es = m_es[k-1]; }
+      }
+
+      // gap in the ref (from above, previous row is one band cell over)
+      int f = LA_NEG, fs = 0;
+      if (i > 0 && m_ph[k+1] > LA_NEG) {
+	f = m_ph[k+1] - LA_GAP_OPEN - LA_GAP_EXT; fs = m_phs[k+1];
+	if (m_pf[k+1] - LA_GAP_EXT > f) { f = m_pf[k+1] - LA_GAP_EXT; fs = m_pfs[k+1]; }
+      }
+
+      // match / mismatch from the diagonal, or start here
+      int sc = (q[i] == m_ref[j] && __base2bit(q[i]) >= 0) ? LA_MATCH : -LA_MISMATCH;
+      int d = i == 0 ? LA_CLIP_BONUS : 0, ds = i; // start a new alignment
+      if (i > 0 && m_ph[k] > d) { d = m_ph[k]; ds = m_phs[k]; }
+      int h = d + sc, hs = ds;
+      if (e > h) { h = e; hs = es; }
+      if (f > h) { h = f; hs = fs; }
+      if (h < 0) { h = 0; hs = i + 1; }
+
+      m_h[k] = h; m_hs[k] = hs;
+      m_e[k] = e; m_es[k] = es;
+      m_f[k] = f; m_fs[k] = fs;
+
+      int end_score = h + (i == n - 1 ? LA_CLIP_BONUS : 0);
+      if (end_score > best) {
+	best = end_score;
+	best_start = hs;
+	best_end = i;
+      }
+    }
+
+    // this row becomes the previous row
+    std::copy(m_h.begin(), m_h.end(), m_ph.begin());
+    std::copy(m_f.begin(), m_f.end(), m_pf.begin());
+    std::copy(m_hs.begin(), m_hs.end(), m_phs.begin());
+    std::copy(m_fs.begin(), m_fs.end(), m_pfs.begin());
+  }
+
+  if (best_end < 0)
+    return false;
+
+  // remove the end bonuses from the score
+  score = best - (best_start == 0 ? LA_CLIP_BONUS : 0) - (best_end == n - 1 ? LA_CLIP_BONUS : 0);
+  clip = best_start + (n - 1 - best_end);
+  return score >= LOCAL_ALIGN_MIN_SCORE;
+
+}
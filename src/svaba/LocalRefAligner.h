@@ -0,0 +1,50 @@
+#ifndef SVABA_LOCAL_REF_ALIGNER_H__
+#define SVABA_LOCAL_REF_ALIGNER_H__
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/** Align contigs to the reference sequence of one window.
+ *
+ * Used to test whether a contig has a local alignment with little clipping
+ * (in which case it can only hold an indel), without building a BWA index of
+ * every window. The window's k-mers are sorted once per window, each contig
+ * is anchored on the diagonal with the most shared k-mers, and a banded
+ * local alignment around it (BWA-MEM scoring and end bonus) gives the clip.
+ * Keep one per thread so the buffers are reused from window to window.
+ */
+class LocalRefAligner {
+
+ public:
+
+  LocalRefAligner() {}
+
+  /** Set the reference sequence of the window */
+  void SetRegion(const std::string& ref);
+
+  bool IsEmpty() const { return m_ref.empty(); }
+
+  /** Best local alignment of seq (either strand) to the window.
+   * @param clip Bases of seq left out of the alignment
+   * @return false if there is no alignment of at least LOCAL_ALIGN_MIN_SCORE
+   */
+  bool Align(const std::string& seq, int& score, int& clip);
+
+ private:
+
+  // best alignment of one strand of the query
+  bool __align_strand(const std::string& q, int& score, int& clip);
+
+  std::string m_ref;
+
+  // (k-mer, position) of the window, sorted
+  std::vector<std::pair<uint32_t, int32_t> > m_kmers;
+
+  // banded DP rows, reused between alignments
+  std::vector<int> m_h, m_e, m_f, m_hs, m_es, m_fs;
+  std::vector<int> m_ph, m_pf, m_phs, m_pfs;
+
+};
+
+#endif
@@ -0,0 +1,171 @@
+#include "MateFetchService.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "svaba_params.h"
+
+//#define DEBUG_MATE_FETCH 1
+
+// one requested region, and where its reads go
+struct MateFetchEntry {
+  SeqLib::GenomicRegion gr;
+  MateFetchResult * res;
+  size_t idx; // index of region in the request
+
+  bool operator<(const MateFetchEntry& e) const { return gr < e.gr; }
+};
+
+MateFetchService::MateFetchService() {
+  pthread_mutex_init(&m_lock, NULL);
+  pthread_cond_init(&m_cond, NULL);
+}
+
+MateFetchService::~MateFetchService() {
+  pthread_cond_destroy(&m_cond);
+  pthread_mutex_destroy(&m_lock);
+}
+
+bool MateFetchService::Open(const std::map<std::string, std::string>& bams) {
+
+  bool success = true;
+  for (auto& b : bams)
+    success = m_src[b.first].reader.Open(b.second) && success;
+  return success;
+
+}
+
+void MateFetchService::Fetch(const std::string& id, const SeqLib::GRC& grc, MateFetchResult& res) {
+
+  res.regions = grc;
+  res.reads.clear();
+  res.reads.resize(grc.size());
+  res.seeks = 0;
+  res.batch = 0;
+  res.truncated.clear();
+  res.record_bytes = 0;
+
+  if (!grc.size())
+    return;
+
+  pthread_mutex_lock(&m_lock);
+
+  std::map<std::string, Source>::iterator ff = m_src.find(id);
+  if (ff == m_src.end()) {
+    pthread_mutex_unlock(&m_lock);
+    return;
+  }
+  Source& s = ff->second;
+
+  s.pending.push_back(&res);
+
+  // either read the pending batch (which holds this request), or wait for
+  // the thread that is reading to finish. Done when this request was served
+  while (!res.batch) {
+
+    if (s.busy) {
+      pthread_cond_wait(&m_cond, &m_lock);
+      continue;
+    }
+
+    s.busy = true;
+    std::vector<MateFetchResult*> batch(s.pending.begin(), s.pending.end());
+    s.pending.clear();
+    pthread_mutex_unlock(&m_lock);
+
+    size_t seeks = __read_batch(s.reader, batch);
+
+    pthread_mutex_lock(&m_lock);
+    for (auto& b : batch) {
+      b->seeks = seeks;
+      b->batch = batch.size();
+      m_regions += b->regions.size();
+      m_record_bytes += b->record_bytes;
+      m_truncated += b->truncated.size();
+    }
+    m_requests += batch.size();
+    m_seeks += seeks;
+    s.busy = false;
+    pthread_cond_broadcast(&m_cond);
+  }
+
+  pthread_mutex_unlock(&m_lock);
+
+}
+
+size_t MateFetchService::__read_batch(SeqLib::BamReader& reader, std::vector<MateFetchResult*>& batch) const {
+
+  // pool the requested regions and sort them
+  std::vector<MateFetchEntry> entries;
+  SeqLib::GRC merged;
+  for (auto& b : batch)
+    for (size_t i = 0; i < b->regions.size(); ++i) {
+      entries.push_back({b->regions[i], b, i});
+      merged.add(SeqLib::GenomicRegion(b->regions[i].chr, b->regions[i].pos1, b->regions[i].pos2));
+    }
+  std::sort(entries.begin(), entries.end());
+
+  // merge into the set of regions to actually read. Merged regions are
+  // disjoint, so each requested region falls in exactly one of them
+  merged.MergeOverlappingIntervals();
+  merged.CoordinateSort();
+
+  size_t e = 0;
+  for (auto& m : merged) {
+
+    // find the requested regions inside this merged region
+    size_t estart = e;
+    while (e < entries.size() && entries[e].gr.chr == m.chr && entries[e].gr.pos1 <= m.pos2)
+      ++e;
+    if (e == estart)
+      continue;
+
+    if (!reader.SetRegion(m))
+      continue;
+
+    // read it once, and route each read to the requested regions it overlaps
+    SeqLib::BamRecord r;
+    size_t count = 0;
+    while (reader.GetNextRecord(r)) {
+
+      // too deep to read all of it. The requested regions that reach this read
+      // are incomplete, so drop their reads and report them, as the walker
+      // does for regions over its read limit
+      if (++count > MATE_FETCH_MAX_RECORDS) {
+	for (size_t j = estart; j < e; ++j)
+	  if (entries[j].gr.pos2 >= r.Position()) {
+	    entries[j].res->reads[entries[j].idx].clear();
+	    entries[j].res->truncated.add(entries[j].gr);
+	  }
+	break;
+      }
+
+      size_t nbytes = sizeof(bam1_core_t) + r.raw()->l_data;
+      bool routed = false;
+      for (size_t j = estart; j < e; ++j) {
+	const SeqLib::GenomicRegion& g = entries[j].gr;
+	if (r.ChrID() == g.chr && r.Position() <= g.pos2 && r.PositionEnd() >= g.pos1) {
+
+	  // the walkers edit their reads in place (tags, sequence), so each 
+	  // request on a different thread needs its own copy of the record
+	  if (!routed) {
+	    entries[j].res->reads[entries[j].idx].push_back(r);
+	  } else {
+	    SeqLib::BamRecord rc;
+	    rc.assign(bam_dup1(r.raw()));
+	    entries[j].res->reads[entries[j].idx].push_back(rc);
+	  }
+	  routed = true;
+	  entries[j].res->record_bytes += nbytes;
+	}
+      }
+    }
+
+#ifdef DEBUG_MATE_FETCH
+    std::cerr << "MATE FETCH: read " << m << " with " << count << " records for " << (e - estart) << " requested regions" << std::endl;
+#endif
+  }
+
+  return merged.size();
+
+}
@@ -0,0 +1,85 @@
+#ifndef SVABA_MATE_FETCH_SERVICE_H__
+#define SVABA_MATE_FETCH_SERVICE_H__
+
+#include <map>
+#include <list>
+#include <string>
+#include <vector>
+#include <pthread.h>
+
+#include "SeqLib/BamReader.h"
+#include "SeqLib/GenomicRegionCollection.h"
+
+/** Reads fetched for one mate-lookup request */
+struct MateFetchResult {
+
+  SeqLib::GRC regions; // regions as requested
+  std::vector<SeqLib::BamRecordVector> reads; // reads overlapping each region, in request order
+
+  SeqLib::GRC truncated; // regions not read to the end, as MATE_FETCH_MAX_RECORDS was hit. Their reads are dropped
+
+  size_t seeks = 0; // seeks done for the batch this request was served in
+  size_t batch = 0; // number of requests in that batch
+  size_t record_bytes = 0; // in-memory size of the alignment records routed to this request (not bytes read from disk)
+
+};
+
+/** Shared service to read mate-lookup regions for all of the worker threads.
+ *
+ * Each window submits the regions it wants from a BAM and blocks until they are read.
+ * All of the requests that are waiting when a read starts are served as one batch: their
+ * regions are merged, each merged region is read once in coordinate (and so file offset)
+ * order, and each record is routed back to every requested region it overlaps. The thread
+ * that finds no read in progress does the reading for the whole batch, so there is no
+ * separate service thread, and batches grow naturally when the disk is the bottleneck.
+ */
+class MateFetchService {
+
+ public:
+
+  MateFetchService();
+
+  ~MateFetchService();
+
+  /** Open a reader for each BAM. Keys are the same as for the walkers (e.g. t000) */
+  bool Open(const std::map<std::string, std::string>& bams);
+
+  /** Read the regions in grc from one BAM. Blocks until the batch holding this request is read.
+   * @param id Key of the BAM to read
+   * @param grc Regions to read
+   * @param res Filled with the regions, the reads for each region, any regions cut short and the I/O for this request
+   */
+  void Fetch(const std::string& id, const SeqLib::GRC& grc, MateFetchResult& res);
+
+  // totals over the run
+  size_t NumRequests() const { return m_requests; }
+  size_t NumRegions() const { return m_regions; }
+  size_t NumSeeks() const { return m_seeks; }
+  size_t NumRecordBytes() const { return m_record_bytes; }
+  size_t NumTruncated() const { return m_truncated; }
+
+ private:
+
+  struct Source {
+    SeqLib::BamReader reader;
+    std::list<MateFetchResult*> pending;
+    bool busy = false;
+  };
+
+  // read one batch of requests. Called without the lock held, by the one thread marked busy for this source
+  size_t __read_batch(SeqLib::BamReader& reader, std::vector<MateFetchResult*>& batch) const;
+
+  std::map<std::string, Source> m_src;
+
+  size_t m_requests = 0;
+  size_t m_regions = 0;
+  size_t m_seeks = 0;
+  size_t m_record_bytes = 0;
+  size_t m_truncated = 0;
+
+  pthread_mutex_t m_lock;
+  pthread_cond_t m_cond;
+
+};
+
+#endif
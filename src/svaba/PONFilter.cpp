@@ -2,38 +2,56 @@
 
 #include <regex>
 #include <sstream>
+#include <fstream>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "gzstream.h"
 #include "SeqLib/SeqLibUtils.h"
 
+#include "svaba_params.h"
+#include "svabaUtils.h"
+
 using namespace SeqLib;
+using svabaUtils::mix64;
 
-  std::ostream& operator<<(std::ostream& out, const PONFilter& p) {
-    size_t max_samples = 0;
-    for (auto& i : p.m_map)
-      if (i.second > max_samples)
-	max_samples = i.second;
-    out << "Indel PON Num sites: " << AddCommas(p.m_map.size()) << " Max Samples Found " << AddCommas(max_samples);
-    return out;
-  }
+// first bytes of the index. Last character is the format version
+static const char PON_INDEX_MAGIC[] = "SVPONIX1";
+#define PON_INDEX_MAGIC_LEN 8
 
-  PONFilter::PONFilter(const std::string& file) {
+// hash of a key, as stored in the index
+static inline uint64_t __key_hash(const std::string& s) {
+  return mix64(svabaUtils::fnv1a(s));
+}
 
-    // import the pon
-    igzstream izp(file.c_str());
-    if (!izp) {
-      std::cerr << "Can't read file " << file << std::endl;
-      exit(EXIT_FAILURE);
-    }
+static inline uint64_t __h1(uint64_t h) { return mix64(h ^ 0x9e3779b97f4a7c15ULL); }
+static inline uint64_t __h2(uint64_t h) { return mix64(h + 0x632be59bd9b4e019ULL) | 1; }
+
+// fingerprint of a key. Never 0, which marks an empty slot
+static inline uint32_t __fp(uint64_t h) {
+  uint32_t f = (uint32_t)(mix64(h ^ 0xd6e8feb86659fd93ULL) >> 32);
+  return f ? f : 1;
+}
 
-    std::string pval;
-    while (std::getline(izp, pval, '\n')) {
+static inline uint64_t __slot(uint64_t h, uint32_t d, uint64_t m) {
+  return (__h1(h) + (uint64_t)d * __h2(h)) % m;
+}
+
+static size_t __pad8(size_t n) { return (n + 7) & ~(size_t)7; }
+
+// parse one line of the PON text file into a variant key and number of normal samples with it
+static bool __parse_pon_line(const std::string& pval, std::string& key, int& sample_count_total) {
 
       std::istringstream gg(pval);
       std::string tval;
-      std::string key;
-
-      int sample_count_total = 0;
+      key.clear();
+      sample_count_total = 0;
 
       size_t c = 0;
       while (std::getline(gg, tval, '\t')) {
@@ -44,30 +62,298 @@ using namespace SeqLib;
 	    break;
 	}
 	else if (tval.length())
-	  try { 
-	    sample_count_total += (stoi(tval) > 0 ? 1 : 0); 
-	  } catch(...) { 
-	    std::cerr << "stoi error in PON read with val " << tval << " on line " << pval << std::endl; 
+	  try {
+	    sample_count_total += (stoi(tval) > 0 ? 1 : 0);
+	  } catch(...) {
+	    std::cerr << "stoi error in PON read with val " << tval << " on line " << pval << std::endl;
 	  }
 	//else if (tval.length() && c==2)
 	//	try { read_count_total += stoi(tval); } catch(...) { std::cerr << "stoi error in PON read with val " << tval << " on line " << pval << std::endl; }
-	
+
       }
-      
+
       // trim it down
-      std::regex regc("(.*?_.*?)_.*");
+      static const std::regex regc("(.*?_.*?)_.*");
       std::smatch smatchr;
       if (!std::regex_search(key, smatchr, regc)) {
-	std::cerr << "regex failed on " << key << std::endl; 
+	std::cerr << "regex failed on " << key << std::endl;
       } else {
 	key = smatchr[1].str();
       }
 
-      if (sample_count_total > 1) {
-	m_map[key] = sample_count_total;
+      return sample_count_total > 1;
+}
+
+  std::ostream& operator<<(std::ostream& out, const PONFilter& p) {
+    if (p.m_index.size()) {
+      out << "Indel PON index Num sites: " << AddCommas(p.m_index.size());
+      return out;
+    }
+    size_t max_samples = 0;
+    for (auto& i : p.m_map)
+      if (i.second > max_samples)
+	max_samples = i.second;
+    out << "Indel PON Num sites: " << AddCommas(p.m_map.size()) << " Max Samples Found " << AddCommas(max_samples);
+    return out;
+  }
+
+  PONFilter::PONFilter(const std::string& file) {
+
+    // prebuilt index
+    if (PONIndex::IsIndex(file)) {
+      if (!m_index.Open(file)) {
+	std::cerr << "Can't read PON index " << file << std::endl;
+	exit(EXIT_FAILURE);
       }
+      return;
+    }
 
+    // import the pon
+    igzstream izp(file.c_str());
+    if (!izp) {
+      std::cerr << "Can't read file " << file << std::endl;
+      exit(EXIT_FAILURE);
     }
 
-    
+    std::string pval, key;
+    int sample_count_total;
+    while (std::getline(izp, pval, '\n'))
+      if (__parse_pon_line(pval, key, sample_count_total))
+	m_map[key] = sample_count_total;
+
   }
+
+PONIndex::~PONIndex() {
+  if (m_map)
+    munmap(m_map, m_map_size);
+}
+
+bool PONIndex::IsIndex(const std::string& file) {
+  std::ifstream in(file.c_str(), std::ios::binary);
+  char magic[PON_INDEX_MAGIC_LEN];
+  return in && in.read(magic, PON_INDEX_MAGIC_LEN) && !memcmp(magic, PON_INDEX_MAGIC, PON_INDEX_MAGIC_LEN);
+}
+
+bool PONIndex::Open(const std::string& file) {
+
+  int fd = open(file.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  size_t hdr = PON_INDEX_MAGIC_LEN + 3 * sizeof(uint64_t);
+  if (fstat(fd, &st) < 0 || (size_t)st.st_size < hdr) {
+    close(fd);
+    return false;
+  }
+  m_map_size = st.st_size;
+  m_map = mmap(NULL, m_map_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (m_map == MAP_FAILED) {
+    m_map = nullptr;
+    return false;
+  }
+
+  const char * base = (const char*)m_map;
+  const uint64_t * sizes = (const uint64_t*)(base + PON_INDEX_MAGIC_LEN);
+  m_n = sizes[0];
+  m_m = sizes[1];
+  m_nb = sizes[2];
+
+  size_t p = hdr;
+  m_disp = (const uint32_t*)(base + p);
+  p += __pad8(m_nb * sizeof(uint32_t));
+  m_fp = (const uint32_t*)(base + p);
+  p += __pad8(m_m * sizeof(uint32_t));
+  m_count = (const uint16_t*)(base + p);
+  p += m_m * sizeof(uint16_t);
+
+  if (p > m_map_size || !m_m || !m_nb) {
+    m_n = 0;
+    return false;
+  }
+  return true;
+
+}
+
+int PONIndex::NSamps(const std::string& s) const {
+
+  if (!m_n)
+    return 0;
+  uint64_t h = __key_hash(s);
+  uint64_t pos = __slot(h, m_disp[h % m_nb], m_m);
+  return m_fp[pos] == __fp(h) ? m_count[pos] : 0;
+
+}
+
+long PONIndex::Build(const std::string& pon, const std::string& index) {
+
+  igzstream izp(pon.c_str());
+  if (!izp)
+    return -1;
+
+  // hash the keys. Keep the last count for a repeated key, as the text loader does
+  struct Key { uint64_t h; uint32_t line; uint16_t count; };
+  std::vector<Key> keys;
+  std::string pval, key;
+  int sample_count_total;
+  uint32_t line = 0;
+  while (std::getline(izp, pval, '\n')) {
+    if (__parse_pon_line(pval, key, sample_count_total))
+      keys.push_back({__key_hash(key), line, (uint16_t)std::min(sample_count_total, 65535)});
+    ++line;
+  }
+  std::sort(keys.begin(), keys.end(), [](const Key& a, const Key& b) {
+      return a.h < b.h || (a.h == b.h && a.line < b.line);
+    });
+  size_t k = 0;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (i + 1 < keys.size() && keys[i + 1].h == keys[i].h)
+      continue;
+    keys[k++] = keys[i];
+  }
+  keys.resize(k);
+
+  uint64_t n = keys.size();
+  uint64_t m = std::max((uint64_t)1, (uint64_t)(n / PON_INDEX_LOAD) + 1);
+  uint64_t nb = std::max((uint64_t)1, n / PON_INDEX_BUCKET_SIZE);
+
+  // group the keys by bucket
+  std::vector<uint64_t> bstart(nb + 1, 0);
+  for (auto& kk : keys)
+    ++bstart[kk.h % nb + 1];
+  for (size_t b = 0; b < nb; ++b)
+    bstart[b + 1] += bstart[b];
+  std::vector<uint64_t> bkeys(n);
+  {
+    std::vector<uint64_t> fill(bstart.begin(), bstart.end() - 1);
+    for (size_t i = 0; i < n; ++i)
+      bkeys[fill[keys[i].h % nb]++] = i;
+  }
+
+  // place the biggest buckets first, while the table is emptiest
+  std::vector<uint32_t> border(nb);
+  for (size_t b = 0; b < nb; ++b)
+    border[b] = b;
+  std::sort(border.begin(), border.end(), [&](uint32_t a, uint32_t b) {
+      return bstart[a + 1] - bstart[a] > bstart[b + 1] - bstart[b];
+    });
+
+  std::vector<uint32_t> disp(nb, 0), fp(m, 0);
+  std::vector<uint16_t> count(m, 0);
+  std::vector<uint64_t> pos;
+  for (auto& b : border) {
+    size_t bs = bstart[b], be = bstart[b + 1];
+    if (bs == be)
+      break;
+
+    // find a displacement that puts every key of the bucket in a free slot
+    for (uint32_t d = 0; ; ++d) {
+      if (d == UINT32_MAX) {
+	std::cerr << "PONIndex: could not place bucket of " << (be - bs) << " keys" << std::endl;
+	return -1;
+      }
+      pos.clear();
+      bool ok = true;
+      for (size_t i = bs; i < be && ok; ++i) {
+	uint64_t p = __slot(keys[bkeys[i]].h, d, m);
+	ok = !fp[p] && std::find(pos.begin(), pos.end(), p) == pos.end();
+	pos.push_back(p);
+      }
+      if (!ok)
+	continue;
+      disp[b] = d;
+      for (size_t i = bs; i < be; ++i) {
+	fp[pos[i - bs]] = __fp(keys[bkeys[i]].h);
+	count[pos[i - bs]] = keys[bkeys[i]].count;
+      }
+      break;
+    }
+  }
+
+  std::ofstream out(index.c_str(), std::ios::binary);
+  if (!out)
+    return -1;
+  const char pad[8] = {0};
+  out.write(PON_INDEX_MAGIC, PON_INDEX_MAGIC_LEN);
+  out.write((const char*)&n, sizeof(uint64_t));
+  out.write((const char*)&m, sizeof(uint64_t));
+  out.write((const char*)&nb, sizeof(uint64_t));
+  out.write((const char*)disp.data(), nb * sizeof(uint32_t));
+  out.write(pad, __pad8(nb * sizeof(uint32_t)) - nb * sizeof(uint32_t));
+  out.write((const char*)fp.data(), m * sizeof(uint32_t));
+  out.write(pad, __pad8(m * sizeof(uint32_t)) - m * sizeof(uint32_t));
+  out.write((const char*)count.data(), m * sizeof(uint16_t));
+
+  return out ? (long)n : -1;
+
+}
+
+void runIndexPON(int argc, char** argv) {
+
+  bool bench = argc > 1 && std::string(argv[1]) == "--bench";
+  if (bench) {
+    --argc;
+    ++argv;
+  }
+
+  if (argc < 2 || argc > 3) {
+    std::cerr << "Usage: svaba index-pon [--bench] pon.txt.gz [index]\n\n"
+	      << "  Description: Build a memory-mapped panel of normals index (pon.txt.gz.ponx by default).\n"
+	      << "               --bench times NSamps lookups in the index against the in-memory map\n";
+    exit(EXIT_FAILURE);
+  }
+
+  std::string pon = argv[1];
+  std::string index = argc == 3 ? std::string(argv[2]) : pon + ".ponx";
+
+  typedef std::chrono::steady_clock clk;
+  clk::time_point t0 = clk::now();
+  long count = PONIndex::Build(pon, index);
+  if (count < 0) {
+    std::cerr << "ERROR: Could not read " << pon << " or write " << index << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  std::cerr << "...wrote " << AddCommas(count) << " PON keys to " << index << " in "
+	    << std::chrono::duration<double>(clk::now() - t0).count() << " seconds" << std::endl;
+
+  if (!bench)
+    return;
+
+  // load both ways
+  t0 = clk::now();
+  PONFilter map_pon(pon);
+  double map_load = std::chrono::duration<double>(clk::now() - t0).count();
+  t0 = clk::now();
+  PONFilter index_pon(index);
+  double index_load = std::chrono::duration<double>(clk::now() - t0).count();
+
+  // look up keys in the panel, and the same keys altered so they are not
+  std::vector<std::string> queries;
+  igzstream izp(pon.c_str());
+  std::string pval, key;
+  int sample_count_total;
+  while (queries.size() < PON_BENCH_KEYS && std::getline(izp, pval, '\n'))
+    if (__parse_pon_line(pval, key, sample_count_total)) {
+      queries.push_back(key);
+      queries.push_back(key + "_absent");
+    }
+
+  size_t agree = 0;
+  long sum_map = 0, sum_index = 0;
+  t0 = clk::now();
+  for (auto& q : queries)
+    sum_map += map_pon.NSamps(q);
+  double map_time = std::chrono::duration<double>(clk::now() - t0).count();
+  t0 = clk::now();
+  for (auto& q : queries)
+    sum_index += index_pon.NSamps(q);
+  double index_time = std::chrono::duration<double>(clk::now() - t0).count();
+  for (auto& q : queries)
+    agree += map_pon.NSamps(q) == index_pon.NSamps(q);
+
+  double nq = std::max((size_t)1, queries.size());
+  std::cerr << "...load:   map " << map_load << " s, index " << index_load << " s" << std::endl
+	    << "...lookup: map " << (map_time * 1e9 / nq) << " ns/key, index " << (index_time * 1e9 / nq) << " ns/key over "
+	    << AddCommas(queries.size()) << " keys (" << AddCommas(agree) << " agree, sums " << sum_map << " / " << sum_index << ")" << std::endl;
+
+}
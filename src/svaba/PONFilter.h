@@ -3,31 +3,88 @@
 
 #include <string>
 #include <cstdlib>
+#include <stdint.h>
 #include <unordered_map>
 
+/** Read-only perfect hash index of a panel of normals.
+ *
+ * Keys are hashed to 64 bits, then placed in slots with a hash-and-displace
+ * perfect hash (one 32-bit displacement per bucket of ~4 keys, slots at 99%
+ * load). Each slot holds a 32-bit fingerprint, to reject keys not in the panel,
+ * and a 16-bit sample count. The file is memory-mapped, so processes on a
+ * machine share one copy.
+ */
+class PONIndex {
+
+ public:
+
+  PONIndex() {}
+
+  ~PONIndex();
+
+  PONIndex(const PONIndex&) = delete;
+  PONIndex& operator=(const PONIndex&) = delete;
+
+  bool Open(const std::string& file);
+
+  /** Number of normal samples with the variant key, 0 if none */
+  int NSamps(const std::string& s) const;
+
+  size_t size() const { return m_n; }
+
+  /** Build an index from a PON text file.
+   * @return number of keys written, or -1 if the files could not be opened
+   */
+  static long Build(const std::string& pon, const std::string& index);
+
+  static bool IsIndex(const std::string& file);
+
+ private:
+
+  uint64_t m_n = 0;   // keys
+  uint64_t m_m = 0;   // slots
+  uint64_t m_nb = 0;  // buckets
+
+  const uint32_t * m_disp = nullptr;
+  const uint32_t * m_fp = nullptr;
+  const uint16_t * m_count = nullptr;
+
+  void * m_map = nullptr;
+  size_t m_map_size = 0;
+
+};
+
 class PONFilter {
-  
- public: 
-  
+
+ public:
+
   PONFilter() {}
-  
+
+  /** Read a PON text file, or open a PON index made with "svaba index-pon" */
   PONFilter(const std::string& file);
-  
+
   friend std::ostream& operator<<(std::ostream& out, const PONFilter& p);
-  
-  bool count(const std::string& s) const { return m_map.count(s); }
-  
-  int NSamps(const std::string& s) const { 
+
+  bool count(const std::string& s) const { return NSamps(s) > 0; }
+
+  int NSamps(const std::string& s) const {
+    if (m_index.size())
+      return m_index.NSamps(s);
     std::unordered_map<std::string, size_t>::const_iterator it = m_map.find(s);
     if (it == m_map.end())
       return 0;
-    return it->second; 
+    return it->second;
   }
 
  private:
-  
+
   std::unordered_map<std::string, size_t> m_map;
-  
+
+  PONIndex m_index;
+
 };
 
+/** svaba index-pon */
+void runIndexPON(int argc, char** argv);
+
 #endif
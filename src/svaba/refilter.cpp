@@ -2,6 +2,10 @@
 #include "DBSnpFilter.h"
 
 #include <getopt.h>
+#include <pthread.h>
+#include <algorithm>
+#include <chrono>
+#include <list>
 #include <sstream>
 #include <iostream>
 
@@ -11,10 +15,32 @@
 #include "vcf.h"
 #include "BreakPoint.h"
 #include "svabaUtils.h"
+#include "BreakPointStore.h"
+#include "svaba_params.h"
 
 
 static DBSnpFilter * dbsnp_filter;
-static ogzstream os_allbps_r;
+
+// a batch of breakpoints. Batches are rescored in parallel and written out in the order they were read
+struct RefilterBatch {
+  size_t id = 0;
+  std::vector<std::string> lines; // bps.txt.gz input
+  BreakPointBlock block;          // bps.bin input
+  std::vector<BreakPoint> bps;    // rescored breakpoints
+};
+
+// state shared between the reading / writing thread and the workers
+static struct {
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  std::list<RefilterBatch*> todo;
+  std::map<size_t, RefilterBatch*> done;
+  bool reading_done = false;
+
+  bool is_store = false;
+  std::vector<std::string> sample_ids; // in column order
+  SeqLib::BamHeader hdr;
+} refilter;
 
 namespace opt {
 
@@ -35,6 +61,7 @@ namespace opt {
   static std::string dbsnp; // = "/xchip/gistic/Jeremiah/svabaFilters/dbsnp_138.b37_indel.vcf";
 
   static int verbose = 1;
+  static int num_threads = 1;
 
   // indel probability cutoffs
   static double lod = 8; // LOD that variant is not ref
@@ -54,7 +81,7 @@ enum {
 };
 
 
-static const char* shortopts = "hi:a:v:g:D:b:";
+static const char* shortopts = "hi:a:v:g:D:b:p:";
 static const struct option longopts[] = {
   { "help",                    no_argument, NULL, 'h' },
   { "input-bps",               required_argument, NULL, 'i'},
@@ -64,6 +91,7 @@ static const struct option longopts[] = {
   { "reference-genome",        required_argument, NULL, 'g'},
   { "analysis-id",             required_argument, NULL, 'a'},
   { "verbose",                 required_argument, NULL, 'v' },
+  { "threads",                 required_argument, NULL, 'p' },
   { "lod",                     required_argument, NULL, OPT_LOD },
   { "lod-dbsnp",               required_argument, NULL, OPT_LOD_DB },
   { "lod-somatic",             required_argument, NULL, OPT_LOD_SOMATIC },
@@ -76,20 +104,21 @@ static const struct option longopts[] = {
 
 
 static const char *BP_USAGE_MESSAGE =
-"Usage: svaba refilter [OPTION] -i bps.txt.gz -o bps.new.txt.gz\n\n"
+"Usage: svaba refilter [OPTION] -i bps.bin -b tumor.bam\n\n"
 "  Description: \n"
 "\n"
 "  General options\n"
 "  -v, --verbose                        Select verbosity level (0-4). Default: 1 \n"
 "  -h, --help                           Display this help and exit\n"
+"  -p, --threads                        Use NUM threads to rescore the breakpoints. Output order is unchanged. [1]\n"
 "  -g, --reference-genome               Path to indexed reference genome to be used by BWA-MEM. Default is Broad hg19 (/seq/reference/...)\n"
 "  -b, --opt-bam                        Input BAM file to get header from\n"
 "  -a, --id-string                      String specifying the analysis ID to be used as part of ID common.\n"
 "  Required input\n"
-"  -i, --input-bps                      Original bps.txt.gz file\n"
+"  -i, --input-bps                      Original bps.bin (or bps.txt.gz) file\n"
 "  -b, --bam                            BAM file used to grab header from\n"
 "  Optional external database\n"
-"  -D, --dbsnp-vcf                      DBsnp database (VCF) to compare indels against\n"
+"  -D, --dbsnp-vcf                      DBsnp database (VCF, or index from svaba index-dbsnp) to compare indels against\n"
 "  Variant filtering and classification\n"
 "      --lod                            LOD cutoff to classify indel as non-REF (tests AF=0 vs AF=MaxLikelihood(AF)) [8]\n"
 "      --lod-dbsnp                      LOD cutoff to classify indel as non-REF (tests AF=0 vs AF=MaxLikelihood(AF)) at DBSnp indel site [5]\n"
@@ -115,6 +144,7 @@ void parseBreakOptions(int argc, char** argv) {
     case 'g': arg >> opt::ref_index; break;
     case 'i': arg >> opt::input_file; break;
     case 'v': arg >> opt::verbose; break;
+    case 'p': arg >> opt::num_threads; break;
     case 'a': arg >> opt::analysis_id; break;
     case 'D': arg >> opt::dbsnp; break;
     case OPT_LOD: arg >> opt::lod; break;
@@ -141,11 +171,87 @@ void parseBreakOptions(int argc, char** argv) {
   }
 }
 
+// rescore a breakpoint with the new cutoffs
+static void __rescore(BreakPoint& bp) {
+
+  // fill in discordant info
+  for (auto& i : bp.allele) {
+    if (i.first.at(0) == 't')
+      bp.dc.tcount += i.second.disc;
+    else
+      bp.dc.ncount += i.second.disc;
+  }
+
+  // match against DBsnp database. Modify bp in place
+  if (dbsnp_filter && opt::dbsnp.length()) 
+    dbsnp_filter->queryBreakpoint(bp);
+
+  // score them
+  bp.scoreBreakpoint(opt::lod, opt::lod_db, opt::lod_somatic, opt::lod_somatic_db, opt::scale_error, 0);
+  bp.prep_output(!opt::read_tracking);
+
+}
+
+// parse and rescore one batch
+static void __process_batch(RefilterBatch& b) {
+
+  if (refilter.is_store) {
+    b.bps.resize(b.block.size());
+    for (size_t i = 0; i < b.block.size(); ++i)
+      b.block.get(i, b.bps[i], refilter.sample_ids, refilter.hdr);
+    b.block = BreakPointBlock();
+  } else {
+    b.bps.reserve(b.lines.size());
+    for (auto& line : b.lines) {
+      b.bps.push_back(BreakPoint(line, refilter.hdr));
+      BreakPoint& bp = b.bps.back();
+
+      // fill in with the correct names from the header of bps.txt
+      PerSample<SampleInfo> tmp_alleles;
+      std::string id;
+      for (auto& i : refilter.sample_ids) {
+	id += "A";
+	tmp_alleles[i] = bp.allele[id];
+      }
+      bp.allele = tmp_alleles;
+    }
+    b.lines.clear();
+  }
+
+  for (auto& bp : b.bps)
+    __rescore(bp);
+
+}
+
+static void* __refilter_worker(void*) {
+
+  for (;;) {
+    pthread_mutex_lock(&refilter.lock);
+    while (refilter.todo.empty() && !refilter.reading_done)
+      pthread_cond_wait(&refilter.cond, &refilter.lock);
+    if (refilter.todo.empty()) {
+      pthread_mutex_unlock(&refilter.lock);
+      return NULL;
+    }
+    RefilterBatch * b = refilter.todo.front();
+    refilter.todo.pop_front();
+    pthread_mutex_unlock(&refilter.lock);
+
+    __process_batch(*b);
+
+    pthread_mutex_lock(&refilter.lock);
+    refilter.done[b->id] = b;
+    pthread_cond_broadcast(&refilter.cond);
+    pthread_mutex_unlock(&refilter.lock);
+  }
+
+}
+
 void runRefilterBreakpoints(int argc, char** argv) {
   
   parseBreakOptions(argc, argv);
   
-  opt::output_file = opt::analysis_id + ".filtered.bps.txt.gz";
+  opt::output_file = opt::analysis_id + ".bps.bin";
   if (opt::verbose > 0) {
 
     std::cerr << "Input bps file:  " << opt::input_file << std::endl;
@@ -181,66 +287,138 @@ void runRefilterBreakpoints(int argc, char** argv) {
   header.source = "";//opt::args;
   header.reference = "";//opt::refgenome;
 
-  // open bps file
-  std::string new_bps_file = opt::analysis_id + ".bps.txt.gz";
-  svabaUtils::fopen(new_bps_file, os_allbps_r);
-
-  // read in the BPS
-  std::vector<std::string> allele_names; // store with real name
-  std::map<std::string, SampleInfo> tmp_alleles;
-  std::string line, line2, val;
-  igzstream infile(opt::input_file.c_str(), std::ios::in);
-  size_t line_count = 0;
-  SeqLib::BamHeader hdr = bwalker.Header();
-  while (getline(infile, line, '\n')) {
-    if (line_count % 100000 == 0) 
-      std::cerr << "...read input bps / write output bps file at line " << SeqLib::AddCommas(line_count) << std::endl;
-      
-    if (line_count == 0) { // read the header
-      os_allbps_r << line << std::endl;
+  std::string new_bps_file = opt::output_file;
+  BreakPointWriter writer;
+  BreakPointReader reader;
+  igzstream infile;
+  size_t num_samples = 0;
+
+  refilter.hdr = bwalker.Header();
+  refilter.is_store = IsBreakPointStore(opt::input_file);
+  if (refilter.is_store) {
+
+    // binary breakpoints, with the alleles already keyed by sample
+    if (!reader.Open(opt::input_file) || !writer.Open(new_bps_file, reader.SampleIDs(), reader.SampleLabels())) {
+      std::cerr << "ERROR: Cannot read " << opt::input_file << " or write " << new_bps_file << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    refilter.sample_ids = reader.SampleIDs();
+
+  } else {
+
+    // read the header of the BPS text. Sample columns come after the 
+    // breakpoint columns, named e.g. t000_file.bam
+    std::vector<std::string> allele_names; // store with real name
+    std::string line, val;
+    infile.open(opt::input_file.c_str(), std::ios::in);
+    size_t num_cols = std::count(BreakPoint::header().begin(), BreakPoint::header().end(), '\t') + 1;
+    if (getline(infile, line, '\n')) {
       std::istringstream f(line);
       size_t scount = 0;
       while (std::getline(f, val, '\t')) {
-	++scount;
-	if (scount > 34) { // 35th column should be first sample ID
+	if (++scount > num_cols) { 
 	  assert(val.at(0) == 't' || val.at(0) == 'n');
-	    allele_names.push_back(val);
+	  allele_names.push_back(val);
+	  refilter.sample_ids.push_back(val.substr(0, val.find("_")));
 	}
       }
+    }
+    if (!writer.Open(new_bps_file, refilter.sample_ids, allele_names)) {
+      std::cerr << "ERROR: Cannot write " << new_bps_file << std::endl;
+      exit(EXIT_FAILURE);
+    }
 
+  }
+  num_samples = refilter.sample_ids.size();
+
+  // start the workers
+  int num_threads = std::max(1, opt::num_threads);
+  pthread_mutex_init(&refilter.lock, NULL);
+  pthread_cond_init(&refilter.cond, NULL);
+  std::vector<pthread_t> workers(num_threads);
+  for (auto& w : workers)
+    pthread_create(&w, NULL, __refilter_worker, NULL);
+
+  // read the batches on this thread, and write the rescored batches back out 
+  // in order as they finish. Bound the number of batches held in memory
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  size_t max_in_flight = 4 * num_threads;
+  size_t in_flight = 0, num_read = 0, next_write = 0, bp_count = 0, last_report = 0;
+  for (;;) {
+
+    RefilterBatch * batch = new RefilterBatch;
+    batch->id = num_read;
+    bool more = false;
+    if (refilter.is_store) {
+      more = reader.NextBlock(batch->block);
     } else {
-	BreakPoint * bp = new BreakPoint(line, hdr);
+      std::string line;
+      while (batch->lines.size() < REFILTER_BATCH_SIZE && getline(infile, line, '\n'))
+	batch->lines.push_back(line);
+      more = batch->lines.size();
+    }
+    if (!more) {
+      delete batch;
+      batch = nullptr;
+    }
 
-	// fill in with the correct names from the header of bps.txt
-	std::string id ;
-	for (auto& i : allele_names) {
-	  id += "A";
-	  tmp_alleles[i] = bp->allele[id];
-	}
-	bp->allele = tmp_alleles;
+    pthread_mutex_lock(&refilter.lock);
+    if (batch) {
+      refilter.todo.push_back(batch);
+      ++num_read;
+      ++in_flight;
+    } else {
+      refilter.reading_done = true;
+    }
+    pthread_cond_broadcast(&refilter.cond);
+
+    // write what is ready. Wait if too many batches are out, or at the end until all are written
+    for (;;) {
+      std::map<size_t, RefilterBatch*>::iterator ff;
+      while ((ff = refilter.done.find(next_write)) != refilter.done.end()) {
+	RefilterBatch * b = ff->second;
+	refilter.done.erase(ff);
+	pthread_mutex_unlock(&refilter.lock);
+	for (auto& bp : b->bps)
+	  writer.Write(bp, !opt::read_tracking);
+	bp_count += b->bps.size();
+	delete b;
+	pthread_mutex_lock(&refilter.lock);
+	--in_flight;
+	++next_write;
+      }
+      if ((batch && in_flight < max_in_flight) || (!batch && !in_flight))
+	break;
+      pthread_cond_wait(&refilter.cond, &refilter.lock);
+    }
+    pthread_mutex_unlock(&refilter.lock);
 
-	// fill in discordant info
-	for (auto& i : bp->allele) {
-	  if (i.first.at(0) == 't')
-	    bp->dc.tcount += i.second.disc;
-	  else
-	    bp->dc.ncount += i.second.disc;
+    if (opt::verbose > 0 && bp_count - last_report >= 1000000) {
+      std::cerr << "...rescored and wrote " << SeqLib::AddCommas(bp_count) << " breakpoints" << std::endl;
+      last_report = bp_count;
+    }
 
-	}
+    if (!batch)
+      break;
+  }
 
-	// match against DBsnp database. Modify bp in place
-	if (dbsnp_filter && opt::dbsnp.length()) 
-	  dbsnp_filter->queryBreakpoint(*bp);
+  for (auto& w : workers)
+    pthread_join(w, NULL);
+  pthread_cond_destroy(&refilter.cond);
+  pthread_mutex_destroy(&refilter.lock);
 
-	// score them
-	bp->scoreBreakpoint(opt::lod, opt::lod_db, opt::lod_somatic, opt::lod_somatic_db, opt::scale_error, 0);
-	os_allbps_r << bp->toFileString(!opt::read_tracking) << std::endl;
-	delete bp;
-      }
-    ++line_count;
-  }
+  double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  if (opt::verbose > 0)
+    std::cerr << "...rescored " << SeqLib::AddCommas(bp_count) << " breakpoints in " << secs << " seconds on " 
+	      << num_threads << " threads (" << SeqLib::AddCommas((size_t)(bp_count / std::max(secs, 1e-3))) 
+	      << " per second)" << std::endl;
 
-  os_allbps_r.close();
+  writer.Close();
+
+  // text version, for compatibility
+  std::string new_bps_text = opt::analysis_id + ".bps.txt.gz";
+  if (ExportBreakPoints(new_bps_file, new_bps_text, refilter.hdr) < 0)
+    std::cerr << "ERROR: Could not export breakpoints to " << new_bps_text << std::endl;
   
   // primary VCFs
   std::cerr << " input file " << opt::input_file << std::endl;
@@ -251,15 +429,32 @@ void runRefilterBreakpoints(int argc, char** argv) {
  
     std::string basename = opt::analysis_id + ".svaba.unfiltered.";
     snowvcf.include_nonpass = true;
-    snowvcf.writeIndels(basename, false, allele_names.size() == 1);
-    snowvcf.writeSVs(basename, false, allele_names.size() == 1);
+    snowvcf.writeIndels(basename, false, num_samples == 1);
+    snowvcf.writeSVs(basename, false, num_samples == 1);
 
     basename = opt::analysis_id + ".svaba.";
     snowvcf.include_nonpass = false;
-    snowvcf.writeIndels(basename, false, allele_names.size() == 1);
-    snowvcf.writeSVs(basename, false, allele_names.size() == 1);
+    snowvcf.writeIndels(basename, false, num_samples == 1);
+    snowvcf.writeSVs(basename, false, num_samples == 1);
 
   } else {
     std::cerr << "Failed to make VCF. Could not file bps file " << opt::input_file << std::endl;
   }
 }
+
+void runExportBreakPoints(int argc, char** argv) {
+
+  if (argc != 3) {
+    std::cerr << "Usage: svaba export-bps bps.bin bps.txt.gz\n\n"
+	      << "  Description: Write a binary breakpoints file (bps.bin) out as the bps.txt.gz text format\n";
+    exit(EXIT_FAILURE);
+  }
+
+  long count = ExportBreakPoints(argv[1], argv[2], SeqLib::BamHeader());
+  if (count < 0) {
+    std::cerr << "ERROR: Could not read " << argv[1] << " or write " << argv[2] << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  std::cerr << "...exported " << SeqLib::AddCommas(count) << " breakpoints to " << argv[2] << std::endl;
+
+}
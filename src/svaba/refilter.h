@@ -3,5 +3,6 @@
 
 void parseBreakOptions(int argc, char** argv);
 void runRefilterBreakpoints(int argc, char** argv);
+void runExportBreakPoints(int argc, char** argv);
 
 #endif
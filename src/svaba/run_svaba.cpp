@@ -3,10 +3,13 @@
 #include <getopt.h>
 #include <iostream>
 #include <sstream>
+#include <iomanip>
 #include <unordered_map>
 #include <map>
 #include <vector>
 #include <cassert>
+#include <atomic>
+#include <chrono>
 
 #include "SeqLib/ReadFilter.h"
 #include "KmerFilter.h"
@@ -16,6 +19,10 @@
 #include "LearnBamParams.h"
 #include "SeqLib/BFC.h"
 #include "svaba_params.h"
+#include "BreakPointStore.h"
+#include "LocalRefAligner.h"
+#include "AssemblyCache.h"
+#include "svabaFermiAssemblerEngine.h"
 
 // useful replace function
 std::string myreplace(std::string &s,
@@ -26,7 +33,8 @@ std::string myreplace(std::string &s,
 }
 
 // output files
-static ogzstream all_align, os_allbps, os_discordant, os_corrected;
+static ogzstream all_align, os_discordant, os_corrected;
+static BreakPointWriter bps_writer; // binary breakpoints, exported to bps.txt.gz at the end
 static std::ofstream log_file, bad_bed;
 static std::stringstream ss; // initalize a string stream once
 
@@ -43,6 +51,9 @@ static std::stringstream ss; // initalize a string stream once
 // NM, then dont' consider it a strong local match
 #define MAX_NM_FOR_LOCAL 10 
 
+// assemble every window with both SGA and fermi-lite, and log their speed and concordance
+//#define BENCH_ASSEMBLER 1
+
 static SeqLib::RefGenome * ref_genome, * ref_genome_viral;
 static std::unordered_map<std::string, BamParamsMap> params_map; // key is bam id (t000), value is map with read group as key
 static SeqLib::BamHeader bwa_header, viral_header;
@@ -52,12 +63,17 @@ static std::set<std::string> prefixes;
 static int min_dscrd_size_for_variant = 0; // set a min size for what we can call with discordant reads only. 
 // something like max(mean + 3*sd) for all read groups
 
-static std::unordered_map<std::string, int> min_isize_for_disc;
+static ReadGroupCutoffs min_isize_for_disc; // discordant isize cutoff, dense by read group
 
 static SeqLib::BamHeader b_header; // header for main bam
 static SeqLib::BamReader b_reader; // reader for the main bam
 static SeqLib::BamWriter er_writer, b_microbe_writer, b_contig_writer;
 static SeqLib::BWAWrapper * microbe_bwa = nullptr;
+static AssemblyCache assembly_cache; // contigs of assemblies already done, by read-set fingerprint
+static svabaUtils::KmerBloomFilter * microbe_bloom = nullptr; // microbe k-mers, to skip contigs that can't seed there
+static std::atomic<size_t> microbe_screened(0), microbe_aligned(0), microbe_aligned_hit(0);
+static std::atomic<size_t> triage_windows(0), triage_skipped(0), triage_skipped_reads(0), assembled_reads(0);
+static std::atomic<uint64_t> triage_usecs(0), assembly_usecs(0); // to estimate the assembly time saved by the triage
 static SeqLib::BWAWrapper * main_bwa = nullptr;
 static SeqLib::Filter::ReadFilterCollection * mr;
 static SeqLib::GRC blacklist, germline_svs, simple_seq;
@@ -66,6 +82,10 @@ static SeqLib::GRC file_regions, regions_torun;
 
 // mutex and time
 static pthread_mutex_t snow_lock;
+
+static MateFetchService mate_fetcher; // batched mate-region reads, shared across threads
+static wqueue<svabaWorkItem*> * work_queue = nullptr; // so windows can schedule their sub-windows
+static svabaTaskPool * task_pool = nullptr; // so large windows can share their work with idle threads
 static struct timespec start;
 
 // learned value 
@@ -75,6 +95,9 @@ static int32_t readlen = 0;
 
 namespace opt {
 
+  static std::string assembler = "sga"; // local assembler, sga or fml (fermi-lite)
+  static std::string kmer_triage; // skip assembly of windows with no novel k-mers: ref, or somatic (also not in the normal)
+
   // SGA options
   namespace sga {
     static int minOverlap = 0;
@@ -97,6 +120,8 @@ namespace opt {
   static bool read_tracking = false; // turn on output of qnames
   static bool all_contigs = false;   // output all contigs
   static bool no_unfiltered = false; // don't output unfiltered variants
+  static bool no_bps_text = false; // don't export the breakpoints to bps.txt.gz
+  static std::string assembly_cache; // file to load assemblies from and save them to
 
   // discordant clustering params
   static double sd_disc_cutoff = 3.92;
@@ -123,6 +148,7 @@ namespace opt {
   static bool interchrom_lookup = true;
   static int32_t max_reads_per_assembly = -1; // set default of 50000 in parseRunOptions
   static bool no_bad_avoid = true; // if true, don't avoid previously bad regions
+  static bool adaptive_split = false; // split windows with too many reads, instead of skipping
 
   // additional optional params
   static int chunk = 25000;
@@ -188,7 +214,12 @@ enum {
   OPT_GERMLINE,
   OPT_SCALE_ERRORS,
   OPT_NO_UNFILTERED,
-  OPT_OVERRIDE_REFERENCE_CHECK
+  OPT_OVERRIDE_REFERENCE_CHECK,
+  OPT_ADAPTIVE_SPLIT,
+  OPT_NO_BPS_TEXT,
+  OPT_ASSEMBLY_CACHE,
+  OPT_ASSEMBLER,
+  OPT_KMER_TRIAGE
 };
 
 static const char* shortopts = "hzIAt:n:p:v:r:G:e:k:c:a:m:B:D:Y:S:L:s:V:R:K:E:C:x:M:";
@@ -237,6 +268,8 @@ static const struct option longopts[] = {
   { "discordant-only",         no_argument, NULL, OPT_DISCORDANT_ONLY },
   { "num-to-sample",           required_argument, NULL, OPT_NUM_TO_SAMPLE },
   { "write-asqg",              no_argument, NULL, OPT_ASQG   },
+  { "assembler",               required_argument, NULL, OPT_ASSEMBLER },
+  { "kmer-triage",             required_argument, NULL, OPT_KMER_TRIAGE },
   { "ec-correct-type",         required_argument, NULL, 'K'},
   { "error-rate",              required_argument, NULL, 'e'},
   { "verbose",                 required_argument, NULL, 'v' },
@@ -244,6 +277,9 @@ static const struct option longopts[] = {
   { "max-coverage",            required_argument, NULL, 'C' },
   { "max-reads",               required_argument, NULL, 'x' },
   { "max-reads-mate-region",   required_argument, NULL, 'M' },
+  { "adaptive-split",          no_argument, NULL, OPT_ADAPTIVE_SPLIT },
+  { "no-bps-text",             no_argument, NULL, OPT_NO_BPS_TEXT },
+  { "assembly-cache",          required_argument, NULL, OPT_ASSEMBLY_CACHE },
   { "num-assembly-rounds",     required_argument, NULL, OPT_NUM_ASSEMBLY_ROUNDS },
   { "override-reference-check",no_argument, NULL, OPT_OVERRIDE_REFERENCE_CHECK},
   { NULL, 0, NULL, 0 }
@@ -277,6 +313,8 @@ static const char *RUN_USAGE_MESSAGE =
 "  -x, --max-reads                      Max total read count to read in from assembly region. Set 0 to turn off. [50000]\n"
 "  -M, --max-reads-mate-region          Max weird reads to include from a mate lookup region. [400]\n"
 "  -C, --max-coverage                   Max read coverage to send to assembler (per BAM). Subsample reads if exceeded. [500]\n"
+"      --assembly-cache                 File to reuse assemblies of identical read sets from, and save them to. For reruns on the same BAMs.\n"
+"      --adaptive-split                 Split windows that exceed the read limits into smaller sub-windows, instead of skipping assembly.\n"
 "      --no-interchrom-lookup           Skip mate lookup for inter-chr candidate events. Reduces power for translocations but less I/O.\n"
 "      --discordant-only                Only run the discordant read clustering module, skip assembly. \n"
 "      --num-assembly-rounds            Run assembler multiple times. > 1 will bootstrap the assembly. [2]\n"
@@ -288,13 +326,16 @@ static const char *RUN_USAGE_MESSAGE =
 "  -A, --all-contigs                    Output all contigs that were assembled, regardless of mapping or length. [off]\n"
 "      --read-tracking                  Track supporting reads by qname. Increases file sizes. [off]\n"
 "      --write-extracted-reads          For the case BAM, write reads sent to assembly to a BAM file. [off]\n"
+"      --no-bps-text                    Only write the binary breakpoints file (bps.bin), and skip exporting it to bps.txt.gz [off]\n"
 "  Optional external database\n"
-"  -D, --dbsnp-vcf                      DBsnp database (VCF) to compare indels against\n"
+"  -D, --dbsnp-vcf                      DBsnp database (VCF, or index from svaba index-dbsnp) to compare indels against\n"
 "  -B, --blacklist                      BED-file with blacklisted regions to not extract any reads from.\n"
 "  -Y, --microbial-genome               Path to indexed reference genome of microbial sequences to be used by BWA-MEM to filter reads.\n"
 "  -V, --germline-sv-database           BED file containing sites of known germline SVs. Used as additional filter for somatic SV detection\n"
 "  -R, --simple-seq-database            BED file containing sites of simple DNA that can confuse the contig re-alignment.\n"
 "  Assembly and EC params\n"
+"      --assembler                      Local assembler: (sga) SGA string graph, (fml) fermi-lite unitigs with its own error correction [sga]\n"
+"      --kmer-triage                    Skip assembly of windows whose reads have no k-mers absent from the (ref) reference, or (somatic) reference and normal reads [off]\n"
 "  -m, --min-overlap                    Minimum read overlap, an SGA parameter. Default: 0.4* readlength\n"
 "  -e, --error-rate                     Fractional difference two reads can have to overlap. See SGA. 0 is fast, but requires error correcting. [0]\n"
 "  -K, --ec-correct-type                (f) Fermi-kit BFC correction, (s) Kmer-correction from SGA, (0) no correction (then suggest non-zero -e) [f]\n"
@@ -312,6 +353,41 @@ static const char *RUN_USAGE_MESSAGE =
 "      --penalty-clip-5                 Set the BWA-MEM penalty for 5' clipping. [5]\n"
 "\n";
 
+// hash the k-mers of the microbe genomes, so contigs that can't seed there skip BWA
+static void buildMicrobeBloom() {
+
+  size_t total = 0;
+  for (int i = 0; i < viral_header.NumSequences(); ++i)
+    total += viral_header.GetSequenceLength(i);
+  if (!total || total * MICROBE_BLOOM_BITS_PER_KMER / 8 > (size_t)MICROBE_BLOOM_MAX_MB << 20) {
+    WRITELOG("...not building microbe Bloom prescreen for " + SeqLib::AddCommas<size_t>(total) + " bp of microbe sequence", opt::verbose > 0, true);
+    return;
+  }
+
+  svabaUtils::svabaTimer st;
+  microbe_bloom = new svabaUtils::KmerBloomFilter(MICROBE_BLOOM_K, total, MICROBE_BLOOM_BITS_PER_KMER, MICROBE_BLOOM_HASHES);
+  for (int i = 0; i < viral_header.NumSequences(); ++i) {
+    int len = viral_header.GetSequenceLength(i);
+    if (len < MICROBE_BLOOM_K)
+      continue;
+    try {
+      microbe_bloom->add(ref_genome_viral->QueryRegion(viral_header.IDtoName(i), 0, len - 1));
+    } catch (...) {
+      WRITELOG("...could not read microbe sequence " + viral_header.IDtoName(i) + " for the Bloom prescreen. Disabling it", true, true);
+      delete microbe_bloom;
+      microbe_bloom = nullptr;
+      return;
+    }
+  }
+  st.stop("bloom");
+
+  std::stringstream ss;
+  ss << "...built microbe Bloom prescreen: " << SeqLib::AddCommas<size_t>(microbe_bloom->NumAdded()) << " " << MICROBE_BLOOM_K 
+     << "-mers in " << SeqLib::AddCommas<size_t>(microbe_bloom->Bytes() >> 20) << " MB, expected FP rate per k-mer "
+     << microbe_bloom->FalsePositiveRate() << " in " << st.times["bloom"] / CLOCKS_PER_SEC << "s";
+  WRITELOG(ss.str(), opt::verbose > 0, true);
+}
+
 void runsvaba(int argc, char** argv) {
 
   parseRunOptions(argc, argv);
@@ -350,6 +426,8 @@ void runsvaba(int argc, char** argv) {
     "***************************** PARAMS ****************************" << std::endl << 
     "    DBSNP Database file: " << opt::dbsnp << std::endl << 
     "    Max cov to assemble: " << opt::max_cov << std::endl <<
+    "    Assembler: " << opt::assembler << std::endl << 
+    "    K-mer triage: " << (opt::kmer_triage.empty() ? "off" : opt::kmer_triage) << std::endl << 
     "    Error correction mode: " << opt::ec_correct_type << std::endl << 
     "    Subsample-rate for correction learning: " + std::to_string(opt::ec_subsample) << std::endl;
     ss << 
@@ -398,6 +476,7 @@ void runsvaba(int argc, char** argv) {
     WRITELOG("...loading the microbe reference sequence", opt::verbose > 0, true)
     microbe_bwa = new SeqLib::BWAWrapper();
     svabaUtils::__open_index_and_writer(opt::microbegenome, microbe_bwa, opt::analysis_id + ".microbe.bam", b_microbe_writer, ref_genome_viral, viral_header);  
+    buildMicrobeBloom();
   }
 
   // open the main bam to get header info
@@ -442,6 +521,15 @@ void runsvaba(int argc, char** argv) {
     WRITELOG("...loaded DBsnp database", opt::verbose > 0, true)
   }
 
+  // open the assembly cache
+  if (opt::assembly_cache.length()) {
+    if (!assembly_cache.Open(opt::assembly_cache)) {
+      WRITELOG("ERROR: " + opt::assembly_cache + " is not an svaba assembly cache", true, true);
+      exit(EXIT_FAILURE);
+    }
+    WRITELOG("...loaded " + SeqLib::AddCommas<size_t>(assembly_cache.size()) + " cached assemblies from " + opt::assembly_cache, opt::verbose > 0, true);
+  }
+
   // needed for aligned contig
   for (auto& b : opt::bam)
     prefixes.insert(b.first);
@@ -595,7 +683,7 @@ afterlearn:
 	int mi = std::floor(i.second.mean_isize + i.second.sd_isize * opt::sd_disc_cutoff);
 	ss_rules << "{\"isize\" : [ " << mi << ",0], \"rg\" : \"" << i.second.read_group << "\"},";
 	rg_seen.insert(i.second.read_group);
-	min_isize_for_disc.insert(std::pair<std::string, int>(i.second.read_group, mi));
+	min_isize_for_disc.Add(i.second.read_group, mi);
       }
     } 
   }
@@ -634,16 +722,22 @@ afterlearn:
 
   // open the text files
   svabaUtils::fopen(opt::analysis_id + ".alignments.txt.gz", all_align);
-  svabaUtils::fopen(opt::analysis_id + ".bps.txt.gz", os_allbps);
   svabaUtils::fopen(opt::analysis_id + ".discordant.txt.gz", os_discordant);
   if (opt::write_extracted_reads) 
     svabaUtils::fopen(opt::analysis_id + ".corrected.fa.gz", os_corrected); 
   
+  // open the breakpoints file, with the sample names for the text header
+  std::vector<std::string> sample_ids, sample_labels;
+  for (auto& b : opt::bam) {
+    sample_ids.push_back(b.first);
+    sample_labels.push_back(b.first + "_" + b.second);
+  }
+  if (!bps_writer.Open(opt::analysis_id + ".bps.bin", sample_ids, sample_labels)) {
+    WRITELOG("ERROR: could not open breakpoints file " + opt::analysis_id + ".bps.bin", true, true);
+    exit(EXIT_FAILURE);
+  }
+
   // write the headers to the text files
-  os_allbps << BreakPoint::header();
-  for (auto& b : opt::bam) 
-    os_allbps << "\t" << b.first << "_" << b.second;
-  os_allbps << std::endl;
   os_discordant << DiscordantCluster::header() << std::endl;
 
   // put args into string for VCF later
@@ -660,6 +754,38 @@ afterlearn:
   WRITELOG("--- Loaded non-read data. Starting detection pipeline", true, true);
   sendThreads(regions_torun);
 
+  if (mate_fetcher.NumRequests())
+    WRITELOG("...mate lookups: " + SeqLib::AddCommas(mate_fetcher.NumRequests()) + " requests for " + 
+	     SeqLib::AddCommas(mate_fetcher.NumRegions()) + " regions read with " + SeqLib::AddCommas(mate_fetcher.NumSeeks()) + 
+	     " seeks (" + SeqLib::AddCommas(mate_fetcher.NumRegions() - mate_fetcher.NumSeeks()) + " avoided), " + 
+	     SeqLib::AddCommas(mate_fetcher.NumRecordBytes()) + " bytes of records, " + 
+	     SeqLib::AddCommas(mate_fetcher.NumTruncated()) + " regions cut at " + 
+	     SeqLib::AddCommas(MATE_FETCH_MAX_RECORDS) + " records", opt::verbose > 0, true);
+
+  if (assembly_cache.NumLookups())
+    WRITELOG("...assembly cache: " + SeqLib::AddCommas<size_t>(assembly_cache.NumHits()) + " of " + 
+	     SeqLib::AddCommas<size_t>(assembly_cache.NumLookups()) + " assemblies reused", opt::verbose > 0, true);
+  if (assembly_cache.Save() < 0)
+    WRITELOG("WARNING: could not write assembly cache " + opt::assembly_cache, true, true);
+
+  if (microbe_bloom) {
+    size_t saved = microbe_screened - microbe_aligned;
+    WRITELOG("...microbe Bloom prescreen: " + SeqLib::AddCommas<size_t>(microbe_screened) + " contigs screened, " + 
+	     SeqLib::AddCommas<size_t>(saved) + " BWA alignments skipped, " + SeqLib::AddCommas<size_t>(microbe_aligned - microbe_aligned_hit) + 
+	     " of " + SeqLib::AddCommas<size_t>(microbe_aligned) + " aligned contigs had no microbe hit", opt::verbose > 0, true);
+    delete microbe_bloom;
+  }
+
+  if (triage_windows) {
+    // the time saved is estimated from the assembly time per read of the windows that were assembled
+    double saved = assembled_reads ? (double)assembly_usecs / assembled_reads * triage_skipped_reads : 0;
+    std::stringstream ts;
+    ts << std::fixed << std::setprecision(1) << "...k-mer triage: " << SeqLib::AddCommas<size_t>(triage_skipped) << " of " << 
+      SeqLib::AddCommas<size_t>(triage_windows) << " windows skipped (" << SeqLib::AddCommas<size_t>(triage_skipped_reads) << 
+      " reads), " << triage_usecs / 1e6 << "s of triage saved about " << saved / 1e6 << "s of assembly";
+    WRITELOG(ts.str(), opt::verbose > 0, true);
+  }
+
   if (microbe_bwa)
     delete microbe_bwa;
 
@@ -679,7 +805,7 @@ afterlearn:
 
   // close the files
   all_align.close();
-  os_allbps.close();
+  bps_writer.Close();
   os_discordant.close();
   if (opt::write_corrected_reads) 
     os_corrected.close();
@@ -691,6 +817,13 @@ afterlearn:
   if (ref_genome_viral)
     delete ref_genome_viral;
   
+  // text version of the breakpoints, for compatibility
+  if (!opt::no_bps_text) {
+    WRITELOG("...exporting breakpoints to " + opt::analysis_id + ".bps.txt.gz", opt::verbose, true);
+    if (ExportBreakPoints(opt::analysis_id + ".bps.bin", opt::analysis_id + ".bps.txt.gz", b_header) < 0)
+      WRITELOG("ERROR: could not export breakpoints to " + opt::analysis_id + ".bps.txt.gz", true, true);
+  }
+
   // make the VCF file
   makeVCFs();
   
@@ -712,9 +845,9 @@ void makeVCFs() {
   // make the VCF file
   WRITELOG("...loading the bps files for conversion to VCF", opt::verbose, true);
 
-  std::string file = opt::analysis_id + ".bps.txt.gz";
-  //if !SeqLib::read_access_test(file))
-  //  file = opt::analysis_id + ".bps.txt";
+  std::string file = opt::analysis_id + ".bps.bin";
+  if (!SeqLib::read_access_test(file))
+    file = opt::analysis_id + ".bps.txt.gz";
 
   // make the header
   VCFHeader header;
@@ -797,6 +930,11 @@ void parseRunOptions(int argc, char** argv) {
     case OPT_GAP_OPEN : arg >> opt::bwa::gap_open_penalty; break;
     case OPT_OVERRIDE_REFERENCE_CHECK : opt::override_reference_check = true; break;
     case 'x' : arg >> opt::max_reads_per_assembly; break;
+    case OPT_ADAPTIVE_SPLIT : opt::adaptive_split = true; break;
+    case OPT_NO_BPS_TEXT : opt::no_bps_text = true; break;
+    case OPT_ASSEMBLY_CACHE : arg >> opt::assembly_cache; break;
+    case OPT_ASSEMBLER : arg >> opt::assembler; break;
+    case OPT_KMER_TRIAGE : arg >> opt::kmer_triage; break;
     case 'M' : arg >> opt::mate_region_lookup_limit; break;
     case 'A' : opt::all_contigs = true; break;
     case OPT_MATCH_SCORE : arg >> opt::bwa::sequence_match_score; break;
@@ -867,6 +1005,21 @@ void parseRunOptions(int argc, char** argv) {
     exit(EXIT_FAILURE);
   }
 
+  if (!(opt::assembler == "sga" || opt::assembler == "fml")) {
+    WRITELOG("ERROR: Assembler must be one of sga or fml", true, true);
+    exit(EXIT_FAILURE);
+  }
+
+  if (opt::assembler == "fml" && opt::sga::writeASQG) {
+    WRITELOG("ERROR: --write-asqg needs --assembler sga", true, true);
+    exit(EXIT_FAILURE);
+  }
+
+  if (!(opt::kmer_triage.empty() || opt::kmer_triage == "ref" || opt::kmer_triage == "somatic")) {
+    WRITELOG("ERROR: K-mer triage must be one of ref or somatic", true, true);
+    exit(EXIT_FAILURE);
+  }
+
   // check that we input something
   if (opt::bam.size() == 0 && !die) {
     WRITELOG("Must add a bam file with -t flag. stdin with -t -", true, true);
@@ -888,13 +1041,19 @@ void parseRunOptions(int argc, char** argv) {
     }
 }
 
-bool runWorkItem(const SeqLib::GenomicRegion& region, svabaThreadUnit& wu, long unsigned int thread_id) {
+bool runWorkItem(const SeqLib::GenomicRegion& region, svabaThreadUnit& wu, long unsigned int thread_id, int split_level) {
   
   WRITELOG("Running region " + region.ToString(bwa_header) + " on thread " + std::to_string(thread_id), opt::verbose > 1, true);
 
   for (auto& w : wu.walkers)
     set_walker_params(w.second);
 
+  // a sub-window that can't be split any further gets a higher read cap, rather
+  // than giving up. The coverage subsampling brings it back down for assembly
+  if (split_level && !can_split(region, split_level))
+    for (auto& w : wu.walkers)
+      w.second.m_limit = (size_t)opt::max_reads_per_assembly * SUBWINDOW_HARD_LIMIT_FACTOR;
+
   // create a new BFC read error corrector for this
   SeqPointer<SeqLib::BFC> bfc;
   if (opt::ec_correct_type == "f") {
@@ -906,6 +1065,8 @@ bool runWorkItem(const SeqLib::GenomicRegion& region, svabaThreadUnit& wu, long
   // setup structures to store the final data for this region
   std::vector<AlignedContig> alc;
   SeqLib::BamRecordVector all_contigs, all_microbial_contigs;
+  std::string lregion; // reference of the window, fetched once for the triage and the assembly
+  std::chrono::steady_clock::time_point assembly_start;
 
   // start a timer
   svabaUtils::svabaTimer st;
@@ -913,13 +1074,14 @@ bool runWorkItem(const SeqLib::GenomicRegion& region, svabaThreadUnit& wu, long
 
   // setup for the BAM walkers
   CountPair read_counts = {0,0};
+  bool hit_limit = false; // did any walker stop reading this window early
 
   // read in alignments from the main region
   for (auto& w : wu.walkers) {
 
     // set the region to jump to
     if (!region.IsEmpty()) {
-      w.second.SetRegion(region);
+      w.second.SetWindow(region);
     } else { // whole BAM analysis. If region file set, then set regions
       if (file_regions.size()) {
 	w.second.SetMultipleRegions(file_regions);
@@ -929,7 +1091,11 @@ bool runWorkItem(const SeqLib::GenomicRegion& region, svabaThreadUnit& wu, long
     }
 
     // do the reading, and store the bad mate regions
-    wu.badd.Concat(w.second.readBam(&log_file)); 
+    SeqLib::GRC bad = w.second.readBam(&log_file);
+    hit_limit = hit_limit || bad.size();
+    wu.badd.Concat(bad); 
+    if (w.second.num_reused)
+      WRITELOG("\treused " + SeqLib::AddCommas(w.second.num_reused) + " reads from the last window for " + w.first, opt::verbose > 2, true);
     wu.badd.MergeOverlappingIntervals();
     wu.badd.CreateTreeMap();
     
@@ -943,7 +1109,7 @@ bool runWorkItem(const SeqLib::GenomicRegion& region, svabaThreadUnit& wu, long
   }
 
   // collect all of the cigar strings in a hash
-  std::unordered_map<std::string, SeqLib::CigarMap> cigmap;
+  std::unordered_map<std::string, IndelCigarMap> cigmap;
   for (const auto& w : wu.walkers) 
     cigmap[w.first] = w.second.cigmap;
 
@@ -959,6 +1125,20 @@ bool runWorkItem(const SeqLib::GenomicRegion& region, svabaThreadUnit& wu, long
   // adjust counts and timer
   st.stop("r");
 
+  // discordant read clusters of this window, filled in below
+  DiscordantClusterMap dmap, dmap_tmp;
+
+  // too many reads (or only some of them were read): split into sub-windows with 
+  // their own read limits and hand them to the other threads, instead of skipping.
+  // Done before the mate lookup and clustering, which the sub-windows do again
+  if ((hit_limit || (bav_this.size() > (size_t)(region.Width() * 20) && region.Width() > 20000)) &&
+      can_split(region, split_level)) {
+    WRITELOG("Splitting " + region.ToString(bwa_header) + " with " + SeqLib::AddCommas(bav_this.size()) + 
+	     " reads into sub-windows", opt::verbose > 1, true);
+    schedule_subwindows(region, split_level);
+    goto afterassembly;
+  }
+
   // get the mate reads, if this is local assembly and has insert-size distro
   if (!region.IsEmpty() && !opt::single_end && min_dscrd_size_for_variant) {
     run_mate_collection_loop(region, wu.walkers, wu.badd);
@@ -966,12 +1146,8 @@ bool runWorkItem(const SeqLib::GenomicRegion& region, svabaThreadUnit& wu, long
     collect_and_clear_reads(wu.walkers, bav_this, all_seqs, dedupe);
     st.stop("m");
   }
-  
 
-  // do the discordant read clustering
-  DiscordantClusterMap dmap, dmap_tmp;
-  
-  // if couldn't get insert size stats, skip discordant clustering
+  // do the discordant read clustering. If couldn't get insert size stats, skip it
   if (!min_dscrd_size_for_variant || opt::single_end)
     goto afterdiscclustering;
 
@@ -1028,6 +1204,35 @@ bool runWorkItem(const SeqLib::GenomicRegion& region, svabaThreadUnit& wu, long
     goto afterassembly;
   }
 
+  // get the local region. With the triage, pad it so reads hanging off the window aren't novel
+  if (!region.IsEmpty()) {
+    int32_t pad = opt::kmer_triage.empty() ? 0 : TRIAGE_REF_PAD;
+    int32_t p1 = std::max(region.pos1 - pad, 0);
+    std::string padded;
+    try {
+      padded = wu.ref_genome->QueryRegion(bwa_header.IDtoName(region.chr), p1, region.pos2 + pad);
+    } catch (...) {
+      WRITELOG(" Caught exception for lregion with reg " + region.ToString(bwa_header), true, true);
+    }
+    if ((size_t)(region.pos1 - p1) < padded.length())
+      lregion = padded.substr(region.pos1 - p1, region.pos2 - region.pos1 + 1);
+
+    if (!opt::kmer_triage.empty() && !lregion.empty()) {
+      std::chrono::steady_clock::time_point triage_start = std::chrono::steady_clock::now();
+      size_t novel = count_novel_kmers(padded, bav_this, opt::kmer_triage == "somatic");
+      triage_usecs += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - triage_start).count();
+      ++triage_windows;
+      if (novel < TRIAGE_MIN_NOVEL_KMERS) {
+	++triage_skipped;
+	triage_skipped_reads += bav_this.size();
+	WRITELOG("Skipping assembly (no novel k-mers in " + SeqLib::AddCommas(bav_this.size()) + " reads) on " + 
+		 region.ToString(bwa_header), opt::verbose > 1, false);
+	goto afterassembly;
+      }
+    }
+  }
+  assembly_start = std::chrono::steady_clock::now();
+
   // do the kmer correction, in place
   if (opt::ec_correct_type == "s") {
     correct_reads(all_seqs, bav_this);
@@ -1068,7 +1273,9 @@ bool runWorkItem(const SeqLib::GenomicRegion& region, svabaThreadUnit& wu, long
   
   // do the assembly, contig realignment, contig local realignment, and read realignment
   // modifes bav_this, alc, all_contigs and all_microbial_contigs
-  run_assembly(region, bav_this, alc, all_contigs, all_microbial_contigs, dmap, cigmap, wu.ref_genome);
+  run_assembly(region, lregion, bav_this, alc, all_contigs, all_microbial_contigs, dmap, cigmap, wu.ref_genome);
+  assembled_reads += bav_this.size();
+  assembly_usecs += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - assembly_start).count();
 
 afterassembly:
 
@@ -1129,38 +1336,38 @@ afterassembly:
   }
 
   // label somatic breakpoints that intersect directly with normal as NOT somatic
-  std::unordered_set<std::string> norm_hash;
+  std::unordered_set<uint64_t> norm_hash;
   for (auto& i : bp_glob) // hash the normals
-    if (!i.somatic_score && i.confidence == "PASS" && i.evidence == "INDEL") {
-      norm_hash.insert(i.b1.hash());
-      norm_hash.insert(i.b2.hash());
-      norm_hash.insert(i.b1.hash(1));
-      norm_hash.insert(i.b1.hash(-1));
+    if (!i.somatic_score && i.confidence == CONF_PASS && i.evidence == EVDNC_INDEL) {
+      norm_hash.insert(i.b1.key());
+      norm_hash.insert(i.b2.key());
+      norm_hash.insert(i.b1.key(1));
+      norm_hash.insert(i.b1.key(-1));
     }
 
   // find somatic that intersect with norm. Set somatic = 0;
   for (auto& i : bp_glob)  
-    if (i.somatic_score && i.evidence == "INDEL" && (norm_hash.count(i.b1.hash()) || norm_hash.count(i.b2.hash()))) {
+    if (i.somatic_score && i.evidence == EVDNC_INDEL && (norm_hash.count(i.b1.key()) || norm_hash.count(i.b2.key()))) {
       i.somatic_score = -3;
     }
 
   // remove indels at repeats that have multiple variants
-  std::unordered_map<std::string, size_t> ccc;
+  std::unordered_map<uint64_t, size_t> ccc;
   for (auto& i : bp_glob) {
-    if (i.evidence == "INDEL" && i.repeat_seq.length() > 6) {
-      ++ccc[i.b1.hash()];
+    if (i.evidence == EVDNC_INDEL && i.repeat_seq.length() > 6) {
+      ++ccc[i.b1.key()];
     }
   }
   for (auto& i : bp_glob) {
-    if (i.evidence == "INDEL" && ccc[i.b1.hash()] > 1)
-      i.confidence = "REPVAR";
+    if (i.evidence == EVDNC_INDEL && ccc[i.b1.key()] > 1)
+      i.confidence = CONF_REPVAR;
   }
 
   // remove somatic calls if they have a germline normal SV in them or indels with 
   // 2+germline normal in same contig
   std::unordered_set<std::string> bp_hash;
   for (auto& i : bp_glob) { // hash the normals
-    if (!i.somatic_score && i.evidence != "INDEL" && i.confidence == "PASS") {
+    if (!i.somatic_score && i.evidence != EVDNC_INDEL && i.confidence == CONF_PASS) {
       bp_hash.insert(i.cname);
     }
   }
@@ -1172,7 +1379,7 @@ afterassembly:
   // remove somatic SVs that overlap with germline svs
   if (germline_svs.size()) {
     for (auto& i : bp_glob) {
-      if (i.somatic_score && i.b1.gr.chr == i.b2.gr.chr && i.evidence != "INDEL") {
+      if (i.somatic_score && i.b1.gr.chr == i.b2.gr.chr && i.evidence != EVDNC_INDEL) {
 	SeqLib::GenomicRegion gr1 = i.b1.gr;
 	SeqLib::GenomicRegion gr2 = i.b2.gr;
 	gr1.Pad(GERMLINE_CNV_PAD);
@@ -1205,7 +1412,7 @@ afterassembly:
   for (const auto& a : alc)
     wu.m_bamreads_count += a.NumBamReads();
   for (auto& i : bp_glob) 
-    if ( i.hasMinimal() && (i.confidence != "NOLOCAL" || i.complex_local ) ) 
+    if ( i.hasMinimal() && (i.confidence != CONF_NOLOCAL || i.complex_local ) ) 
       wu.m_bps.push_back(i);
   
   // dump if getting to much memory
@@ -1254,14 +1461,22 @@ afterassembly:
 
 void sendThreads(SeqLib::GRC& regions_torun) {
 
+  // open the readers for the mate lookups
+  if (!mate_fetcher.Open(opt::bam)) {
+    WRITELOG("ERROR: could not open BAMs for mate lookup", true, true);
+    exit(EXIT_FAILURE);
+  }
+
   // Create the queue and consumer (worker) threads
   wqueue<svabaWorkItem*>  queue;
+  work_queue = &queue;
+  svabaTaskPool pool([&queue] { queue.wake(); }); // threads waiting for windows help with posted tasks
+  task_pool = &pool;
   std::vector<ConsumerThread<svabaWorkItem>*> threadqueue;
   for (int i = 0; i < opt::numThreads; i++) {
     ConsumerThread<svabaWorkItem>* threadr = new ConsumerThread<svabaWorkItem>(queue, opt::verbose > 0,
 										   opt::refgenome, opt::microbegenome,
-										   opt::bam);
-    threadr->start();
+										   opt::bam, i, &pool);
     threadqueue.push_back(threadr);
   }
 
@@ -1275,10 +1490,21 @@ void sendThreads(SeqLib::GRC& regions_torun) {
     svabaWorkItem * item     = new svabaWorkItem(SeqLib::GenomicRegion(), ++count);
     queue.add(item);
   }
+
+  // give each thread a contiguous run of windows, so consecutive windows on 
+  // a thread overlap and the walkers can reuse the reads from the shared pad
+  queue.partition(opt::numThreads);
+  for (auto& t : threadqueue)
+    t->start();
   
   // wait for the threads to finish
   for (int i = 0; i < opt::numThreads; ++i) 
     threadqueue[i]->join();
+  work_queue = nullptr;
+  task_pool = nullptr;
+
+  WRITELOG("...idle threads stole windows from another thread's run " + std::to_string(queue.steals()) + " times", opt::verbose > 1, true);
+  WRITELOG("...idle threads ran " + std::to_string(pool.helped()) + " overlap and alignment tasks of large windows", opt::verbose > 1, true);
 
   // write and free remaining items stored in the thread
   pthread_mutex_lock(&snow_lock);
@@ -1288,11 +1514,18 @@ void sendThreads(SeqLib::GRC& regions_torun) {
 
 }
 
-void alignReadsToContigs(SeqLib::BWAWrapper& bw, const SeqLib::UnalignedSequenceVector& usv, 
-			 svabaReadVector& bav_this, std::vector<AlignedContig>& this_alc, const SeqLib::RefGenome *  rg) {
+size_t alignReadsToContigs(SeqLib::BWAWrapper& bw, const SeqLib::UnalignedSequenceVector& usv, 
+			   svabaReadVector& bav_this, std::vector<AlignedContig>& this_alc, const SeqLib::RefGenome *  rg) {
   
   if (!usv.size())
-    return;
+    return 0;
+
+  // k-mers of the contigs. A read that shares none of them can't make
+  // the alignment length / score cutoffs below, so don't align it
+  svabaUtils::KmerSketch sketch(ALIGN_PREFILTER_K);
+  for (auto& u : usv)
+    sketch.add(u.Seq);
+  sketch.finalize();
 
   // get the reference info
   SeqLib::GRC g;
@@ -1330,18 +1563,25 @@ void alignReadsToContigs(SeqLib::BWAWrapper& bw, const SeqLib::UnalignedSequence
   bw_ref.SetMismatchPenalty(9); // default 2
   bw.SetMismatchPenalty(9); // default 4
 
-  for (auto i : bav_this) {
+  size_t skipped = 0;
+  for (auto& read : bav_this) {
     
-    SeqLib::BamRecordVector brv, brv_ref;
-
     // try the corrected seq first
     //std::string seqr = i.GetZTag("KC");
     //  if (seqr.empty())
     //	seqr = i.QualitySequence();
-    std::string seqr = i.Seq();
+    std::string seqr = read.Seq();
+    assert(seqr.length());
+
+    if (!sketch.Shares(seqr)) {
+      ++skipped;
+      continue;
+    }
+
+    svabaRead i = read;
+    SeqLib::BamRecordVector brv, brv_ref;
     
     bool hardclip = false;
-    assert(seqr.length());
     bw.AlignSequence(seqr, i.Qname(), brv, hardclip, 0.60, 10000);
 
     if (brv.size() == 0) 
@@ -1420,6 +1660,24 @@ void alignReadsToContigs(SeqLib::BWAWrapper& bw, const SeqLib::UnalignedSequence
       
     } // end passing bwa-aligned read loop 
   } // end main read loop
+
+  return skipped;
+}
+
+bool can_split(const SeqLib::GenomicRegion& region, int split_level) {
+  return opt::adaptive_split && work_queue && !region.IsEmpty() && 
+    split_level < SUBWINDOW_MAX_DEPTH && region.Width() >= 2 * SUBWINDOW_MIN_WIDTH;
+}
+
+void schedule_subwindows(const SeqLib::GenomicRegion& region, int split_level) {
+
+  // two halves that overlap the same way the full windows do, so
+  // events at the split point are still assembled in one of them
+  int pad = std::min(WINDOW_PAD, region.Width() / 4);
+  int mid = region.pos1 + region.Width() / 2;
+  work_queue->add(new svabaWorkItem(SeqLib::GenomicRegion(region.chr, region.pos1, mid + pad / 2), 0, split_level + 1));
+  work_queue->add(new svabaWorkItem(SeqLib::GenomicRegion(region.chr, mid - pad / 2, region.pos2), 0, split_level + 1));
+
 }
 
 void set_walker_params(svabaBamWalker& walk) {
@@ -1443,6 +1701,8 @@ CountPair run_mate_collection_loop(const SeqLib::GenomicRegion& region, WalkerMa
 
   MateRegionVector all_somatic_mate_regions;
   all_somatic_mate_regions.add(MateRegion(region.chr, region.pos1, region.pos2)); // add the origional, don't want to double back
+  all_somatic_mate_regions.CreateTreeMap();
+  size_t num_visited = all_somatic_mate_regions.size();
   
   for (int jjj = 0; jjj <  MAX_MATE_ROUNDS; ++jjj) {
     
@@ -1472,22 +1732,26 @@ CountPair run_mate_collection_loop(const SeqLib::GenomicRegion& region, WalkerMa
 	continue;
 
       // new region overlaps with one already seen from another round
-      for (auto& ss : all_somatic_mate_regions) 
-	if (s.GetOverlap(ss)) 
-	  continue;
+      if (all_somatic_mate_regions.CountOverlaps(s))
+	continue;
       
       if (s.count > opt::mate_lookup_min * 2 || (jjj == 0)) { // be more strict about higher rounds and inter-chr
 	somatic_mate_regions.add(s);
-	all_somatic_mate_regions.add(s);
+	++num_visited;
       }
       
       // don't add too many regions
-      if (all_somatic_mate_regions.size() > MAX_NUM_MATE_WINDOWS) {
-	all_somatic_mate_regions.clear(); // its a bad region. Don't even look up any
+      if (num_visited > MAX_NUM_MATE_WINDOWS) {
+	somatic_mate_regions.clear(); // its a bad region. Don't even look up any
 	break;
       }
 
     }
+
+    // add this round to the visited regions. The candidates in a round are 
+    // merged, so they only need checking against earlier rounds
+    all_somatic_mate_regions.Concat(somatic_mate_regions);
+    all_somatic_mate_regions.CreateTreeMap();
     
     // print out to log
     for (auto& i : somatic_mate_regions) 
@@ -1587,26 +1851,91 @@ void remove_hardclips(svabaReadVector& brv) {
   brv = bav_tmp;
 }
 
-void run_assembly(const SeqLib::GenomicRegion& region, svabaReadVector& bav_this, std::vector<AlignedContig>& master_alc, 
-		  SeqLib::BamRecordVector& master_contigs, SeqLib::BamRecordVector& master_microbial_contigs, DiscordantClusterMap& dmap,
-		  std::unordered_map<std::string, SeqLib::CigarMap>& cigmap, SeqLib::RefGenome* refg) {
+#ifdef BENCH_ASSEMBLER
+// is seq, or its reverse complement, part of one of the contigs of cc?
+static bool containedIn(const std::string& seq, const SeqLib::UnalignedSequenceVector& cc) {
+  std::string rc = seq;
+  SeqLib::rcomplement(rc);
+  for (auto& c : cc)
+    if (c.Seq.find(seq) != std::string::npos || c.Seq.find(rc) != std::string::npos)
+      return true;
+  return false;
+}
 
-  // get the local region
-  std::string lregion;
-  if (!region.IsEmpty()) {
-    try {
-      lregion = refg->QueryRegion(bwa_header.IDtoName(region.chr), region.pos1, region.pos2);
-    } catch (...) {
-      WRITELOG(" Caught exception for lregion with reg " + region.ToString(bwa_header), true, true);
-      lregion = "";
+// assemble a window with both SGA and fermi-lite. For the contigs long enough to be
+// aligned, and the ones without an unclipped local alignment (the SV candidates), 
+// count how many of each assembler's are contained in the other's contigs
+static void benchmarkAssemblers(const std::string& name, svabaReadVector& bav_this, LocalRefAligner& local_aligner) {
+
+  SeqLib::UnalignedSequenceVector contigs[2];
+  double secs[2];
+  for (int a = 0; a < 2; ++a) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if (a == 0) {
+      svabaAssemblerEngine engine(name, opt::sga::error_rate, opt::sga::minOverlap, readlen);
+      engine.fillReadTable(bav_this);
+      engine.performAssembly(opt::sga::num_assembly_rounds);
+      contigs[a] = engine.getContigs();
+    } else {
+      svabaFermiAssemblerEngine engine(name, opt::sga::minOverlap);
+      engine.fillReadTable(bav_this);
+      engine.performAssembly();
+      contigs[a] = engine.getContigs();
     }
+    secs[a] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
   }
 
-  // make a BWA wrapper from the locally retrieved sequence
-  SeqLib::UnalignedSequenceVector local_usv = {{"local", lregion, std::string()}};
-  SeqLib::BWAWrapper local_bwa;
-  if (local_usv[0].Seq.length() > 200) // have to have pulled some ref sequence
-    local_bwa.ConstructIndex(local_usv);
+  size_t n[2] = {0, 0}, found[2] = {0, 0}, sv[2] = {0, 0}, sv_found[2] = {0, 0};
+  for (int a = 0; a < 2; ++a) {
+    for (auto& c : contigs[a]) {
+      if ((int)c.Seq.length() < (readlen * 1.15))
+	continue;
+      bool in_other = containedIn(c.Seq, contigs[1 - a]);
+      ++n[a];
+      found[a] += in_other;
+      int local_score = 0, local_clip = 0;
+      bool has_local = !local_aligner.IsEmpty() && local_aligner.Align(c.Seq, local_score, local_clip);
+      if (!has_local || local_clip >= MIN_CLIP_FOR_LOCAL) {
+	++sv[a];
+	sv_found[a] += in_other;
+      }
+    }
+  }
+
+  std::stringstream out;
+  out << "BENCH_ASSEMBLER " << name << " reads " << bav_this.size() 
+      << " sga " << secs[0] << "s " << n[0] << " contigs (" << found[0] << " in fml) " << sv[0] << " SV (" << sv_found[0] << " in fml)"
+      << " fml " << secs[1] << "s " << n[1] << " contigs (" << found[1] << " in sga) " << sv[1] << " SV (" << sv_found[1] << " in sga)";
+  WRITELOG(out.str(), true, true);
+}
+#endif
+
+// count the novel k-mers of a window's reads, not in its reference (or, for somatic, in
+// the normal reads), that are carried by enough reads not to be sequencing errors
+size_t count_novel_kmers(const std::string& ref, const svabaReadVector& bav_this, bool somatic) {
+
+  svabaUtils::NovelKmerCounter counter(TRIAGE_K);
+  counter.addKnown(ref);
+  if (somatic)
+    for (auto& r : bav_this)
+      if (!r.Tumor())
+	counter.addKnown(r.Seq());
+  counter.finalize();
+
+  for (auto& r : bav_this)
+    if (!somatic || r.Tumor())
+      counter.addRead(r.Seq());
+  return counter.Supported(TRIAGE_MIN_KMER_READS);
+}
+
+void run_assembly(const SeqLib::GenomicRegion& region, const std::string& lregion, svabaReadVector& bav_this, std::vector<AlignedContig>& master_alc, 
+		  SeqLib::BamRecordVector& master_contigs, SeqLib::BamRecordVector& master_microbial_contigs, DiscordantClusterMap& dmap,
+		  std::unordered_map<std::string, IndelCigarMap>& cigmap, SeqLib::RefGenome* refg) {
+
+  // set up the local aligner from the locally retrieved sequence. One per
+  // thread, so no index is built and no buffers allocated per window
+  static thread_local LocalRefAligner local_aligner;
+  local_aligner.SetRegion(lregion.length() > 200 ? lregion : std::string()); // have to have pulled some ref sequence
 
   std::stringstream region_string;
   region_string << region;
@@ -1618,18 +1947,52 @@ void run_assembly(const SeqLib::GenomicRegion& region, svabaReadVector& bav_this
   // where to store contigs
   SeqLib::UnalignedSequenceVector all_contigs_this;
   
-  // setup the engine
-  svabaAssemblerEngine engine(name, opt::sga::error_rate, opt::sga::minOverlap, readlen);
-  if (opt::sga::writeASQG)
-    engine.setToWriteASQG();
-  engine.fillReadTable(bav_this);
+#ifdef BENCH_ASSEMBLER
+  benchmarkAssemblers(name, bav_this, local_aligner);
+#endif
+
+  if (opt::assembler == "fml") {
+
+    // fermi-lite, one round with its own error correction
+    svabaFermiAssemblerEngine engine(name, opt::sga::minOverlap);
+    engine.fillReadTable(bav_this);
+
+    AssemblyKey assembly_key = engine.fingerprint();
+    if (assembly_cache.Find(assembly_key, name, all_contigs_this)) {
+      WRITELOG("...reused " + std::to_string(all_contigs_this.size()) + " cached contigs for " + name, opt::verbose > 1, true);
+    } else {
+      engine.performAssembly();
+      all_contigs_this = engine.getContigs();
+      assembly_cache.Insert(assembly_key, name, all_contigs_this);
+      WRITELOG("...assembled " + std::to_string(all_contigs_this.size()) + " fermi-lite contigs for " + name, opt::verbose > 1, true);
+    }
+
+  } else {
+
+    // setup the engine
+    svabaAssemblerEngine engine(name, opt::sga::error_rate, opt::sga::minOverlap, readlen);
+    if (opt::sga::writeASQG)
+      engine.setToWriteASQG();
+    engine.fillReadTable(bav_this);
+    engine.setTaskPool(task_pool);
   
-  // do the actual assembly
-  engine.performAssembly(opt::sga::num_assembly_rounds);
+    // reuse the contigs if these exact reads were already assembled (ASQG output needs the graph)
+    AssemblyKey assembly_key = engine.fingerprint(opt::sga::num_assembly_rounds);
+    if (!opt::sga::writeASQG && assembly_cache.Find(assembly_key, name, all_contigs_this)) {
+      WRITELOG("...reused " + std::to_string(all_contigs_this.size()) + " cached contigs for " + name, opt::verbose > 1, true);
+    } else {
+
+      // do the actual assembly
+      engine.performAssembly(opt::sga::num_assembly_rounds);
   
-  // retrieve contigs
-  all_contigs_this = engine.getContigs();
-  WRITELOG("...assembled " + std::to_string(all_contigs_this.size()) + " contigs for " + name, opt::verbose > 1, true);
+      // retrieve contigs
+      all_contigs_this = engine.getContigs();
+      assembly_cache.Insert(assembly_key, name, all_contigs_this);
+      WRITELOG("...assembled " + std::to_string(all_contigs_this.size()) + " contigs for " + name +
+	       " (index build " + std::to_string(engine.getIndexSeconds()) + "s)", opt::verbose > 1, true);
+    }
+
+  }
 
   // store the aligned contig struct
   std::vector<AlignedContig> this_alc;
@@ -1638,57 +2001,76 @@ void run_assembly(const SeqLib::GenomicRegion& region, svabaReadVector& bav_this
   WRITELOG("...aliging contigs to genome", opt::verbose > 1, false);
 
   SeqLib::UnalignedSequenceVector usv;
+
+  // the BWA alignments of each contig fill their own slots, so that a large 
+  // window can spread them over the task pool. The rest is done in order below
+  std::vector<SeqLib::BamRecordVector> genome_alignments(all_contigs_this.size()), microbe_alignments(all_contigs_this.size());
+  auto alignContig = [&](size_t k) {
+    const SeqLib::UnalignedSequence& i = all_contigs_this[k];
+
+    // if too short, skip
+    if ((int)i.Seq.length() < (readlen * 1.15) && !opt::all_contigs)
+      return;
+
+    // do the main realignment
+    bool hardclip = false;	
+    main_bwa->AlignSequence(i.Seq, i.Name, genome_alignments[k], hardclip, SECONDARY_FRAC, SECONDARY_CAP);	
+
+    // skip contigs with no k-mer in the microbe genomes, as BWA has nothing to seed there
+    bool microbe_candidate = microbe_bwa && !svabaUtils::hasRepeat(i.Seq);
+    if (microbe_candidate && microbe_bloom) {
+      ++microbe_screened;
+      microbe_candidate = microbe_bloom->Hits(i.Seq, MICROBE_BLOOM_MIN_HITS) >= MICROBE_BLOOM_MIN_HITS;
+    }
+
+    // do the microbial alignment
+    if (microbe_candidate) {
+      microbe_bwa->AlignSequence(i.Seq, i.Name, microbe_alignments[k], hardclip, SECONDARY_FRAC, SECONDARY_CAP);
+      ++microbe_aligned;
+      if (microbe_alignments[k].size())
+	++microbe_aligned_hit;
+    }
+  };
+  if (task_pool && bav_this.size() >= PARALLEL_WINDOW_MIN_READS)
+    task_pool->parallelFor(all_contigs_this.size(), alignContig);
+  else
+    for (size_t k = 0; k < all_contigs_this.size(); ++k)
+      alignContig(k);
   
-  for (auto& i : all_contigs_this) {
+  for (size_t k = 0; k < all_contigs_this.size(); ++k) {
+
+    const SeqLib::UnalignedSequence& i = all_contigs_this[k];
     
     // if too short, skip
     if ((int)i.Seq.length() < (readlen * 1.15) && !opt::all_contigs)
       continue;
     
-    bool hardclip = false;	
-
     //// LOCAL REALIGNMENT
     // align to the local region
-    SeqLib::BamRecordVector local_ct_alignments;
-    if (!local_bwa.IsEmpty())
-      local_bwa.AlignSequence(i.Seq, i.Name, local_ct_alignments, hardclip, SECONDARY_FRAC, SECONDARY_CAP);
+    int local_score = 0, local_clip = 0;
+    bool has_local = !local_aligner.IsEmpty() && local_aligner.Align(i.Seq, local_score, local_clip);
     
     // check if it has a non-local alignment
     bool valid_sv = true;
-    for (auto& aa : local_ct_alignments) {
-      if (aa.NumClip() < MIN_CLIP_FOR_LOCAL) // || aa.GetIntTag("NM") < MAX_NM_FOR_LOCAL)
-	valid_sv = false; // has a non-clipped local alignment. can't be SV. Indel only
-    }
+    if (has_local && local_clip < MIN_CLIP_FOR_LOCAL) // || aa.GetIntTag("NM") < MAX_NM_FOR_LOCAL)
+      valid_sv = false; // has a non-clipped local alignment. can't be SV. Indel only
     ////////////
     
-    // do the main realignment
-    SeqLib::BamRecordVector ct_alignments;
-    main_bwa->AlignSequence(i.Seq, i.Name, ct_alignments, hardclip, SECONDARY_FRAC, SECONDARY_CAP);	
+    SeqLib::BamRecordVector& ct_alignments = genome_alignments[k];
 
     if (opt::verbose > 3)
       for (auto& i : ct_alignments)
 	std::cerr << " aligned contig: " << i << std::endl;
     
-    // do the microbe realigenment
+    // keep only long microbe alignments with decent mapq
     SeqLib::BamRecordVector ct_plus_microbe;
-
-    if (microbe_bwa && !svabaUtils::hasRepeat(i.Seq)) {
-      
-      // do the microbial alignment
-      SeqLib::BamRecordVector microbial_alignments;
-      bool hardclip = false;
-      microbe_bwa->AlignSequence(i.Seq, i.Name, microbial_alignments, hardclip, SECONDARY_FRAC, SECONDARY_CAP);
-      
-      // if the microbe alignment is large enough and doesn't overlap human...
-      for (auto& j : microbial_alignments) {
-	// keep only long microbe alignments with decent mapq
-	if (j.NumMatchBases() >= MICROBE_MATCH_MIN && j.MapQuality() >= 10) { 
-	  if (svabaUtils::overlapSize(j, ct_alignments) <= 20) { // keep only those where most do not overlap human
-	    assert(microbe_bwa->ChrIDToName(j.ChrID()).length());
-	    j.AddZTag("MC", microbe_bwa->ChrIDToName(j.ChrID()));
-	    master_microbial_contigs.push_back(j);
-	    ct_plus_microbe.push_back(j);
-	  }
+    for (auto& j : microbe_alignments[k]) {
+      if (j.NumMatchBases() >= MICROBE_MATCH_MIN && j.MapQuality() >= 10) { 
+	if (svabaUtils::overlapSize(j, ct_alignments) <= 20) { // keep only those where most do not overlap human
+	  assert(microbe_bwa->ChrIDToName(j.ChrID()).length());
+	  j.AddZTag("MC", microbe_bwa->ChrIDToName(j.ChrID()));
+	  master_microbial_contigs.push_back(j);
+	  ct_plus_microbe.push_back(j);
 	}
       }
     }
@@ -1764,7 +2146,10 @@ void run_assembly(const SeqLib::GenomicRegion& region, svabaReadVector& bav_this
   
   if (opt::verbose > 3)
     std::cerr << "...aligning " << bav_this.size() << " reads to " << this_alc.size() << " contigs " << std::endl;
-  alignReadsToContigs(bw, usv, bav_this, this_alc, refg);
+  size_t align_skipped = alignReadsToContigs(bw, usv, bav_this, this_alc, refg);
+  if (opt::verbose > 3)
+    std::cerr << "...aligned " << (bav_this.size() - align_skipped) << " reads, skipped " << align_skipped 
+	      << " sharing no " << ALIGN_PREFILTER_K << "-mer with a contig" << std::endl;
   
   // Get contig coverage, discordant matching to contigs, etc
   for (auto& a : this_alc) {
@@ -1793,16 +2178,30 @@ CountPair collect_mate_reads(WalkerMap& walkers, const MateRegionVector& mrv, in
 
   if (!mrv.size())
     return counts;
-  
+
+  // convert MateRegionVector to GRC
+  SeqLib::GRC gg;
+  for (auto& s : mrv) 
+    gg.add(SeqLib::GenomicRegion(s.chr, s.pos1, s.pos2, s.strand));
+
   for (auto& w : walkers) {
 
     int oreads = w.second.reads.size();
     w.second.m_limit = opt::mate_region_lookup_limit;
 
-    // convert MateRegionVector to GRC
-    SeqLib::GRC gg;
-    for (auto& s : mrv) 
-      gg.add(SeqLib::GenomicRegion(s.chr, s.pos1, s.pos2, s.strand));
+    // get the reads through the shared fetch service, which batches 
+    // them with the lookups from windows on other threads
+    MateFetchResult fetched;
+    mate_fetcher.Fetch(w.first, gg, fetched);
+    WRITELOG("\tmate lookup " + w.first + ": " + std::to_string(gg.size()) + " regions, " + 
+	     std::to_string(fetched.seeks) + " seeks shared by " + std::to_string(fetched.batch) + " requests, " + 
+	     SeqLib::AddCommas(fetched.record_bytes) + " bytes of records", opt::verbose > 2, true);
+
+    // regions too deep to read fully are bad mate regions, as for the walker's read limit
+    for (auto& t : fetched.truncated)
+      WRITELOG("\tstopping mate lookup for " + w.first + " in " + t.ToString(bwa_header) + " at " + 
+	       SeqLib::AddCommas(MATE_FETCH_MAX_RECORDS) + " records", opt::verbose > 1, true);
+    this_bad_mate_regions.Concat(fetched.truncated);
 
     assert(w.second.SetMultipleRegions(gg));
     w.second.get_coverage = false;
@@ -1812,7 +2211,9 @@ CountPair collect_mate_reads(WalkerMap& walkers, const MateRegionVector& mrv, in
     // already added these to the to-do pile
     w.second.mate_regions.clear();
 
+    w.second.m_feed = &fetched;
     this_bad_mate_regions.Concat(w.second.readBam(&log_file)); 
+    w.second.m_feed = nullptr;
     
     // update the counts
     if (w.first.at(0) == 't') 
@@ -1821,6 +2222,7 @@ CountPair collect_mate_reads(WalkerMap& walkers, const MateRegionVector& mrv, in
       counts.second += (w.second.reads.size() - oreads);
 
   }
+
   
   return counts;
 }
@@ -1881,8 +2283,8 @@ void WriteFilesOut(svabaThreadUnit& wu) {
 
   // send breakpoints to file
   for (auto& i : wu.m_bps) {
-    if ( i.hasMinimal() && (i.confidence != "NOLOCAL" || i.complex_local))
-      os_allbps << i.toFileString(!opt::read_tracking) << std::endl;
+    if ( i.hasMinimal() && (i.confidence != CONF_NOLOCAL || i.complex_local))
+      bps_writer.Write(i, !opt::read_tracking);
   }
 
   // clear them out
@@ -19,6 +19,7 @@
 #include "svabaUtils.h"
 #include "AlignedContig.h"
 #include "svabaBamWalker.h"
+#include "MateFetchService.h"
 #include "DiscordantCluster.h"
 #include "svabaAssemblerEngine.h"
 
@@ -40,17 +41,22 @@ void runsvaba(int argc, char** argv);
 void learnParameters(const SeqLib::GRC& regions);
 int countJobs(SeqLib::GRC &file_regions, SeqLib::GRC &run_regions);
 void sendThreads(SeqLib::GRC& regions_torun);
-bool runWorkItem(const SeqLib::GenomicRegion& region, svabaThreadUnit& wu, long unsigned int thread_id);
+bool runWorkItem(const SeqLib::GenomicRegion& region, svabaThreadUnit& wu, long unsigned int thread_id, int split_level = 0);
+
+bool can_split(const SeqLib::GenomicRegion& region, int split_level);
+
+void schedule_subwindows(const SeqLib::GenomicRegion& region, int split_level);
 SeqLib::GRC makeAssemblyRegions(const SeqLib::GenomicRegion& region);
-void alignReadsToContigs(SeqLib::BWAWrapper& bw, const SeqLib::UnalignedSequenceVector& usv, SeqLib::BamRecordVector& bav_this, std::vector<AlignedContig>& this_alc, const SeqLib::RefGenome * rg);
+size_t alignReadsToContigs(SeqLib::BWAWrapper& bw, const SeqLib::UnalignedSequenceVector& usv, svabaReadVector& bav_this, std::vector<AlignedContig>& this_alc, const SeqLib::RefGenome * rg);
 void set_walker_params(svabaBamWalker& walk);
 MateRegionVector __collect_normal_mate_regions(WalkerMap& walkers);
 MateRegionVector __collect_somatic_mate_regions(WalkerMap& walkers, MateRegionVector& bl);
 SeqLib::GRC __get_exclude_on_badness(std::map<std::string, svabaBamWalker>& walkers, const SeqLib::GenomicRegion& region);
 void correct_reads(std::vector<char*>& learn_seqs, svabaReadVector& brv);
-void run_assembly(const SeqLib::GenomicRegion& region, svabaReadVector& bav_this, std::vector<AlignedContig>& master_alc, 
+size_t count_novel_kmers(const std::string& ref, const svabaReadVector& bav_this, bool somatic);
+void run_assembly(const SeqLib::GenomicRegion& region, const std::string& lregion, svabaReadVector& bav_this, std::vector<AlignedContig>& master_alc, 
 		  SeqLib::BamRecordVector& master_contigs, SeqLib::BamRecordVector& master_microbial_contigs, DiscordantClusterMap& dmap,
-		  std::unordered_map<std::string, SeqLib::CigarMap>& cigmap, SeqLib::RefGenome* refg);
+		  std::unordered_map<std::string, IndelCigarMap>& cigmap, SeqLib::RefGenome* refg);
 void remove_hardclips(svabaReadVector& brv);
 CountPair collect_mate_reads(WalkerMap& walkers, const MateRegionVector& mrv, int round, SeqLib::GRC& this_bad_mate_regions);
 CountPair run_mate_collection_loop(const SeqLib::GenomicRegion& region, WalkerMap& wmap, SeqLib::GRC& badd);
@@ -63,16 +69,17 @@ class svabaWorkItem {
  private:
   SeqLib::GenomicRegion m_gr;
   int m_number;  
+  int m_split; // how many times this was split from a full window
 
  public:
-  svabaWorkItem(const SeqLib::GenomicRegion& gr, int number)  
-    : m_gr(gr), m_number(number) {}
+  svabaWorkItem(const SeqLib::GenomicRegion& gr, int number, int split = 0)  
+    : m_gr(gr), m_number(number), m_split(split) {}
     ~svabaWorkItem() {}
     
     int getNumber() { return m_number; }
     
     bool run(svabaThreadUnit& wu, long unsigned int thread_id) { 
-      return runWorkItem(m_gr, wu, thread_id);
+      return runWorkItem(m_gr, wu, thread_id, m_split);
     }
 };
 
@@ -11,6 +11,8 @@
 
 #include "refilter.h"
 #include "run_svaba.h"
+#include "DBSnpFilter.h"
+#include "PONFilter.h"
 
 #define AUTHOR "Jeremiah Wala <jeremiah.wala@gmail.com"
 
@@ -25,6 +27,9 @@ static const char *SVABA_USAGE_MESSAGE =
 "Commands:\n"
 "           run            Run SvABA SV and Indel detection on BAM(s)\n"
 "           refilter       Refilter the SvABA breakpoints with additional/different criteria to created filtered VCF and breakpoints file.\n"
+"           export-bps     Write the binary breakpoints file (bps.bin) as text (bps.txt.gz)\n"
+"           index-dbsnp    Index a dbSNP VCF once for fast indel lookups with -D\n"
+"           index-pon      Index a panel of normals once for fast, shared lookups\n"
 "\nReport bugs to jwala@broadinstitute.org \n\n";
 
 int main(int argc, char** argv) {
@@ -41,6 +46,12 @@ int main(int argc, char** argv) {
       runsvaba(argc -1, argv + 1);
     } else if (command == "refilter") {
       runRefilterBreakpoints(argc-1, argv+1);
+    } else if (command == "export-bps") {
+      runExportBreakPoints(argc-1, argv+1);
+    } else if (command == "index-dbsnp") {
+      runIndexDBSnp(argc-1, argv+1);
+    } else if (command == "index-pon") {
+      runIndexPON(argc-1, argv+1);
     }
     else {
       std::cerr << SVABA_USAGE_MESSAGE;
@@ -18,6 +18,7 @@
 #include <unistd.h>
 #include <string>
 #include "SGSearch.h"
+#include "SGIncrementalSimplifier.h"
 
 //#define DEBUG_ASSEMBLY 1
 
@@ -45,18 +46,21 @@ StringGraph* assemble(std::stringstream& asqg_stream, int minOverlap, int maxEdg
   SGContainRemoveVisitor containVisit;
   SGValidateStructureVisitor validationVisit;
   
-  while(pGraph->hasContainment())
-    pGraph->visit(containVisit);
+  // Each step only visits the vertices that changed since it last ran,
+  // in the order of a visitor pass, so the contigs are the same
+  SGIncrementalSimplifier simplifier(pGraph);
+  simplifier.removeContainments(containVisit);
 
   // Remove any extraneous transitive edges that may remain in the graph
   if(bPerformTR)
     {
       std::cout << "Removing transitive edges\n";
       pGraph->visit(trVisit);
+      simplifier.touchAll();
     }
   
   // Compact together unbranched chains of vertices
-  pGraph->simplify();
+  simplifier.simplify();
   
   if(bValidate)
     {
@@ -67,7 +71,7 @@ StringGraph* assemble(std::stringstream& asqg_stream, int minOverlap, int maxEdg
   if(numTrimRounds > 0) {
       int numTrims = numTrimRounds;
       while(numTrims-- > 0)
-	pGraph->visit(trimVisit);
+	simplifier.trim(trimVisit);
     }
   
   // Resolve small repeats
@@ -80,10 +84,15 @@ StringGraph* assemble(std::stringstream& asqg_stream, int minOverlap, int maxEdg
       SGSmoothingVisitor smoothingVisit(ao.outVariantsFile, maxBubbleGapDivergence, maxBubbleDivergence, maxIndelLength);
       int numSmooth = numBubbleRounds;
       while(numSmooth-- > 0)
-	pGraph->visit(smoothingVisit);
-      pGraph->simplify(); 
+	simplifier.smooth(smoothingVisit);
+      simplifier.simplify(); 
     }
 
+#ifdef DEBUG_ASSEMBLY
+  std::cerr << "simplification of " << prefix << std::endl;
+  simplifier.printCounters(std::cerr);
+#endif
+
   pGraph->renameVertices(prefix);
 
   SGVisitorContig av;
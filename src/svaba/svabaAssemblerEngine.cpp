@@ -3,17 +3,113 @@
 
 #include <map>
 #include <algorithm>
+#include <cstring>
+#include <chrono>
 
 #include "SGACommon.h"
 
 #include "svabaASQG.h"
 #include "svabaAssemble.h"
 #include "svabaOverlapAlgorithm.h"
+#include "svabaTaskPool.h"
 
 #include "OverlapCommon.h"
+#include "SACAInducedSort.h"
+#include "SACAInducedCopying.h"
 #include "CorrectionThresholds.h"
 
 //#define DEBUG_ENGINE 1
+//#define BENCH_BWT 1 // time the overlap search on the packed BWT against an RLBWT for each assembly
+//#define BENCH_OVERLAP 1 // time batched against per-read overlap for each assembly
+//#define VALIDATE_SAIS 1 // check the SA-IS suffix arrays of each index against induced copying
+
+#if defined(BENCH_BWT) && !defined(SGA_RLBWT)
+// overlap every read against the window's reads with both BWT backends, and print the times
+static void benchmarkBWT(const std::string& id, const PackedReadTable * pRT, const SuffixArray * pSAf, const SuffixArray * pSAr,
+			 double errorRate, int seedLength, int seedStride, int min_overlap) {
+
+  double secs[2];
+  std::string hits[2];
+  for (int packed = 0; packed < 2; ++packed) {
+
+    size_t max_packed = packed ? PackedBWT::DEFAULT_MAX_PACKED_SYMBOLS : 0; // 0 stores an RLBWT
+    PackedBWT f(pSAf, pRT->getView(), max_packed);
+    PackedBWT r(pSAr, pRT->getView(true), max_packed);
+
+    bool exact = errorRate < 0.001f;
+    svabaOverlapAlgorithm ov(&f, &r, errorRate, seedLength, seedStride, true);
+    ov.setExactModeOverlap(exact);
+    ov.setExactModeIrreducible(exact);
+
+    std::stringstream hits_stream;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < pRT->getCount(); ++i) {
+      SeqRecord read;
+      read.id = pRT->getReadID(i);
+      read.seq = pRT->getSequence(i);
+      OverlapBlockList obl;
+      OverlapResult rr = ov.overlapRead(read, min_overlap, &obl);
+      ov.writeOverlapBlocks(hits_stream, i, rr.isSubstring, &obl);
+    }
+    secs[packed] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    hits[packed] = hits_stream.str();
+  }
+
+  std::cerr << "BENCH_BWT " << id << " reads " << pRT->getCount() << " symbols " << pSAf->getSize()
+	    << " RLBWT " << secs[0] << "s packed " << secs[1] << "s speedup " << (secs[1] > 0 ? secs[0] / secs[1] : 0)
+	    << (hits[0] == hits[1] ? "" : " HITS DIFFER") << std::endl;
+}
+#endif
+
+#ifdef BENCH_OVERLAP
+// overlap every read of the window one at a time and in batches, and print the throughput
+static void benchmarkOverlap(const std::string& id, const PackedReadTable * pRT, const BWT * pBWT, const BWT * pRBWT, bool exact,
+			     double errorRate, int seedLength, int seedStride, int min_overlap) {
+
+  svabaOverlapAlgorithm ov(pBWT, pRBWT, errorRate, seedLength, seedStride, true);
+  ov.setExactModeOverlap(exact);
+  ov.setExactModeIrreducible(exact);
+
+  SeqRecordVector reads(pRT->getCount());
+  for (size_t i = 0; i < reads.size(); ++i) {
+    reads[i].id = pRT->getReadID(i);
+    reads[i].seq = pRT->getSequence(i);
+  }
+
+  double secs[2];
+  std::string hits[2];
+  size_t blocks = 0;
+  for (int batched = 0; batched < 2; ++batched) {
+    std::stringstream hits_stream;
+    auto start = std::chrono::steady_clock::now();
+    if (batched) {
+      std::vector<OverlapBlockList> obl;
+      std::vector<OverlapResult> rr;
+      for (size_t i = 0; i < reads.size(); i += OVERLAP_BATCH_READS) {
+	SeqRecordVector batch(reads.begin() + i, reads.begin() + std::min(reads.size(), i + OVERLAP_BATCH_READS));
+	ov.overlapReads(batch, min_overlap, obl, rr);
+	for (size_t j = 0; j < batch.size(); ++j)
+	  ov.writeOverlapBlocks(hits_stream, i + j, rr[j].isSubstring, &obl[j]);
+      }
+    } else {
+      for (size_t i = 0; i < reads.size(); ++i) {
+	OverlapBlockList obl;
+	OverlapResult rr = ov.overlapRead(reads[i], min_overlap, &obl);
+	ov.writeOverlapBlocks(hits_stream, i, rr.isSubstring, &obl);
+	blocks += obl.size();
+      }
+    }
+    secs[batched] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    hits[batched] = hits_stream.str();
+  }
+
+  std::cerr << "BENCH_OVERLAP " << id << " reads " << reads.size() << " blocks " << blocks
+	    << " per-read " << secs[0] << "s (" << (secs[0] > 0 ? blocks / secs[0] : 0) << " blocks/s)"
+	    << " batched " << secs[1] << "s (" << (secs[1] > 0 ? blocks / secs[1] : 0) << " blocks/s)"
+	    << " speedup " << (secs[1] > 0 ? secs[0] / secs[1] : 0)
+	    << (hits[0] == hits[1] ? "" : " HITS DIFFER") << std::endl;
+}
+#endif
 
 static std::string POLYA = "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAA";
 static std::string POLYT = "TTTTTTTTTTTTTTTTTTTTTTTTTTTTTT";
@@ -34,13 +130,8 @@ void svabaAssemblerEngine::fillReadTable(const std::vector<std::string>& r) {
     if (i.length() < m_min_overlap)
       continue;
     
-    SeqItem si;
-    
     assert(i.length() && i.length() >= m_min_overlap);
-    si.id = "read_" + std::to_string(++count); 
-    si.seq = i;
-    
-    m_pRT.addRead(si);
+    m_pRT.addRead("read_" + std::to_string(++count), i.data(), i.length());
     
   }
   
@@ -53,48 +144,54 @@ void svabaAssemblerEngine::fillReadTable(svabaReadVector& r) {
   // make the reads tables
   for (auto& i : r) {
     
-    // get the sequence and unique ID
+    // get the sequence and unique ID. The sequence is packed
+    // straight from the read's (corrected) buffer
     std::string sr = std::to_string(++count);
-    std::string seq = i.Seq();
+    std::string unset;
+    const char* seq = i.SeqData();
+    if (!seq) {
+      unset = i.Seq();
+      seq = unset.c_str();
+    }
+    size_t len = strlen(seq);
     assert(sr.length());
-    assert(seq.length());
+    assert(len);
 
-    if (hasRepeat(seq) || seq.length() < m_min_overlap)
+    if (hasRepeat(seq, len) || len < m_min_overlap)
       continue;
 
     // put onto the foward strand if not
-    if (!i.MappedFlag() && !i.MateReverseFlag())
-      SeqLib::rcomplement(seq);
-
-    SeqItem si;
-    si.id = sr;
-    si.seq = seq;
-    m_pRT.addRead(si);
+    m_pRT.addRead(sr, seq, len, !i.MappedFlag() && !i.MateReverseFlag());
 
   }
   
 }
 
+AssemblyKey svabaAssemblerEngine::fingerprint(int num_assembly_rounds) const {
+
+  AssemblyFingerprint fp;
+  for (size_t i = 0; i < m_pRT.getCount(); ++i)
+    fp.add(m_pRT.getSequence(i));
+  return fp.key(m_error_rate, m_min_overlap, m_readlen, num_assembly_rounds);
+
+}
+
 bool svabaAssemblerEngine::hasRepeat(const std::string& seq) {
+  return hasRepeat(seq.data(), seq.length());
+}
 
-  if (seq.find("N") != std::string::npos)
+bool svabaAssemblerEngine::hasRepeat(const char* seq, size_t len) {
+
+  const char* end = seq + len;
+  if (std::find(seq, end, 'N') != end)
     return true;
-  if (seq.length() < 40)
-    return false;
-  if ((seq.find(POLYT) == std::string::npos) && 
-      (seq.find(POLYA) == std::string::npos) && 
-      (seq.find(POLYC) == std::string::npos) && 
-      (seq.find(POLYG) == std::string::npos) && 
-      (seq.find(POLYCG) == std::string::npos) && 
-      (seq.find(POLYAT) == std::string::npos) && 
-      (seq.find(POLYTC) == std::string::npos) && 
-      (seq.find(POLYAG) == std::string::npos) && 
-      (seq.find(POLYCA) == std::string::npos) && 
-      (seq.find(POLYTG) == std::string::npos) && 
-      (seq.find("N") == std::string::npos))
+  if (len < 40)
     return false;
+  for (const std::string* p : {&POLYT, &POLYA, &POLYC, &POLYG, &POLYCG, &POLYAT, &POLYTC, &POLYAG, &POLYCA, &POLYTG})
+    if (std::search(seq, end, p->begin(), p->end()) != end)
+      return true;
   
-  return true;
+  return false;
 
 }
 
@@ -132,7 +229,9 @@ bool svabaAssemblerEngine::performAssembly(int num_assembly_rounds)
       if (j.Seq.length() > m_readlen)
 	tmpc.push_back(j);
     
-    ReadTable pRTc0(tmpc);
+    PackedReadTable pRTc0;
+    for (auto& j : tmpc)
+      pRTc0.addRead(j.Name, j.Seq.data(), j.Seq.length());
     m_contigs.clear();
     doAssembly(&pRTc0, m_contigs, yy);      
     
@@ -142,7 +241,7 @@ bool svabaAssemblerEngine::performAssembly(int num_assembly_rounds)
 
 
 // call the assembler
-void svabaAssemblerEngine::doAssembly(ReadTable *pRT, SeqLib::UnalignedSequenceVector &contigs, int pass) {
+void svabaAssemblerEngine::doAssembly(PackedReadTable *pRT, SeqLib::UnalignedSequenceVector &contigs, int pass) {
   
   if (pRT->getCount() == 0)
     return;
@@ -165,17 +264,12 @@ void svabaAssemblerEngine::doAssembly(ReadTable *pRT, SeqLib::UnalignedSequenceV
   bool exact = errorRate < 0.001f;
 
   // remove duplicates if running in exact mode
-  ReadTable * pRT_nd = exact ? removeDuplicates(pRT) : pRT;    
-
-  // forward
-  SuffixArray* pSAf_nd = new SuffixArray(pRT_nd, 1, false); //1 is num threads. false is silent/no
-  RLBWT *pBWT_nd = new RLBWT(pSAf_nd, pRT_nd);
+  PackedReadTable * pRT_nd = exact ? removeDuplicates(pRT) : pRT;    
 
-  // reverse
-  pRT_nd->reverseAll();
-  SuffixArray * pSAr_nd = new SuffixArray(pRT_nd, 1, false);
-  RLBWT *pRBWT_nd = new RLBWT(pSAr_nd, pRT_nd);
-  pRT_nd->reverseAll();
+  // forward and reverse indexes
+  SuffixArray *pSAf_nd, *pSAr_nd;
+  BWT *pBWT_nd, *pRBWT_nd;
+  buildIndex(pRT_nd, pSAf_nd, pSAr_nd, pBWT_nd, pRBWT_nd);
 
   pSAf_nd->writeIndex();
   pSAr_nd->writeIndex();
@@ -186,6 +280,14 @@ void svabaAssemblerEngine::doAssembly(ReadTable *pRT, SeqLib::UnalignedSequenceV
   if (!exact)
     calculateSeedParameters(m_readlen, min_overlap, seedLength, seedStride);
 
+#if defined(BENCH_BWT) && !defined(SGA_RLBWT)
+  benchmarkBWT(m_id, pRT_nd, pSAf_nd, pSAr_nd, errorRate, seedLength, seedStride, min_overlap);
+#endif
+
+#ifdef BENCH_OVERLAP
+  benchmarkOverlap(m_id, pRT_nd, pBWT_nd, pRBWT_nd, exact, errorRate, seedLength, seedStride, min_overlap);
+#endif
+
   svabaOverlapAlgorithm* pOverlapper = new svabaOverlapAlgorithm(pBWT_nd, pRBWT_nd, 
 								     errorRate, seedLength,
 								     seedStride, bIrreducibleOnly);
@@ -201,28 +303,45 @@ void svabaAssemblerEngine::doAssembly(ReadTable *pRT, SeqLib::UnalignedSequenceV
   headerRecord.setTransitiveTag(!bIrreducibleOnly);
   headerRecord.write(asqg_stream);    
 
-  pRT_nd->setZero();
-
   size_t workid = 0;
-  SeqItem si;
 
-  size_t ocount = 0;
-  while (pRT_nd->getRead(si) && (++ocount < MAX_OVERLAPS_PER_ASSEMBLY)) {
-    
+  // overlap the reads in batches, which interleaves their index searches
+  std::vector<SeqRecordVector> batches;
+  for (size_t k = 0; k < pRT_nd->getCount() && k + 1 < MAX_OVERLAPS_PER_ASSEMBLY; ++k) {
+    if (batches.empty() || batches.back().size() == OVERLAP_BATCH_READS)
+      batches.push_back(SeqRecordVector());
     SeqRecord read;
-    read.id = si.id;
-    read.seq = si.seq;
-    OverlapBlockList obl;
-    
-    OverlapResult rr = pOverlapper->overlapRead(read, min_overlap, &obl);
-    pOverlapper->writeOverlapBlocks(hits_stream, workid, rr.isSubstring, &obl);
-
-    svabaASQG::VertexRecord record(read.id, read.seq.toString());
-    record.setSubstringTag(rr.isSubstring);
-    record.write(asqg_stream);
-
-    ++workid;
+    read.id = pRT_nd->getReadID(k);
+    read.seq = pRT_nd->getSequence(k);
+    batches.back().push_back(read);
+  }
 
+  // the batches are independent, so a large window spreads them over the 
+  // task pool. Each fills its own slot, and they are written out in order
+  size_t num_batches = batches.size();
+  std::vector<std::vector<OverlapBlockList> > batch_blocks(num_batches);
+  std::vector<std::vector<OverlapResult> > batch_results(num_batches);
+  auto overlapBatch = [&](size_t b) {
+    pOverlapper->overlapReads(batches[b], min_overlap, batch_blocks[b], batch_results[b]);
+  };
+  if (m_pool && pRT_nd->getCount() >= PARALLEL_WINDOW_MIN_READS)
+    m_pool->parallelFor(num_batches, overlapBatch);
+  else
+    for (size_t b = 0; b < num_batches; ++b)
+      overlapBatch(b);
+
+  for (size_t b = 0; b < num_batches; ++b) {
+    for (size_t i = 0; i < batches[b].size(); ++i) {
+      pOverlapper->writeOverlapBlocks(hits_stream, workid, batch_results[b][i].isSubstring, &batch_blocks[b][i]);
+      
+      svabaASQG::VertexRecord record(batches[b][i].id, batches[b][i].seq.toString());
+      record.setSubstringTag(batch_results[b][i].isSubstring);
+      record.write(asqg_stream);
+      
+      ++workid;
+    }
+    // done with this batch
+    std::vector<OverlapBlockList>().swap(batch_blocks[b]);
   }
 
   std::string line;
@@ -284,36 +403,100 @@ void svabaAssemblerEngine::doAssembly(ReadTable *pRT, SeqLib::UnalignedSequenceV
   return;
 }
 
-// not totally sure this works...
-ReadTable* svabaAssemblerEngine::removeDuplicates(ReadTable* pRT) {
+// unpack the reads into a ReadTable, for the induced copying sort
+static void unpackReads(const PackedReadTable * pRT, ReadTable& rt) {
+  for (size_t i = 0; i < pRT->getCount(); ++i) {
+    SeqItem si;
+    si.id = pRT->getReadID(i);
+    si.seq = pRT->getSequence(i);
+    rt.addRead(si);
+  }
+}
 
-  // forward
-  SuffixArray* pSAf = new SuffixArray(pRT, 1, false); //1 is num threads. false is silent/no
-  RLBWT *pBWT= new RLBWT(pSAf, pRT);
+#ifdef VALIDATE_SAIS
+// true if two suffix arrays hold the same suffixes in the same order
+static bool sameSuffixArray(const SuffixArray * a, const SuffixArray * b) {
+  if (a->getSize() != b->getSize())
+    return false;
+  for (size_t i = 0; i < a->getSize(); ++i)
+    if (a->get(i).getID() != b->get(i).getID() || a->get(i).getPos() != b->get(i).getPos())
+      return false;
+  return true;
+}
+
+// sort the reads again by induced copying, and die if SA-IS gave a different order
+static void validateSuffixArrays(const PackedReadTable * pRT, const SuffixArray * pSAf, const SuffixArray * pSAr) {
+
+  ReadTable rt;
+  unpackReads(pRT, rt);
+  SuffixArray f, r;
+  saca_induced_copying(&f, &rt, 1, true);
+  rt.reverseAll();
+  saca_induced_copying(&r, &rt, 1, true);
+
+  if (!sameSuffixArray(pSAf, &f) || !sameSuffixArray(pSAr, &r)) {
+    std::cerr << "VALIDATE_SAIS suffix arrays differ for " << pRT->getCount() << " reads" << std::endl;
+    for (size_t i = 0; i < pRT->getCount(); ++i)
+      std::cerr << pRT->getReadID(i) << "\t" << pRT->getSequence(i) << std::endl;
+    exit(EXIT_FAILURE);
+  }
+}
+#endif
+
+void svabaAssemblerEngine::buildIndex(const PackedReadTable* pRT, SuffixArray*& pSAf, SuffixArray*& pSAr, BWT*& pBWT, BWT*& pRBWT) {
+
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+  // both suffix arrays from one packing of the reads, which stay as they are
+  pSAf = new SuffixArray();
+  pSAr = new SuffixArray();
+  if (!saca_induced_sort_pair(pSAf, pSAr, pRT->getView())) {
+    delete pSAf;
+    delete pSAr;
+
+    // too long for SA-IS, so unpack the reads for the induced copying sort
+    ReadTable rt;
+    unpackReads(pRT, rt);
+    pSAf = new SuffixArray(&rt, 1, false); //1 is num threads. false is silent/no
+    rt.reverseAll();
+    pSAr = new SuffixArray(&rt, 1, false);
+  }
+#ifdef VALIDATE_SAIS
+  else {
+    validateSuffixArrays(pRT, pSAf, pSAr);
+  }
+#endif
+
+  // the reverse BWT reads its symbols from a reversed view of the reads
+  pBWT = new BWT(pSAf, pRT->getView());
+  pRBWT = new BWT(pSAr, pRT->getView(true));
+
+  m_index_secs += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// not totally sure this works...
+PackedReadTable* svabaAssemblerEngine::removeDuplicates(PackedReadTable* pRT) {
 
-  // reverse
-  pRT->reverseAll();
-  SuffixArray * pSAr = new SuffixArray(pRT, 1, false);
-  RLBWT *pRBWT = new RLBWT(pSAr, pRT);
-  pRT->reverseAll();
+  // forward and reverse indexes
+  SuffixArray *pSAf, *pSAr;
+  BWT *pBWT, *pRBWT;
+  buildIndex(pRT, pSAf, pSAr, pBWT, pRBWT);
 
   svabaOverlapAlgorithm* pRmDupOverlapper = new svabaOverlapAlgorithm(pBWT, pRBWT, 
 									  0, 0, 
 									  0, false);
   
-  pRT->setZero();
-  ReadTable * pRT_nd = new ReadTable();
-  SeqItem sir;
-  while (pRT->getRead(sir)) {
+  PackedReadTable * pRT_nd = new PackedReadTable();
+  for (size_t k = 0; k < pRT->getCount(); ++k) {
     OverlapBlockList OBout;
     SeqRecord read;
-    read.id = sir.id;
-    read.seq = sir.seq;
+    read.id = pRT->getReadID(k);
+    read.seq = pRT->getSequence(k);
     OverlapBlockList obl;
     OverlapResult rr = pRmDupOverlapper->alignReadDuplicate(read, &OBout);
 
     if (!rr.isSubstring)
-      pRT_nd->addRead(sir);
+      pRT_nd->addRead(*pRT, k);
   }
 
   delete pRmDupOverlapper;
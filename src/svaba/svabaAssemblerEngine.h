@@ -5,10 +5,16 @@
 //#include "contigs.h"
 #include "SGUtil.h"
 #include "ReadTable.h"
+#include "PackedReadTable.h"
+#include "SuffixArray.h"
+#include "BWT.h"
 #include "SeqLib/BamRecord.h"
 #include "SeqLib/UnalignedSequence.h"
 #include "svabaRead.h"
 #include "svaba_params.h"
+#include "AssemblyCache.h"
+
+class svabaTaskPool;
 
 class svabaAssemblerEngine
 {
@@ -19,27 +25,38 @@ class svabaAssemblerEngine
   svabaAssemblerEngine(const std::string& id, double er, size_t mo, size_t rl) : m_id(id), m_error_rate(er), m_min_overlap(mo), m_readlen(rl) {}
   
   bool hasRepeat(const std::string& seq);
+
+  bool hasRepeat(const char* seq, size_t len);
   
   void fillReadTable(svabaReadVector& r);
   
   void fillReadTable(const std::vector<std::string>& r);
   
   bool performAssembly(int num_assembly_rounds);
+
+  /** Fingerprint of the reads in the read table and the assembly parameters, for the assembly cache */
+  AssemblyKey fingerprint(int num_assembly_rounds) const;
   
   //void doAssembly(ReadTable *pRT, ContigVector &contigs, int pass);
-  void doAssembly(ReadTable *pRT, SeqLib::UnalignedSequenceVector &contigs, int pass);
+  void doAssembly(PackedReadTable *pRT, SeqLib::UnalignedSequenceVector &contigs, int pass);
   
   void setToWriteASQG() { m_write_asqg = true; }
+
+  /** Share the overlap computation of large read tables with the threads of pool */
+  void setTaskPool(svabaTaskPool* pool) { m_pool = pool; }
   
   SeqLib::UnalignedSequenceVector getContigs() const { return m_contigs; }
   //ContigVector getContigs() const { return m_contigs; }
   
   void clearContigs() { m_contigs.clear(); }
 
-  ReadTable* removeDuplicates(ReadTable* pRT);
+  PackedReadTable* removeDuplicates(PackedReadTable* pRT);
 
   void calculateSeedParameters(int read_len, const int minOverlap, int& seed_length, int& seed_stride) const;
 
+  /** Seconds spent building suffix arrays and BWTs for this window */
+  double getIndexSeconds() const { return m_index_secs; }
+
  private:
 
   void print_results(const SeqLib::UnalignedSequenceVector& cc) const;
@@ -48,6 +65,9 @@ class svabaAssemblerEngine
   void remove_exact_dups(SeqLib::UnalignedSequenceVector& cc) const;
 
   void write_asqg(const StringGraph * oGraph, std::stringstream& asqg_stream, std::stringstream& hits_stream, int pass) const;
+
+  // build the forward and reverse suffix arrays and BWTs of pRT
+  void buildIndex(const PackedReadTable* pRT, SuffixArray*& pSAf, SuffixArray*& pSAr, BWT*& pBWT, BWT*& pRBWT);
   
   std::string m_id;
   double m_error_rate;
@@ -68,8 +88,12 @@ class svabaAssemblerEngine
   std::string outVariantsFile = ""; // dummy
   
   bool m_write_asqg = false;
+
+  svabaTaskPool* m_pool = nullptr;
+
+  double m_index_secs = 0;
   
-  ReadTable m_pRT;
+  PackedReadTable m_pRT;
   
   //ContigVector m_contigs;
   SeqLib::UnalignedSequenceVector m_contigs;
@@ -1,6 +1,7 @@
 #include "svabaBamWalker.h"
 #include "svabaRead.h"
 #include "svaba_params.h"
+#include "MateFetchService.h"
 
 //#define QNAME "H01PEALXX140819:3:2218:11657:19504"
 //#define QFLAG -1
@@ -22,20 +23,13 @@ void svabaBamWalker::addCigar(SeqLib::BamRecord &r) {
   // this is a 100% match
   if (r.CigarSize() == 1)
     return;
-  std::stringstream cigar_ss;
-  cigar_ss.str(std::string());
   int pos = r.Position(); // position ON REFERENCE
   
   for (auto& i : r.GetCigar()) {
 
        // if it's a D or I, add it to the list
-      if (i.Type() == 'D' || i.Type() == 'I') {	
-
-	cigar_ss << r.ChrID() << "_" << pos << "_" << i.Length() << i.Type();
-	++cigmap[cigar_ss.str()];
-
-	cigar_ss.str(std::string());
-      }
+      if (i.Type() == 'D' || i.Type() == 'I')
+	cigmap.add(r.ChrID(), pos, i.Length(), i.Type());
       
       // move along the REFERENCE
       if (!(i.Type() == 'I') && !(i.Type() == 'S') && !(i.Type() == 'H'))
@@ -75,18 +69,55 @@ SeqLib::GRC svabaBamWalker::readBam(std::ofstream * log) {
   // if we have a LOT of reads (aka whole genome run), keep track for printing
   size_t countr = 0;
 
+  // reads come either from the BAM (after any reads reused from the last 
+  // window), or from reads already fetched for each region
+  size_t feed_region = 0, feed_pos = 0, replay_pos = 0;
+  auto next_record = [&](SeqLib::BamRecord& rr) -> bool {
+    if (!m_feed) {
+      if (replay_pos < m_replay.size()) {
+	rr = m_replay[replay_pos++];
+	return true;
+      }
+      // skip reads that start in the reused pad, since we already have them
+      while (GetNextRecord(rr))
+	if (rr.Position() > m_skip_to)
+	  return true;
+      return false;
+    }
+    while (feed_region < m_feed->reads.size() && feed_pos >= m_feed->reads[feed_region].size()) {
+      ++feed_region;
+      feed_pos = 0;
+    }
+    if (feed_region >= m_feed->reads.size())
+      return false;
+    rr = m_feed->reads[feed_region][feed_pos++];
+    return true;
+  };
+  auto region_idx = [&]() -> size_t { return m_feed ? feed_region : tb->m_region_idx; };
+  const SeqLib::GRC& regions = m_feed ? m_feed->regions : m_region;
+
   // keep track of which region we are in 
-  int current_region = tb->m_region_idx;
+  size_t current_region = region_idx();
+
+  // reads overlapping this are kept for the next window
+  const int pad_start = m_window.pos2 - WINDOW_REUSE_PAD;
 
   // store qnames of reads have read into adapter
   std::unordered_set<uint32_t> adapter;
 
   // loop the reads
-  while (GetNextRecord(r)) {
+  while (next_record(r)) {
+
+    // keep a copy of reads in the right pad, before they are modified below
+    if (m_keep_pad && r.PositionEnd() >= pad_start) {
+      SeqLib::BamRecord c;
+      c.assign(bam_dup1(r.raw()));
+      m_pad_reads.push_back(c);
+    }
 
     // when we more regions, save the reads from last region
-    if (tb->m_region_idx != current_region) {
-      current_region = tb->m_region_idx;
+    if (region_idx() != current_region) {
+      current_region = region_idx();
       reads.insert(reads.end(), this_reads.begin(), this_reads.end());
       this_reads.clear();
     }
@@ -129,14 +160,18 @@ SeqLib::GRC svabaBamWalker::readBam(std::ofstream * log) {
 
       std::stringstream ss; 
       ss << "\tstopping read lookup at " << r.Brief() << " in window " 
-	 << (m_region.size() ? m_region[tb->m_region_idx].ToString(tb->GetHeader()) : " whole BAM")
+	 << (regions.size() ? regions[region_idx()].ToString(tb->GetHeader()) : " whole BAM")
 	       << " with " << SeqLib::AddCommas(this_reads.size()) 
 	       << " weird reads. Limit: " << SeqLib::AddCommas(m_limit) << std::endl;
       if (log)
 	(*log) << ss.str();
       
-      if (m_region.size())  
-	bad_regions.add(m_region[tb->m_region_idx]);
+      if (regions.size())  
+	bad_regions.add(regions[region_idx()]);
+
+      // didn't see all of the reads, so can't reuse the pad
+      m_keep_pad = false;
+      m_pad_reads.clear();
 
       // clear these reads out
       //if ((int)reads.size() - countr > 0)
@@ -144,6 +179,13 @@ SeqLib::GRC svabaBamWalker::readBam(std::ofstream * log) {
       //reads.erase(reads.begin(), reads.begin() + countr);
       
       // force it to try the next region, or return if none left
+      if (m_feed) {
+	++feed_region;
+	feed_pos = 0;
+	if (feed_region >= m_feed->reads.size())
+	  break;
+	continue;
+      }
       ++tb->m_region_idx; // increment to next region
       if (tb->m_region_idx >= m_region.size()) {/// no more regions left
 	break;
@@ -249,6 +291,15 @@ SeqLib::GRC svabaBamWalker::readBam(std::ofstream * log) {
     
   } // end the read loop
 
+  // the pad is complete if we read to the end of the window
+  if (m_keep_pad) {
+    m_pad_region = SeqLib::GenomicRegion(m_window.chr, pad_start, m_window.pos2);
+    m_pad_valid = true;
+  }
+  m_keep_pad = false;
+  m_replay.clear();
+  m_skip_to = -1;
+
   // remove the adapter reads
   svabaReadVector new_reads;
   for (auto& r : this_reads)
@@ -288,6 +339,32 @@ SeqLib::GRC svabaBamWalker::readBam(std::ofstream * log) {
   
 }
 
+void svabaBamWalker::SetWindow(const SeqLib::GenomicRegion& gr) {
+
+  m_replay.clear();
+  m_skip_to = -1;
+  num_reused = 0;
+
+  // reuse the reads from the last window if this window picks up inside its right pad
+  if (m_pad_valid && m_pad_region.chr == gr.chr && gr.pos1 >= m_pad_region.pos1 && 
+      gr.pos1 <= m_pad_region.pos2 && gr.pos2 > m_pad_region.pos2) {
+    for (auto& r : m_pad_reads)
+      if (r.PositionEnd() >= gr.pos1)
+	m_replay.push_back(r);
+    num_reused = m_replay.size();
+    m_skip_to = m_pad_region.pos2;
+    SetRegion(SeqLib::GenomicRegion(gr.chr, m_pad_region.pos2 + 1, gr.pos2));
+  } else {
+    SetRegion(gr);
+  }
+
+  // start keeping the right pad of this window
+  m_pad_reads.clear();
+  m_pad_valid = false;
+  m_window = gr;
+  m_keep_pad = gr.Width() > WINDOW_REUSE_PAD;
+}
+
 void svabaBamWalker::subSampleToWeirdCoverage(double max_coverage) {
   
   svabaReadVector new_reads;
@@ -356,23 +433,33 @@ void svabaBamWalker::calculateMateRegions() {
     
   }
 
-  // merge it down to get the mate regions
+  // merge it down to get the mate regions. Merged regions are disjoint, 
+  // so once sorted they are ordered by both start and end
   tmp_mate_regions.MergeOverlappingIntervals();
+  tmp_mate_regions.CoordinateSort();
 
-  // get the counts by overlapping mate-reads with the newly defined mate regions
+  // collect the mate positions that are outside of the main interval
+  std::vector<std::pair<int,int> > mpos;
+  mpos.reserve(reads.size());
   for (auto& r : reads) {
     
     SeqLib::GenomicRegion mate(r.MateChrID(), r.MatePosition(), r.MatePosition());
 
-    // if mate not in main interval, check which mate regions it's in
-    if (!main_region.GetOverlap(mate) && r.MapQuality() > 0) {
-
-      for (auto& k : tmp_mate_regions)
-	if (k.GetOverlap(mate)) {
-	  ++k.count;
-	  continue;
-	}
-    }
+    if (!main_region.GetOverlap(mate) && r.MapQuality() > 0) 
+      mpos.push_back(std::pair<int,int>(r.MateChrID(), r.MatePosition()));
+  }
+  std::sort(mpos.begin(), mpos.end());
+
+  // get the counts by sweeping the sorted mate positions against the sorted mate regions
+  size_t k = 0;
+  for (auto& m : mpos) {
+    while (k < tmp_mate_regions.size() && (tmp_mate_regions[k].chr < m.first || 
+					   (tmp_mate_regions[k].chr == m.first && tmp_mate_regions[k].pos2 < m.second)))
+      ++k;
+    if (k == tmp_mate_regions.size())
+      break;
+    if (tmp_mate_regions[k].chr == m.first && tmp_mate_regions[k].pos1 <= m.second)
+      ++tmp_mate_regions[k].count;
   }
 
 #ifdef DEBUG_SVABA_BAMWALKER
@@ -9,6 +9,7 @@
 #include "SeqLib/BamReader.h"
 #include "SeqLib/ReadFilter.h"
 #include "STCoverage.h"
+#include "IndelCigarMap.h"
 #include "SeqLib/BWAWrapper.h"
 #include "DiscordantRealigner.h"
 
@@ -27,6 +28,8 @@ class MateRegion: public SeqLib::GenomicRegion
 
 typedef SeqLib::GenomicRegionCollection<MateRegion> MateRegionVector;
 
+struct MateFetchResult;
+
 class svabaBamWalker: public SeqLib::BamReader {
   
  public:
@@ -45,6 +48,14 @@ class svabaBamWalker: public SeqLib::BamReader {
   // read in the reads
   SeqLib::GRC readBam(std::ofstream* log = nullptr);
 
+  // set the window for the next readBam. If it starts inside the right pad of the
+  // last window read, the reads kept from that pad are reused and only the rest
+  // of the window is read from the BAM
+  void SetWindow(const SeqLib::GenomicRegion& gr);
+
+  // number of reads reused from the last window's pad on the last SetWindow
+  size_t num_reused = 0;
+
   // clear it out
   void clear() { 
     cov.clear();
@@ -90,7 +101,7 @@ class svabaBamWalker: public SeqLib::BamReader {
   STCoverage cov, weird_cov; //c
 
   // hash of cigars for indels
-  SeqLib::CigarMap cigmap; //c
+  IndelCigarMap cigmap; //c
 
   // mate regions to lookup
   MateRegionVector mate_regions; //c
@@ -115,6 +126,9 @@ class svabaBamWalker: public SeqLib::BamReader {
   // set a hard limit on how many reads to accept
   size_t m_limit = 0;
 
+  // if set, readBam takes its reads from here (one set per region) instead of the BAM
+  const MateFetchResult * m_feed = nullptr;
+
   // set a read filter
   SeqLib::Filter::ReadFilterCollection * m_mr;
 
@@ -133,6 +147,19 @@ class svabaBamWalker: public SeqLib::BamReader {
   // seed for the kmer-learning subsampling
   uint32_t m_seed = 1337;
 
+  // reads (deep copies) from the right pad of the last window, and the region they cover
+  SeqLib::BamRecordVector m_pad_reads;
+  SeqLib::GenomicRegion m_pad_region;
+  bool m_pad_valid = false;
+
+  // window set with SetWindow. Reads at its right end are kept for the next window
+  SeqLib::GenomicRegion m_window;
+  bool m_keep_pad = false;
+
+  // kept reads to process before reading the BAM, and the last position they cover
+  SeqLib::BamRecordVector m_replay;
+  int m_skip_to = -1;
+
   // quality trim the readd
   void QualityTrimRead(svabaRead& r) const;
   
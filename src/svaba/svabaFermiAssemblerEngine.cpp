@@ -0,0 +1,72 @@
+#include "svabaFermiAssemblerEngine.h"
+#include "svabaUtils.h"
+
+#include <set>
+
+// same read filter as svabaAssemblerEngine::hasRepeat, so both assemblers get the same reads
+static bool skipRead(const std::string& seq) {
+  if (seq.find("N") != std::string::npos)
+    return true;
+  return seq.length() >= 40 && svabaUtils::hasRepeat(seq);
+}
+
+void svabaFermiAssemblerEngine::fillReadTable(const std::vector<std::string>& r) {
+
+  int count = 0;
+  for (auto& i : r) {
+    if (i.length() < m_min_overlap)
+      continue;
+    m_reads.push_back({"read_" + std::to_string(++count), i, std::string()});
+  }
+
+}
+
+void svabaFermiAssemblerEngine::fillReadTable(svabaReadVector& r) {
+
+  size_t count = 0;
+  for (auto& i : r) {
+
+    std::string sr = std::to_string(++count);
+    std::string seq = i.Seq();
+
+    if (skipRead(seq) || seq.length() < m_min_overlap)
+      continue;
+
+    // put onto the foward strand if not
+    if (!i.MappedFlag() && !i.MateReverseFlag())
+      SeqLib::rcomplement(seq);
+
+    m_reads.push_back({sr, seq, std::string()});
+  }
+
+}
+
+AssemblyKey svabaFermiAssemblerEngine::fingerprint() const {
+
+  AssemblyFingerprint fp;
+  for (auto& i : m_reads)
+    fp.add(i.Seq);
+  return fp.key(0, m_min_overlap, 0, 1, ASSEMBLER_FML);
+
+}
+
+bool svabaFermiAssemblerEngine::performAssembly() {
+
+  if (m_reads.size() < 2)
+    return false;
+
+  SeqLib::FermiAssembler fml;
+  fml.AddReads(m_reads);
+  fml.CorrectReads();
+  fml.SetMinOverlap(m_min_overlap);
+  fml.PerformAssembly();
+
+  // name the unitigs as the SGA engine names its contigs, and drop exact dups
+  std::set<std::string> seen;
+  size_t count = 0;
+  for (auto& c : fml.GetContigs())
+    if (seen.insert(c).second)
+      m_contigs.push_back({m_id + "_" + std::to_string(count++) + "C", c, std::string()});
+
+  return true;
+}
@@ -0,0 +1,45 @@
+#ifndef SVABA_FERMI_ASSEMBLER_ENGINE_H__
+#define SVABA_FERMI_ASSEMBLER_ENGINE_H__
+
+#include "SeqLib/FermiAssembler.h"
+#include "SeqLib/UnalignedSequence.h"
+#include "svabaRead.h"
+#include "AssemblyCache.h"
+
+/** Local assembly with fermi-lite, as an alternative to the SGA-based svabaAssemblerEngine.
+ *
+ * Takes the same reads and returns contigs named the same way, but assembles
+ * the reads into unitigs in memory, with no ASQG text in between and with
+ * fermi-lite's own error correction. Selected with --assembler fml
+ */
+class svabaFermiAssemblerEngine
+{
+ public:
+
+  svabaFermiAssemblerEngine(const std::string& id, size_t mo) : m_id(id), m_min_overlap(mo) {}
+
+  void fillReadTable(svabaReadVector& r);
+
+  void fillReadTable(const std::vector<std::string>& r);
+
+  bool performAssembly();
+
+  /** Fingerprint of the reads and the assembly parameters, for the assembly cache */
+  AssemblyKey fingerprint() const;
+
+  SeqLib::UnalignedSequenceVector getContigs() const { return m_contigs; }
+
+  size_t numReads() const { return m_reads.size(); }
+
+ private:
+
+  std::string m_id;
+  size_t m_min_overlap;
+
+  SeqLib::UnalignedSequenceVector m_reads;
+
+  SeqLib::UnalignedSequenceVector m_contigs;
+
+};
+
+#endif
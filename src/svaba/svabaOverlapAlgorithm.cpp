@@ -31,6 +31,146 @@ OverlapResult svabaOverlapAlgorithm::overlapRead(const SeqRecord& read, int minO
     return r;
 }
 
+// The state of one search of findOverlapBlocksExact
+struct svabaOverlapAlgorithm::ExactSearch
+{
+    std::string w;
+    const BWT* pBWT;
+    const BWT* pRevBWT;
+    const AlignFlags* pAF;
+    OverlapBlockList* pOverlapList;
+    OverlapBlockList containList; // joined to the read's contain lists in search order when done
+    OverlapResult* pResult;
+    BWTIntervalPair ranges; // the interval of w[pos + 1, l)
+    int pos;
+};
+
+//
+void svabaOverlapAlgorithm::overlapReads(const SeqRecordVector& reads, int minOverlap, 
+                                         std::vector<OverlapBlockList>& outLists, std::vector<OverlapResult>& outResults) const
+{
+    outLists.clear();
+    outLists.resize(reads.size());
+    outResults.clear();
+    outResults.resize(reads.size());
+
+    // The inexact search branches at mismatches, so it is run a read at a time
+    if(!m_exactModeOverlap)
+    {
+        for(size_t i = 0; i < reads.size(); ++i)
+            outResults[i] = overlapRead(reads[i], minOverlap, &outLists[i]);
+        return;
+    }
+
+    // The four searches of overlapReadExact for each read
+    static const AlignFlags* const searchAF[4] = { &sufPreAF, &prePreAF, &sufSufAF, &preSufAF };
+    std::vector<ExactBlockLists> lists(reads.size());
+    std::vector<ExactSearch> searches(4 * reads.size());
+    std::vector<ExactSearch*> active;
+    active.reserve(searches.size());
+    for(size_t i = 0; i < reads.size(); ++i)
+    {
+        if(static_cast<int>(reads[i].seq.length()) < minOverlap)
+            continue;
+
+        std::string seq = reads[i].seq.toString();
+        assert(seq.length() > 1);
+        OverlapBlockList* pOverlapLists[4] = { &lists[i].suffixFwd, &lists[i].suffixRev, &lists[i].prefixFwd, &lists[i].prefixRev };
+        for(size_t j = 0; j < 4; ++j)
+        {
+            ExactSearch& search = searches[4 * i + j];
+            switch(j)
+            {
+                case 0: search.w = seq; break;
+                case 1: search.w = complement(seq); break;
+                case 2: search.w = reverseComplement(seq); break;
+                default: search.w = reverse(seq); break;
+            }
+            // the forward searches use the forward index, the complemented ones the reverse
+            search.pBWT = (j == 0 || j == 2) ? m_pBWT : m_pRevBWT;
+            search.pRevBWT = (j == 0 || j == 2) ? m_pRevBWT : m_pBWT;
+            search.pAF = searchAF[j];
+            search.pOverlapList = pOverlapLists[j];
+            search.pResult = &outResults[i];
+            search.pos = search.w.length() - 2;
+            BWTAlgorithms::initIntervalPair(search.ranges, search.w[search.w.length() - 1], search.pBWT, search.pRevBWT);
+
+            // an empty interval stays empty, and finds no blocks
+            if(search.ranges.interval[0].isValid())
+            {
+                search.pBWT->prefetch(search.ranges.interval[0].lower - 1);
+                search.pBWT->prefetch(search.ranges.interval[0].upper);
+                active.push_back(&search);
+            }
+        }
+    }
+
+    // Step each search in turn. By the time a search is stepped again the
+    // blocks it prefetched have arrived
+    while(!active.empty())
+    {
+        size_t n = 0;
+        for(size_t i = 0; i < active.size(); ++i)
+        {
+            if(stepOverlapSearchExact(*active[i], minOverlap))
+                active[n++] = active[i];
+        }
+        active.resize(n);
+    }
+
+    for(size_t i = 0; i < reads.size(); ++i)
+    {
+        if(static_cast<int>(reads[i].seq.length()) < minOverlap)
+            continue;
+
+        // the contain lists are filled in the order of overlapReadExact
+        lists[i].fwdContain.splice(lists[i].fwdContain.end(), searches[4 * i].containList);
+        lists[i].revContain.splice(lists[i].revContain.end(), searches[4 * i + 1].containList);
+        lists[i].fwdContain.splice(lists[i].fwdContain.end(), searches[4 * i + 2].containList);
+        lists[i].revContain.splice(lists[i].revContain.end(), searches[4 * i + 3].containList);
+        finishOverlapExact(reads[i].seq.length(), lists[i], &outLists[i]);
+    }
+}
+
+// One step of the loop of findOverlapBlocksExact. The '$' probe of the current
+// interval and its extension by the next base read the same occurrence counts,
+// so they are looked up once
+bool svabaOverlapAlgorithm::stepOverlapSearchExact(ExactSearch& search, int minOverlap) const
+{
+    const BWT* pBWT = search.pBWT;
+    BWTIntervalPair& ranges = search.ranges;
+    AlphaCount64 lower = pBWT->getFullOcc(ranges.interval[0].lower - 1);
+    AlphaCount64 upper = pBWT->getFullOcc(ranges.interval[0].upper);
+
+    // The interval holds w[pos + 1, l). Collect the proper prefixes that match it
+    int overlapLen = search.w.length() - 1 - search.pos;
+    if(overlapLen > 1 && overlapLen >= minOverlap)
+    {
+        BWTIntervalPair probe = ranges;
+        BWTAlgorithms::updateBothL(probe, '$', pBWT, lower, upper);
+        if(probe.interval[1].isValid())
+        {
+            assert(probe.interval[1].lower > 0);
+            search.pOverlapList->push_back(OverlapBlock(probe, ranges, overlapLen, 0, *search.pAF));
+        }
+    }
+
+    BWTAlgorithms::updateBothL(ranges, search.w[search.pos], pBWT, lower, upper);
+    if(search.pos == 0)
+    {
+        // Ranges now holds the interval for the full-length read
+        findContainmentExact(search.w, pBWT, search.pRevBWT, *search.pAF, ranges, &search.containList, *search.pResult);
+        return false;
+    }
+
+    --search.pos;
+    if(!ranges.interval[0].isValid())
+        return false;
+    pBWT->prefetch(ranges.interval[0].lower - 1);
+    pBWT->prefetch(ranges.interval[0].upper);
+    return true;
+}
+
 //
 OverlapResult svabaOverlapAlgorithm::overlapReadInexact(const SeqRecord& read, int minOverlap, OverlapBlockList* pOBOut) const
 {
@@ -187,67 +327,65 @@ OverlapResult svabaOverlapAlgorithm::overlapReadExact(const SeqRecord& read, int
     // The complete set of overlap blocks are collected in obWorkingList
     // The filtered set (containing only irreducible overlaps) are placed into pOBOut
     // by calculateIrreducibleHits
-    OverlapBlockList obWorkingList;
     std::string seq = read.seq.toString();
 
     // We store the various overlap blocks using a number of lists, one for the containments
     // in the forward and reverse index and one for each set of overlap blocks
-    OverlapBlockList oblFwdContain;
-    OverlapBlockList oblRevContain;
-    
-    OverlapBlockList oblSuffixFwd;
-    OverlapBlockList oblSuffixRev;
-    OverlapBlockList oblPrefixFwd;
-    OverlapBlockList oblPrefixRev;
+    ExactBlockLists lists;
 
     // Match the suffix of seq to prefixes
-    findOverlapBlocksExact(seq, m_pBWT, m_pRevBWT, sufPreAF, minOverlap, &oblSuffixFwd, &oblFwdContain, result);
-    findOverlapBlocksExact(complement(seq), m_pRevBWT, m_pBWT, prePreAF, minOverlap, &oblSuffixRev, &oblRevContain, result);
+    findOverlapBlocksExact(seq, m_pBWT, m_pRevBWT, sufPreAF, minOverlap, &lists.suffixFwd, &lists.fwdContain, result);
+    findOverlapBlocksExact(complement(seq), m_pRevBWT, m_pBWT, prePreAF, minOverlap, &lists.suffixRev, &lists.revContain, result);
 
     // Match the prefix of seq to suffixes
-    findOverlapBlocksExact(reverseComplement(seq), m_pBWT, m_pRevBWT, sufSufAF, minOverlap, &oblPrefixFwd, &oblFwdContain, result);
-    findOverlapBlocksExact(reverse(seq), m_pRevBWT, m_pBWT, preSufAF, minOverlap, &oblPrefixRev, &oblRevContain, result);
+    findOverlapBlocksExact(reverseComplement(seq), m_pBWT, m_pRevBWT, sufSufAF, minOverlap, &lists.prefixFwd, &lists.fwdContain, result);
+    findOverlapBlocksExact(reverse(seq), m_pRevBWT, m_pBWT, preSufAF, minOverlap, &lists.prefixRev, &lists.revContain, result);
 
+    finishOverlapExact(seq.length(), lists, pOBOut);
+    return result;
+}
+
+//
+void svabaOverlapAlgorithm::finishOverlapExact(size_t readLength, ExactBlockLists& lists, OverlapBlockList* pOBOut) const
+{
     // Remove submaximal blocks for each block list including fully contained blocks
     // Copy the containment blocks into the prefix/suffix lists
-    oblSuffixFwd.insert(oblSuffixFwd.end(), oblFwdContain.begin(), oblFwdContain.end());
-    oblPrefixFwd.insert(oblPrefixFwd.end(), oblFwdContain.begin(), oblFwdContain.end());
-    oblSuffixRev.insert(oblSuffixRev.end(), oblRevContain.begin(), oblRevContain.end());
-    oblPrefixRev.insert(oblPrefixRev.end(), oblRevContain.begin(), oblRevContain.end());
+    lists.suffixFwd.insert(lists.suffixFwd.end(), lists.fwdContain.begin(), lists.fwdContain.end());
+    lists.prefixFwd.insert(lists.prefixFwd.end(), lists.fwdContain.begin(), lists.fwdContain.end());
+    lists.suffixRev.insert(lists.suffixRev.end(), lists.revContain.begin(), lists.revContain.end());
+    lists.prefixRev.insert(lists.prefixRev.end(), lists.revContain.begin(), lists.revContain.end());
     
     // Perform the submaximal filter
-    removeSubMaximalBlocks(&oblSuffixFwd, m_pBWT, m_pRevBWT);
-    removeSubMaximalBlocks(&oblPrefixFwd, m_pBWT, m_pRevBWT);
-    removeSubMaximalBlocks(&oblSuffixRev, m_pRevBWT, m_pBWT);
-    removeSubMaximalBlocks(&oblPrefixRev, m_pRevBWT, m_pBWT);
+    removeSubMaximalBlocks(&lists.suffixFwd, m_pBWT, m_pRevBWT);
+    removeSubMaximalBlocks(&lists.prefixFwd, m_pBWT, m_pRevBWT);
+    removeSubMaximalBlocks(&lists.suffixRev, m_pRevBWT, m_pBWT);
+    removeSubMaximalBlocks(&lists.prefixRev, m_pRevBWT, m_pBWT);
     
     // Remove the contain blocks from the suffix/prefix lists
-    removeContainmentBlocks(seq.length(), &oblSuffixFwd);
-    removeContainmentBlocks(seq.length(), &oblPrefixFwd);
-    removeContainmentBlocks(seq.length(), &oblSuffixRev);
-    removeContainmentBlocks(seq.length(), &oblPrefixRev);
+    removeContainmentBlocks(readLength, &lists.suffixFwd);
+    removeContainmentBlocks(readLength, &lists.prefixFwd);
+    removeContainmentBlocks(readLength, &lists.suffixRev);
+    removeContainmentBlocks(readLength, &lists.prefixRev);
 
     // Join the suffix and prefix lists
-    oblSuffixFwd.splice(oblSuffixFwd.end(), oblSuffixRev);
-    oblPrefixFwd.splice(oblPrefixFwd.end(), oblPrefixRev);
+    lists.suffixFwd.splice(lists.suffixFwd.end(), lists.suffixRev);
+    lists.prefixFwd.splice(lists.prefixFwd.end(), lists.prefixRev);
 
     // Move the containments to the output list
-    pOBOut->splice(pOBOut->end(), oblFwdContain);
-    pOBOut->splice(pOBOut->end(), oblRevContain);
+    pOBOut->splice(pOBOut->end(), lists.fwdContain);
+    pOBOut->splice(pOBOut->end(), lists.revContain);
 
     // Filter out transitive overlap blocks if requested
     if(m_bIrreducible)
     {
-        computeIrreducibleBlocks(m_pBWT, m_pRevBWT, &oblSuffixFwd, pOBOut);
-        computeIrreducibleBlocks(m_pBWT, m_pRevBWT, &oblPrefixFwd, pOBOut);
+        computeIrreducibleBlocks(m_pBWT, m_pRevBWT, &lists.suffixFwd, pOBOut);
+        computeIrreducibleBlocks(m_pBWT, m_pRevBWT, &lists.prefixFwd, pOBOut);
     }
     else
     {
-        pOBOut->splice(pOBOut->end(), oblSuffixFwd);
-        pOBOut->splice(pOBOut->end(), oblPrefixFwd);
+        pOBOut->splice(pOBOut->end(), lists.suffixFwd);
+        pOBOut->splice(pOBOut->end(), lists.prefixFwd);
     }
-
-    return result;
 }
 
 // Write overlap results to an ASQG file
@@ -335,6 +473,14 @@ void svabaOverlapAlgorithm::findOverlapBlocksExact(const std::string& w, const B
     BWTAlgorithms::updateBothL(ranges, w[0], pBWT);
 
     // Ranges now holds the interval for the full-length read
+    findContainmentExact(w, pBWT, pRevBWT, af, ranges, pContainList, result);
+}
+
+//
+void svabaOverlapAlgorithm::findContainmentExact(const std::string& w, const BWT* pBWT, const BWT* pRevBWT,
+                                                 const AlignFlags& af, const BWTIntervalPair& ranges,
+                                                 OverlapBlockList* pContainList, OverlapResult& result) const
+{
     // To handle containments, we output the overlapBlock to the final overlap block list
     // and it will be processed later
     // Two possible containment cases:
@@ -361,17 +507,6 @@ void svabaOverlapAlgorithm::findOverlapBlocksExact(const std::string& w, const B
             pContainList->push_back(OverlapBlock(probe, ranges, w.length(), 0, af));
         }
     }
-
-    //OverlapBlockList containedWorkingList;
-    //partitionBlockList(w.length(), &workingList, pOverlapList, &containedWorkingList);
-    
-    // Terminate the contained blocks
-    //terminateContainedBlocks(containedWorkingList);
-    
-    // Move the contained blocks to the final contained list
-    //pContainList->splice(pContainList->end(), containedWorkingList);
-
-    return;
 }
 
 // Seeded blockwise BWT alignment of prefix-suffix for reads
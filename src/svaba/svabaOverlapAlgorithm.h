@@ -50,6 +50,14 @@ class svabaOverlapAlgorithm
         // This function is threaded so everything must be const
         OverlapResult overlapRead(const SeqRecord& read, int minOverlap, OverlapBlockList* pOutList) const;
     
+        // Perform the overlap for each read of a batch, with the same results as
+        // overlapRead. In exact mode the FM-index searches of all the reads are
+        // advanced a base at a time in turn, and each step prefetches the
+        // occurrence blocks of its next step, so the cache misses of one search
+        // are hidden behind the steps of the others
+        void overlapReads(const SeqRecordVector& reads, int minOverlap, 
+                          std::vector<OverlapBlockList>& outLists, std::vector<OverlapResult>& outResults) const;
+
         // Perform an irreducible overlap
         OverlapResult overlapReadExact(const SeqRecord& read, int minOverlap, OverlapBlockList* pOBOut) const;
 
@@ -79,12 +87,38 @@ class svabaOverlapAlgorithm
         
     private:
 
+        // The blocks found by the four exact searches of a read
+        struct ExactBlockLists
+        {
+            OverlapBlockList fwdContain;
+            OverlapBlockList revContain;
+            OverlapBlockList suffixFwd;
+            OverlapBlockList suffixRev;
+            OverlapBlockList prefixFwd;
+            OverlapBlockList prefixRev;
+        };
+
+        // The state of one findOverlapBlocksExact search, for overlapReads
+        struct ExactSearch;
+
         // Calculate the ranges in pBWT that contain a prefix of at least minOverlap basepairs that
         // overlaps with a suffix of w.
         void findOverlapBlocksExact(const std::string& w, const BWT* pBWT, const BWT* pRevBWT, 
                                     const AlignFlags& af, const int minOverlap, OverlapBlockList* pOBTemp, 
                                     OverlapBlockList* pOBFinal, OverlapResult& result) const;
 
+        // Check if the read w, with interval ranges, is a substring of or identical to other reads
+        void findContainmentExact(const std::string& w, const BWT* pBWT, const BWT* pRevBWT,
+                                  const AlignFlags& af, const BWTIntervalPair& ranges,
+                                  OverlapBlockList* pContainList, OverlapResult& result) const;
+
+        // Advance an exact search by one base. Returns false when the search is done
+        bool stepOverlapSearchExact(ExactSearch& search, int minOverlap) const;
+
+        // Remove the submaximal, contained and transitive blocks of the exact searches and
+        // move the remaining blocks to pOBOut
+        void finishOverlapExact(size_t readLength, ExactBlockLists& lists, OverlapBlockList* pOBOut) const;
+
         // Same as above while allowing mismatches
         bool findOverlapBlocksInexact(const std::string& w, const BWT* pBWT, const BWT* pRevBWT, 
                                       const AlignFlags& af, const int minOverlap, OverlapBlockList* pOBList, 
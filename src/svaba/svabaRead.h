@@ -42,6 +42,9 @@ class svabaRead : public SeqLib::BamRecord {
 
   std::string Seq() const;
 
+  /** The sequence set by SetSeq, without copying it. NULL if it was never set */
+  const char* SeqData() const { return seq.get(); }
+
   std::string Prefix() const;
 
   void SetSeq(const std::string& nseq);
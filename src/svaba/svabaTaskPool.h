@@ -0,0 +1,102 @@
+#ifndef SVABA_TASK_POOL_H__
+#define SVABA_TASK_POOL_H__
+
+#include <pthread.h>
+#include <list>
+#include <atomic>
+#include <functional>
+
+// shared pool of small tasks, so that a window too large for one thread can hand
+// parts of its work to the threads that have run out of windows. Each task writes
+// only its own slot of the caller's output, so results do not depend on which
+// thread ran which task
+class svabaTaskPool
+{
+
+  public:
+  // wake is called each time tasks are posted, so that threads waiting for 
+  // windows can come and help
+  svabaTaskPool(const std::function<void()>& wake = std::function<void()>()) : m_wake(wake) {
+    pthread_mutex_init(&m_mutex, NULL);
+    pthread_cond_init(&m_condv, NULL);
+  }
+
+  ~svabaTaskPool() {
+    pthread_mutex_destroy(&m_mutex);
+    pthread_cond_destroy(&m_condv);
+  }
+
+  // run fn(0) ... fn(n-1) and return when all are done. The calling thread runs
+  // tasks as well, so this finishes even if no other thread is free to help
+  void parallelFor(size_t n, const std::function<void(size_t)>& fn) {
+    if (n == 0)
+      return;
+    Job job(n, fn);
+    pthread_mutex_lock(&m_mutex);
+    m_jobs.push_back(&job);
+    m_open = m_jobs.size();
+    pthread_mutex_unlock(&m_mutex);
+    if (m_wake)
+      m_wake();
+    pthread_mutex_lock(&m_mutex);
+    while (job.next < job.n)
+      runTask(&job);
+    while (job.done < job.n)
+      pthread_cond_wait(&m_condv, &m_mutex);
+    pthread_mutex_unlock(&m_mutex);
+    m_tasks_helped += job.helped;
+  }
+
+  // true if some posted tasks have not been started yet
+  bool hasTasks() const { return m_open > 0; }
+
+  // called by a thread with no windows to run. Runs tasks posted by other
+  // threads until none are left to start
+  void help() {
+    pthread_mutex_lock(&m_mutex);
+    while (!m_jobs.empty()) {
+      Job* job = m_jobs.front();
+      ++job->helped;
+      runTask(job);
+    }
+    pthread_mutex_unlock(&m_mutex);
+  }
+
+  // number of tasks run by a thread other than the one that posted them
+  size_t helped() const { return m_tasks_helped; }
+
+  private:
+
+  struct Job {
+    Job(size_t nn, const std::function<void(size_t)>& f) : fn(f), n(nn) {}
+    const std::function<void(size_t)>& fn;
+    size_t n;
+    size_t next = 0; // next task to hand out
+    size_t done = 0;
+    size_t helped = 0;
+  };
+
+  // claim the next task of job and run it with the lock released. Call with the lock held
+  void runTask(Job* job) {
+    size_t i = job->next++;
+    if (job->next == job->n) {
+      m_jobs.remove(job);
+      m_open = m_jobs.size();
+    }
+    pthread_mutex_unlock(&m_mutex);
+    job->fn(i);
+    pthread_mutex_lock(&m_mutex);
+    if (++job->done == job->n)
+      pthread_cond_broadcast(&m_condv);
+  }
+
+  std::list<Job*> m_jobs; // jobs with tasks not yet started
+  std::atomic<size_t> m_open{0}; // size of m_jobs, readable without the lock
+  std::function<void()> m_wake;
+  std::atomic<size_t> m_tasks_helped{0};
+  pthread_mutex_t m_mutex;
+  pthread_cond_t  m_condv;
+
+};
+
+#endif
@@ -1,6 +1,8 @@
 #include "svabaUtils.h"
 
 #include <iomanip>
+#include <algorithm>
+#include <cmath>
 
 namespace svabaUtils {
 
@@ -322,4 +324,133 @@ double CalcMHWScore(std::vector<int>& scores)
     return al;
   }
 
+  // call f on each canonical 2-bit packed k-mer (k <= 32) of seq, skipping k-mers with an N. Stops if f returns true
+  template <typename F>
+  static bool __each_canonical_kmer(const std::string& seq, int k, F f) {
+
+    const uint64_t mask = k == 32 ? ~(uint64_t)0 : (((uint64_t)1 << (2 * k)) - 1);
+    const int shift = 2 * (k - 1);
+    uint64_t fwd = 0, rev = 0;
+    int len = 0;
+    for (auto& c : seq) {
+      uint64_t b;
+      switch (c) {
+      case 'A': case 'a': b = 0; break;
+      case 'C': case 'c': b = 1; break;
+      case 'G': case 'g': b = 2; break;
+      case 'T': case 't': b = 3; break;
+      default: len = 0; continue;
+      }
+      fwd = ((fwd << 2) | b) & mask;
+      rev = (rev >> 2) | ((3 - b) << shift);
+      if (++len >= k && f(std::min(fwd, rev)))
+	return true;
+    }
+    return false;
+  }
+
+  template <typename F>
+  bool KmerSketch::__each_kmer(const std::string& seq, F f) const {
+    return __each_canonical_kmer(seq, m_k, [&f](uint64_t k) { return f((uint32_t)k); });
+  }
+
+  void KmerSketch::add(const std::string& seq) {
+    __each_kmer(seq, [this](uint32_t k) { m_kmers.push_back(k); return false; });
+  }
+
+  void KmerSketch::finalize() {
+    std::sort(m_kmers.begin(), m_kmers.end());
+    m_kmers.erase(std::unique(m_kmers.begin(), m_kmers.end()), m_kmers.end());
+  }
+
+  bool KmerSketch::Shares(const std::string& seq) const {
+    return __each_kmer(seq, [this](uint32_t k) { return std::binary_search(m_kmers.begin(), m_kmers.end(), k); });
+  }
+
+  void NovelKmerCounter::addKnown(const std::string& seq) {
+    __each_canonical_kmer(seq, m_k, [this](uint64_t k) { m_known.push_back(k); return false; });
+  }
+
+  void NovelKmerCounter::finalize() {
+    std::sort(m_known.begin(), m_known.end());
+    m_known.erase(std::unique(m_known.begin(), m_known.end()), m_known.end());
+  }
+
+  size_t NovelKmerCounter::addRead(const std::string& seq) {
+    size_t start = m_novel.size();
+    __each_canonical_kmer(seq, m_k, [this](uint64_t k) {
+	if (!std::binary_search(m_known.begin(), m_known.end(), k))
+	  m_novel.push_back(k);
+	return false;
+      });
+    // a k-mer repeated within a read is support from one read only
+    std::sort(m_novel.begin() + start, m_novel.end());
+    m_novel.erase(std::unique(m_novel.begin() + start, m_novel.end()), m_novel.end());
+    return m_novel.size() - start;
+  }
+
+  size_t NovelKmerCounter::Supported(size_t min_reads) const {
+    std::vector<uint64_t> novel = m_novel;
+    std::sort(novel.begin(), novel.end());
+    size_t supported = 0;
+    for (size_t i = 0, j; i < novel.size(); i = j) {
+      for (j = i + 1; j < novel.size() && novel[j] == novel[i]; ++j) {}
+      if (j - i >= min_reads)
+	++supported;
+    }
+    return supported;
+  }
+
+  KmerBloomFilter::KmerBloomFilter(int k, size_t expected_kmers, int bits_per_kmer, int nhash) : m_k(k), m_nhash(nhash) {
+    m_nblocks = std::max((size_t)1, (expected_kmers * bits_per_kmer + 511) / 512);
+    m_bits.assign(m_nblocks * 8, 0);
+  }
+
+  // the block comes from the hash of the k-mer, and each bit within it from
+  // 9 more bits of a rehash. Double hashing inside a block correlates the
+  // probes and about doubles the false positive rate
+  #define BLOOM_BITS_PER_MIX 7
+
+  void KmerBloomFilter::add(const std::string& seq) {
+    __each_canonical_kmer(seq, m_k, [this](uint64_t km) {
+	uint64_t h = mix64(km), g = 0;
+	uint64_t * blk = &m_bits[(h % m_nblocks) * 8];
+	for (int i = 0; i < m_nhash; ++i, g >>= 9) {
+	  if (i % BLOOM_BITS_PER_MIX == 0)
+	    g = mix64(h + i + 1);
+	  blk[(g & 511) >> 6] |= (uint64_t)1 << (g & 63);
+	}
+	++m_added;
+	return false;
+      });
+  }
+
+  int KmerBloomFilter::Hits(const std::string& seq, int max_hits) const {
+    int hits = 0;
+    __each_canonical_kmer(seq, m_k, [&](uint64_t km) {
+	uint64_t h = mix64(km), g = 0;
+	const uint64_t * blk = &m_bits[(h % m_nblocks) * 8];
+	for (int i = 0; i < m_nhash; ++i, g >>= 9) {
+	  if (i % BLOOM_BITS_PER_MIX == 0)
+	    g = mix64(h + i + 1);
+	  if (!(blk[(g & 511) >> 6] & ((uint64_t)1 << (g & 63))))
+	    return false;
+	}
+	return ++hits >= max_hits;
+      });
+    return hits;
+  }
+
+  // a lookup lands in a random block, so average the per-block rates
+  double KmerBloomFilter::FalsePositiveRate() const {
+    double fp = 0;
+    for (size_t b = 0; b < m_nblocks; ++b) {
+      int set = 0;
+      for (size_t w = b * 8; w < b * 8 + 8; ++w)
+	set += __builtin_popcountll(m_bits[w]);
+      fp += std::pow(set / 512.0, m_nhash);
+    }
+    return fp / m_nblocks;
+  }
+
 }
@@ -5,6 +5,8 @@
 #include <sstream>
 #include <unordered_map>
 #include <map>
+#include <vector>
+#include <stdint.h>
 
 #include "SeqLib/BamReader.h"
 #include "SeqLib/BamWriter.h"
@@ -67,6 +69,119 @@ struct svabaTimer {
    * @return Random integer bounded on [0,cs.size())
    */
   int weightedRandom(const std::vector<double>& cs);
+
+  /** Mix the bits of a 64-bit value (splitmix64 finalizer). Hashes saved to 
+   * disk are built on this, so it must not change
+   */
+  inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27; x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+  }
+
+  /** FNV-1a hash of a string, so hashes saved to disk don't depend on the std library */
+  inline uint64_t fnv1a(const std::string& s) {
+    uint64_t h = 14695981039346656037ULL;
+    for (auto& c : s) { h ^= (unsigned char)c; h *= 1099511628211ULL; }
+    return h;
+  }
+
+  /** Set of the canonical k-mers (k <= 16) of some sequences, e.g. the
+   * contigs of a window, to test quickly whether a read shares any
+   * sequence with them before aligning it.
+   */
+  class KmerSketch {
+
+  public:
+
+    KmerSketch(int k) : m_k(k) {}
+
+    void add(const std::string& seq);
+
+    // sort the k-mers. Call after the last add and before Shares
+    void finalize();
+
+    /** Does seq share a k-mer (either strand) with the added sequences? */
+    bool Shares(const std::string& seq) const;
+
+    size_t size() const { return m_kmers.size(); }
+
+  private:
+
+    template <typename F>
+    bool __each_kmer(const std::string& seq, F f) const;
+
+    int m_k;
+
+    std::vector<uint32_t> m_kmers; // 2-bit packed canonical k-mers
+
+  };
+
+  /** Bloom filter of the canonical k-mers of a reference, with all of the bits
+   * for one k-mer in the same 512-bit block so a lookup touches one cache line.
+   * Used to skip aligning contigs that cannot seed against the reference.
+   */
+  class KmerBloomFilter {
+
+  public:
+
+    /** Size for expected_kmers k-mers (k <= 32) at bits_per_kmer bits each, set with nhash hashes */
+    KmerBloomFilter(int k, size_t expected_kmers, int bits_per_kmer, int nhash);
+
+    void add(const std::string& seq);
+
+    /** Number of k-mers of seq (either strand) in the filter, counting up to max_hits */
+    int Hits(const std::string& seq, int max_hits) const;
+
+    /** Expected false positive rate per k-mer lookup, from the fraction of bits set */
+    double FalsePositiveRate() const;
+
+    size_t Bytes() const { return m_bits.size() * sizeof(uint64_t); }
+
+    size_t NumAdded() const { return m_added; }
+
+  private:
+
+    int m_k;
+    int m_nhash;
+    size_t m_nblocks;
+    size_t m_added = 0;
+
+    std::vector<uint64_t> m_bits; // m_nblocks blocks of 8 words
+
+  };
+
+  /** Counts the k-mers (k <= 32) of reads that are not in some known sequence,
+   * e.g. the reference of a window, to tell the windows whose reads carry novel
+   * sequence from those whose reads only repeat the reference.
+   */
+  class NovelKmerCounter {
+
+  public:
+
+    NovelKmerCounter(int k) : m_k(k) {}
+
+    void addKnown(const std::string& seq);
+
+    // sort the known k-mers. Call after the last addKnown and before addRead
+    void finalize();
+
+    /** Collect the novel k-mers of a read, once each. Returns the number collected */
+    size_t addRead(const std::string& seq);
+
+    /** Number of distinct novel k-mers carried by at least min_reads of the reads */
+    size_t Supported(size_t min_reads) const;
+
+  private:
+
+    int m_k;
+
+    std::vector<uint64_t> m_known; // 2-bit packed canonical k-mers
+
+    std::vector<uint64_t> m_novel; // novel k-mers of the reads, once per read
+
+  };
   
 }
 
@@ -38,9 +38,33 @@
 // (if not assocaited with assembly contig)
 #define MIN_DSCRD_READS_DSCRD_ONLY 3 
 
+// k-mer size for skipping reads that share no sequence with any contig before read-to-contig alignment
+#define ALIGN_PREFILTER_K 15
+
+// assemblies to keep in memory for reuse by later windows, when not saving them with --assembly-cache
+#define ASSEMBLY_CACHE_MAX_ENTRIES 20000
+
+// Bloom filter of microbe k-mers, checked before aligning a contig to the microbe genomes.
+// k is the BWA-MEM minimum seed length, so a contig with no hits can't seed there
+#define MICROBE_BLOOM_K 19
+#define MICROBE_BLOOM_BITS_PER_KMER 20
+#define MICROBE_BLOOM_HASHES 8
+#define MICROBE_BLOOM_MIN_HITS 1 // one exact k-mer is enough for BWA-MEM to seed, so more would lose alignments
+#define MICROBE_BLOOM_MAX_MB 2048 // skip the prescreen for microbe references that would need a larger filter
+
 // moved from svabaAssemblerEngine
 //////////////////////////////////
 #define MAX_OVERLAPS_PER_ASSEMBLY 20000
+#define OVERLAP_BATCH_READS 32 // reads whose index searches are interleaved by svabaOverlapAlgorithm::overlapReads
+#define PARALLEL_WINDOW_MIN_READS 4000 // windows with at least this many reads share their overlaps and contig alignments with idle threads
+
+// --kmer-triage: a window is assembled only if its reads carry TRIAGE_MIN_NOVEL_KMERS k-mers
+// that are not in the reference (padded by TRIAGE_REF_PAD, for reads hanging off the window),
+// each in TRIAGE_MIN_KMER_READS reads so that lone sequencing errors don't count
+#define TRIAGE_K 25
+#define TRIAGE_REF_PAD 1000
+#define TRIAGE_MIN_KMER_READS 2
+#define TRIAGE_MIN_NOVEL_KMERS 1
 
 #define MIN_CONTIG_MATCH 35
 #define MATE_LOOKUP_MIN 3
@@ -51,11 +75,22 @@
 
 #define GERMLINE_CNV_PAD 10
 #define WINDOW_PAD 500
+#define WINDOW_REUSE_PAD (WINDOW_PAD + 50) // windows are tiled to overlap by WINDOW_PAD. Keep a little extra
 #define MICROBE_MATCH_MIN 50
 #define GET_MATES 1
 #define MICROBE 1
 #define LARGE_INTRA_LOOKUP_LIMIT 50000
 #define SECONDARY_FRAC 0.90
+#define SUBWINDOW_MIN_WIDTH 2500 // don't split windows into pieces smaller than this
+#define SUBWINDOW_MAX_DEPTH 4 // max times a window can be split in half
+#define SUBWINDOW_HARD_LIMIT_FACTOR 4 // raise the read limit by this for sub-windows that can't be split more
+
+// LocalRefAligner
+//////////////////
+#define LOCAL_ALIGN_K 15 // k-mer size for anchoring contigs to the window
+#define LOCAL_ALIGN_BAND 100 // half-width of the alignment band around the anchor diagonal
+#define LOCAL_ALIGN_MAX_OCC 16 // ignore k-mers seen more often than this in the window
+#define LOCAL_ALIGN_MIN_SCORE 30 // same as the BWA-MEM minimum output score
 
 // moved from svabaBamWalker
 ////////////////////////////
@@ -66,6 +101,27 @@
 #define DISC_REALIGN_MATE_PAD 100
 #define MAX_SECONDARY_HIT_DISC 10
 #define MATE_REGION_PAD 250
+#define INDEL_CIGAR_MAP_MIN_SLOTS 1024 // first table size of the per-sample indel CIGAR counts
+
+// MateFetchService
+///////////////////
+// most records to read from one merged mate region (bounds memory in pileups).
+// Requested regions cut short are dropped and marked as bad mate regions
+#define MATE_FETCH_MAX_RECORDS 500000
+
+// refilter
+///////////
+#define REFILTER_BATCH_SIZE 4096 // bps.txt.gz lines per batch sent to a worker
+
+// BreakPointStore
+//////////////////
+#define BPSTORE_BLOCK_SIZE 4096 // breakpoints per compressed block
+
+// PONFilter
+////////////
+#define PON_INDEX_LOAD 0.99 // keys per slot in the PON index
+#define PON_INDEX_BUCKET_SIZE 4 // average keys per displacement bucket
+#define PON_BENCH_KEYS 2000000 // lookups timed by index-pon --bench
 
 // trim this many bases from front and back of read when determining coverage
 // this should be synced with the split-read buffer in BreakPoint2 for more accurate 
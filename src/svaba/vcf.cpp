@@ -16,6 +16,7 @@
 #include "SeqLib/GenomicRegionCollection.h"
 
 #include "svaba_params.h"
+#include "BreakPointStore.h"
 
 using namespace std;
 
@@ -173,7 +174,7 @@ std::ostream& operator<<(std::ostream& out, const VCFEntry& v) {
   out << be->chr_name << sep  
       << be->gr.pos1 << sep << v.getIdString() << sep << v.getRefString() << sep << v.getAltString() << sep 
       << v.bp->quality << sep
-      << v.bp->confidence << sep << info << sep 
+      << ConfidenceString(v.bp->confidence) << sep << info << sep 
       << (v.bp->indel ? indel_format : sv_format); // << sep << samps.first << sep << samps.second;
   for (auto& i : v.bp->format_s)
     out << sep << i;
@@ -313,47 +314,38 @@ VCFFile::VCFFile(std::string file, std::string id, const SeqLib::BamHeader& h, c
   
   include_nonpass = nopass;
 
-  // read it in line by line
-  getline(infile, line, '\n'); // skip first line
   size_t line_count = 0;
-  while (getline(infile, line, '\n')) {
 
-    if (line.find("mapq") != std::string::npos)
-      continue;
-
-    if (line.find("Unknown") != std::string::npos)
-      continue;
-
-    // parse the breakpoint from the file
-    std::shared_ptr<ReducedBreakPoint> bp(new ReducedBreakPoint(line, h));
-
-    // add the VCFentry Pair
-    ++line_count;
-    std::shared_ptr<VCFEntryPair> vpair(new VCFEntryPair(bp));
+  // read the binary breakpoint store directly, without going through text
+  if (IsBreakPointStore(file)) {
+    BreakPointReader reader;
+    if (!reader.Open(file)) {
+      cerr << "Can't read breakpoint store " << file << " for parsing VCF" << endl;
+      exit(EXIT_FAILURE);
+    }
+    BreakPoint b;
+    while (reader.Next(b, h)) {
+      if (b.b1.chr_name == "Unknown" || b.b2.chr_name == "Unknown")
+	continue;
+      std::shared_ptr<ReducedBreakPoint> bp(new ReducedBreakPoint(b));
+      __add_breakpoint(bp, ++line_count);
+    }
+  } else {
+    // read it in line by line
+    getline(infile, line, '\n'); // skip first line
+    while (getline(infile, line, '\n')) {
 
-    // skip non pass if not emitting unfiltered
-    if (!include_nonpass && !bp->pass)
-      continue;
+      if (line.find("mapq") != std::string::npos)
+	continue;
 
-    ++cname_count[std::string(bp->cname)];
-    if (cname_count[std::string(bp->cname)] >= VCF_SECONDARY_CAP)
-      {
-	//delete bp;
-	//delete vpair;
+      if (line.find("Unknown") != std::string::npos)
 	continue;
-      }
-    
-    // remove BX tags for unfiltered
-    if (!bp->pass)
-      bp->bxtable = "x";
 
-    if (bp->indel) {
-      indels.insert(pair<int, std::shared_ptr<VCFEntryPair>>(line_count, vpair));
-    }
-    else  {
-      entry_pairs.insert(pair<int, std::shared_ptr<VCFEntryPair>>(line_count, vpair));
+      // parse the breakpoint from the file
+      std::shared_ptr<ReducedBreakPoint> bp(new ReducedBreakPoint(line, h));
+      __add_breakpoint(bp, ++line_count);
+
     }
-   
   }
   
   cname_count.clear();
@@ -366,6 +358,36 @@ VCFFile::VCFFile(std::string file, std::string id, const SeqLib::BamHeader& h, c
   
 }
 
+void VCFFile::__add_breakpoint(std::shared_ptr<ReducedBreakPoint>& bp, size_t line_count) {
+
+  // add the VCFentry Pair
+  std::shared_ptr<VCFEntryPair> vpair(new VCFEntryPair(bp));
+
+  // skip non pass if not emitting unfiltered
+  if (!include_nonpass && !bp->pass)
+    return;
+
+  ++cname_count[std::string(bp->cname)];
+  if (cname_count[std::string(bp->cname)] >= VCF_SECONDARY_CAP)
+    {
+      //delete bp;
+      //delete vpair;
+      return;
+    }
+  
+  // remove BX tags for unfiltered
+  if (!bp->pass)
+    bp->bxtable = "x";
+
+  if (bp->indel) {
+    indels.insert(pair<int, std::shared_ptr<VCFEntryPair>>(line_count, vpair));
+  }
+  else  {
+    entry_pairs.insert(pair<int, std::shared_ptr<VCFEntryPair>>(line_count, vpair));
+  }
+   
+}
+
 // make a class to hold break end + id
 class GenomicRegionWithID : public SeqLib::GenomicRegion 
 {
@@ -439,8 +461,8 @@ void VCFFile::deduplicate() {
       if (j.second.first && j.second.second) { // left and right hit for this key
  	if (*i.second->bp < *entry_pairs[j.first]->bp) { // this has worst read coverage that what it overlaps, so mark as dup. If tie, take left-most break
 	  // check that its not a local clashing with a global, because they're supposed to be two annotations for one event
-	  if ( (!strcmp(i.second->bp->evidence, "TSI_L") && !strcmp(entry_pairs[j.first]->bp->evidence, "TSI_G")) || // strcmp of 0 is match 
-	       (!strcmp(i.second->bp->evidence, "TSI_G") && !strcmp(entry_pairs[j.first]->bp->evidence, "TSI_L")) ) 
+	  if ( (i.second->bp->evidence == EVDNC_TSI_L && entry_pairs[j.first]->bp->evidence == EVDNC_TSI_G) ||
+	       (i.second->bp->evidence == EVDNC_TSI_G && entry_pairs[j.first]->bp->evidence == EVDNC_TSI_L) ) 
 	    ; // don't add as a duplicate
 	  else {
 	    dups.insert(j.first); 
@@ -771,7 +793,7 @@ std::unordered_map<std::string, std::string> VCFEntry::fillInfoFields() const {
   info_fields["SPAN"] = std::to_string(bp->getSpan());
   info_fields["SCTG"] = bp->cname;
   if (!bp->indel) {
-    info_fields["EVDNC"] = bp->evidence;
+    info_fields["EVDNC"] = EvidenceString(bp->evidence);
     info_fields["SVTYPE"] = "BND";
   }
 
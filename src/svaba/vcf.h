@@ -159,6 +159,9 @@ struct VCFFile {
   //
   void writeIndels(std::string basename, bool zip, bool onefile) const;
   void writeSVs(std::string basename, bool zip, bool onefile) const;
+
+  // add a breakpoint read from the breakpoints file
+  void __add_breakpoint(std::shared_ptr<ReducedBreakPoint>& bp, size_t line_count);
   
 
 };
@@ -3,8 +3,11 @@
 
 #include <pthread.h>
 #include <list>
+#include <vector>
+#include <iterator>
 
 #include "svabaThreadUnit.h"
+#include "svabaTaskPool.h"
 #include "SeqLib/RefGenome.h"
 
 typedef std::map<std::string, svabaBamWalker> WalkerMap;
@@ -30,25 +33,105 @@ template <typename T> class wqueue
     pthread_mutex_unlock(&m_mutex);
   }
 
-  T remove() {
+  // split the queued items into one contiguous run per thread, so that each
+  // thread works through neighboring windows. Call after all items are added
+  void partition(int nruns) {
     pthread_mutex_lock(&m_mutex);
-    while (m_queue.size() == 0) {
-      pthread_cond_wait(&m_condv, &m_mutex);
+    m_runs.assign(nruns, std::list<T>());
+    size_t n = m_queue.size();
+    for (int i = 0; i < nruns; ++i) {
+      typename std::list<T>::iterator it = m_queue.begin();
+      std::advance(it, n / nruns + ((size_t)i < n % nruns ? 1 : 0));
+      m_runs[i].splice(m_runs[i].end(), m_queue, m_queue.begin(), it);
+    }
+    pthread_mutex_unlock(&m_mutex);
+  }
+
+  // remove the next item from this thread's run (or the shared queue if run is -1). 
+  // If nothing can be taken but items are still being processed, wait, as they may 
+  // add more (eg sub-windows), and meanwhile run the tasks they post to pool. 
+  // Returns a default (null) item once nothing is queued or being processed. 
+  // Call done() after processing each item
+  T remove(int run = -1, svabaTaskPool* pool = nullptr) {
+    pthread_mutex_lock(&m_mutex);
+    T item = T();
+    while (!take(run, item) && m_in_flight > 0) {
+      if (pool && pool->hasTasks()) {
+	pthread_mutex_unlock(&m_mutex);
+	pool->help();
+	pthread_mutex_lock(&m_mutex);
+      } else {
+	pthread_cond_wait(&m_condv, &m_mutex);
+      }
     }
-    T item = m_queue.front();
-    m_queue.pop_front();
     pthread_mutex_unlock(&m_mutex);
     return item;
   }
 
+  // mark an item from remove as processed
+  void done() {
+    pthread_mutex_lock(&m_mutex);
+    if (--m_in_flight == 0)
+      pthread_cond_broadcast(&m_condv);
+    pthread_mutex_unlock(&m_mutex);
+  }
+
+  // wake the threads waiting in remove, eg to help with posted tasks
+  void wake() {
+    pthread_mutex_lock(&m_mutex);
+    pthread_cond_broadcast(&m_condv);
+    pthread_mutex_unlock(&m_mutex);
+  }
+
   int size() {
     pthread_mutex_lock(&m_mutex);
     int size = m_queue.size();
+    for (auto& r : m_runs)
+      size += r.size();
     pthread_mutex_unlock(&m_mutex);
     return size;
   }
 
+  // number of times a thread took over part of another thread's run
+  size_t steals() const { return m_steals; }
+
+  // take the next item for run, if there is one: from the run itself, else any 
+  // item added since partitioning, else the back half of the longest run left
+  // (the part farthest from where its owner is working). Call with the lock held
+  bool take(int run, T& item) {
+    if (run < 0 || m_runs.empty()) {
+      if (m_queue.empty())
+	return false;
+      item = m_queue.front();
+      m_queue.pop_front();
+      ++m_in_flight;
+      return true;
+    }
+    std::list<T>& mine = m_runs[run];
+    if (mine.empty() && m_queue.size()) {
+      mine.splice(mine.end(), m_queue, m_queue.begin());
+    } else if (mine.empty()) {
+      size_t victim = 0;
+      for (size_t i = 1; i < m_runs.size(); ++i)
+	if (m_runs[i].size() > m_runs[victim].size())
+	  victim = i;
+      if (m_runs[victim].empty())
+	return false;
+      typename std::list<T>::iterator it = m_runs[victim].end();
+      std::advance(it, -(int)((m_runs[victim].size() + 1) / 2));
+      mine.splice(mine.end(), m_runs[victim], it, m_runs[victim].end());
+      ++m_steals;
+    }
+    item = mine.front();
+    mine.pop_front();
+    ++m_in_flight;
+    return true;
+  }
+
   std::list<T>   m_queue;
+  std::vector<std::list<T> > m_runs;
+  size_t m_steals = 0;
+  size_t m_in_flight = 0; // items removed but not yet done
   pthread_mutex_t m_mutex;
   pthread_cond_t  m_condv;
 
@@ -126,7 +209,8 @@ public:
 
  ConsumerThread(wqueue<T*>& queue, bool verbose, 
 		const std::string& ref, const std::string& vir,
-		const std::map<std::string, std::string>& bams) : m_queue(queue), m_verbose(verbose) {
+		const std::map<std::string, std::string>& bams, int run = -1, 
+		svabaTaskPool* pool = nullptr) : m_queue(queue), m_verbose(verbose), m_run(run), m_pool(pool) {
 
     // load the reference genomce
     if (m_verbose)
@@ -155,17 +239,16 @@ public:
   }
  
   void* run() {
-    // Remove 1 item at a time and process it. Blocks if no items are 
-    // available to process.
-    for (int i = 0;; i++) {
-      //if (m_verbose)
-	//printf("thread %lu, loop %d - waiting for item...\n", 
-	//     (long unsigned int)self(), i);
-      T* item = (T*)m_queue.remove();
+    // Remove 1 item at a time and process it. Blocks while there is nothing to
+    // take but other threads are still running windows, helping with their tasks
+    for (;;) {
+      // take from this thread's own run of windows if the queue was partitioned
+      T* item = m_queue.remove(m_run, m_pool);
+      if (!item)
+	break;
       item->run(wu, (long unsigned)self()); 
       delete item;
-      if (m_queue.size() == 0)
-        return NULL;
+      m_queue.done();
     }
     return NULL;
   }
@@ -175,6 +258,8 @@ public:
  private: 
   wqueue<T*>& m_queue;
   bool m_verbose;
+  int m_run; // index of this thread's run in the queue, or -1 for first-come
+  svabaTaskPool* m_pool; // tasks to help with while waiting for windows, or null
 
 };
 